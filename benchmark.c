@@ -0,0 +1,877 @@
+// Benchmarks for loading and rendering WaveFront Object Files using this library
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "fsim/memory.h"
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include "fsim/object.h"
+#include "fsim/parser.h"
+#include "fsim/number.h"
+#include "fsim/cache.h"
+#include "fsim/decompress.h"
+#include "fsim/program.h"
+#include "fsim/vertex_array_object.h"
+#include "fsim/material_library.h"
+#include "fsim/texture_cache.h"
+#include "fsim/accounting.h"
+#include "fsim/vertex_cache.h"
+#include "fsim/vertex_fetch.h"
+#include "fsim/overdraw.h"
+#include "fsim/vertex_format.h"
+
+
+static double elapsed(struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
+
+// Loading textures requires an OpenGL context.
+static void setup_gl(void)
+{
+  int argc = 0;
+  glutInit(&argc, NULL);
+  glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
+  glutCreateWindow("benchmark");
+  glutHideWindow();
+  glewExperimental = GL_TRUE;
+  glewInit();
+}
+
+static double time_parse_file(const char *file_name)
+{
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  object_t *object = parse_file(file_name);
+  double result = elapsed(&start);
+  if (!object) {
+    fprintf(stderr, "Error reading object file %s\n", file_name);
+    return -1;
+  };
+  return result;
+}
+
+static int benchmark_parse(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark parse <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  set_parser_backend(PARSER_FLEX);
+  double flex = time_parse_file(argv[0]);
+  set_parser_backend(PARSER_MMAP);
+  double mmap = time_parse_file(argv[0]);
+  if (flex < 0 || mmap < 0)
+    return 1;
+  printf("flex/bison: %8.3f s\n", flex);
+  printf("mmap      : %8.3f s (%.1fx)\n", mmap, flex / mmap);
+  return 0;
+}
+
+static int next_thread_count(int n_threads, int max_threads)
+{
+  if (n_threads == max_threads)
+    return max_threads + 1;
+  return 2 * n_threads < max_threads ? 2 * n_threads : max_threads;
+}
+
+static int benchmark_threads(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark threads <object file> [maximum number of threads]\n");
+    return 1;
+  };
+  setup_gl();
+  int max_threads = argc >= 2 ? atoi(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+  set_parser_backend(PARSER_MMAP);
+  double reference = 0;
+  int n_threads;
+  for (n_threads=1; n_threads<=max_threads; n_threads=next_thread_count(n_threads, max_threads)) {
+    set_parser_threads(n_threads);
+    double seconds = time_parse_file(argv[0]);
+    if (seconds < 0)
+      return 1;
+    if (n_threads == 1)
+      reference = seconds;
+    printf("%3d threads: %8.3f s (%.1fx)\n", n_threads, seconds, reference / seconds);
+  };
+  set_parser_threads(1);
+  return 0;
+}
+
+// Measure in a separate process so that the peak resident set size is not affected by the other runs.
+static int measure_prescan(const char *file_name, int prescan)
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    set_parser_prescan(prescan);
+    size_t allocated = GC_get_total_bytes();
+    size_t collections = GC_get_gc_no();
+    double seconds = time_parse_file(file_name);
+    if (seconds < 0)
+      exit(1);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-11s: %8.3f s, %8.1f MB allocated, %4d collections, %8.1f MB peak RSS\n",
+           prescan ? "prescan" : "no prescan", seconds, (GC_get_total_bytes() - allocated) / 1048576.0,
+           (int)(GC_get_gc_no() - collections), usage.ru_maxrss / 1024.0);
+    exit(0);
+  };
+  int status;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static int benchmark_prescan(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark prescan <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  set_parser_backend(PARSER_MMAP);
+  return measure_prescan(argv[0], 0) || measure_prescan(argv[0], 1);
+}
+
+static struct timespec stream_start;
+static double first_group;
+
+static void time_first_group(group_t *group, void *data)
+{
+  if (first_group < 0)
+    first_group = elapsed(&stream_start);
+}
+
+static int benchmark_stream(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark stream <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  first_group = -1;
+  clock_gettime(CLOCK_MONOTONIC, &stream_start);
+  object_t *object = parse_file_stream(argv[0], time_first_group, NULL);
+  double complete = elapsed(&stream_start);
+  if (!object) {
+    fprintf(stderr, "Error reading object file %s\n", argv[0]);
+    return 1;
+  };
+  printf("first group: %8.3f s\n", first_group);
+  printf("complete   : %8.3f s\n", complete);
+  return 0;
+}
+
+static int benchmark_cache(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark cache <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  unlink(object_cache_file_name(argv[0]));
+  set_parser_cache(1);
+  double cold = time_parse_file(argv[0]);
+  double warm = time_parse_file(argv[0]);
+  set_parser_cache(0);
+  if (cold < 0 || warm < 0)
+    return 1;
+  printf("cold: %8.3f s\n", cold);
+  printf("warm: %8.3f s (%.1fx)\n", warm, cold / warm);
+  return 0;
+}
+
+static char *make_numbers(int count)
+{
+  char *result = GC_MALLOC_ATOMIC(count * 16 + 1);
+  char *p = result;
+  int i;
+  for (i=0; i<count; i++)
+    p += sprintf(p, "%.6f ", (rand() - RAND_MAX / 2) * (100.0 / RAND_MAX));
+  return result;
+}
+
+static int benchmark_numbers(int argc, char **argv)
+{
+  int count = argc >= 1 ? atoi(argv[0]) : 1000000;
+  char *text = make_numbers(count);
+  char *end = text + strlen(text);
+  struct timespec start;
+  float libc_sum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  char *p;
+  for (p=text; p<end; p++) {
+    float value = strtod(p, &p);
+    libc_sum += value;
+  };
+  double libc = elapsed(&start);
+  float fast_sum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  const char *q;
+  for (q=text; q<end; q++) {
+    float value;
+    q = parse_float(q, end, &value);
+    fast_sum += value;
+  };
+  double fast = elapsed(&start);
+  if (libc_sum != fast_sum) {
+    fprintf(stderr, "Results of strtod and parse_float differ\n");
+    return 1;
+  };
+  printf("strtod     : %8.2f ns/value\n", 1e9 * libc / count);
+  printf("parse_float: %8.2f ns/value (%.1fx)\n", 1e9 * fast / count, libc / fast);
+  return 0;
+}
+
+// Time reading the whole file through the decompressor. Returns -1 if the file could not be read.
+static double time_decompress(const char *file_name, long *size)
+{
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  *size = 0;
+  decompressor_t *decompressor = open_decompressor(file_name);
+  if (!decompressor)
+    return -1;
+  const char *block;
+  size_t block_size;
+  while ((block = next_block(decompressor, &block_size)))
+    *size += block_size;
+  int error = decompressor_error(decompressor);
+  close_decompressor(decompressor);
+  return error ? -1 : elapsed(&start);
+}
+
+static int benchmark_compressed(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark compressed <object file> [<compressed object file> ...]\n");
+    return 1;
+  };
+  setup_gl();
+  int i;
+  for (i=0; i<argc; i++) {
+    long size;
+    double decompress = time_decompress(argv[i], &size);
+    double parse = time_parse_file(argv[i]);
+    if (decompress < 0 || parse < 0)
+      return 1;
+    printf("%s: read %8.1f MB/s, parse %8.3f s (%6.1f MB/s)\n", argv[i], 1e-6 * size / decompress, parse,
+           1e-6 * size / parse);
+  };
+  return 0;
+}
+
+static double time_parse_file_groups(const char *file_name, const char **names)
+{
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  object_t *object = parse_file_groups(file_name, names);
+  double result = elapsed(&start);
+  if (!object) {
+    fprintf(stderr, "Error reading object file %s\n", file_name);
+    return -1;
+  };
+  return result;
+}
+
+static int benchmark_groups(int argc, char **argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "Syntax: benchmark groups <object file> <group> [<group> ...]\n");
+    return 1;
+  };
+  setup_gl();
+  const char **names = GC_MALLOC(argc * sizeof(const char *));
+  memcpy(names, argv + 1, (argc - 1) * sizeof(const char *));
+  names[argc - 1] = NULL;
+  unlink(group_index_file_name(argv[0]));
+  double all = time_parse_file(argv[0]);
+  double indexing = time_parse_file_groups(argv[0], names);
+  double selected = time_parse_file_groups(argv[0], names);
+  if (all < 0 || indexing < 0 || selected < 0)
+    return 1;
+  printf("all groups          : %8.3f s\n", all);
+  printf("selected, new index : %8.3f s\n", indexing);
+  printf("selected            : %8.3f s (%.1fx)\n", selected, all / selected);
+  return 0;
+}
+
+// Face corners referencing each of the unique index triples six times on average.
+static int *make_corners(int n_unique, int n_corners)
+{
+  int *result = GC_MALLOC_ATOMIC(3 * n_corners * sizeof(int));
+  int i;
+  for (i=0; i<n_corners; i++) {
+    int vertex = rand() % n_unique;
+    result[3 * i] = vertex + 1;
+    result[3 * i + 1] = vertex / 2 + 1;
+    result[3 * i + 2] = vertex % 3 + 1;
+  };
+  return result;
+}
+
+// Previous implementation formatting each triple as a string key for the fixed-size table of hsearch_r.
+// Lookups stop when the table is full. The number of processed corners is returned in n_corners.
+static double time_string_keys(int *corner, int *n_corners)
+{
+  struct hsearch_data table;
+  memset(&table, 0, sizeof(table));
+  hcreate_r(65536, &table);
+  char **keys = GC_MALLOC(*n_corners * sizeof(char *));
+  int n_vertices = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int i;
+  for (i=0; i<*n_corners; i++) {
+    keys[i] = GC_MALLOC_ATOMIC(30);
+    snprintf(keys[i], 30, "%d,%d,%d", corner[3 * i], corner[3 * i + 1], corner[3 * i + 2]);
+    ENTRY item = {keys[i], (void *)(long)n_vertices};
+    ENTRY *result;
+    if (!hsearch_r(item, ENTER, &result, &table))
+      break;
+    if ((long)result->data == n_vertices)
+      n_vertices++;
+  };
+  *n_corners = i;
+  double result = elapsed(&start);
+  hdestroy_r(&table);
+  return result;
+}
+
+static double time_index_hash(int *corner, int n_corners)
+{
+  index_hash_t *hash = make_index_hash();
+  int n_vertices = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int i;
+  for (i=0; i<n_corners; i++)
+    if (hash_find_index(hash, corner[3 * i], corner[3 * i + 1], corner[3 * i + 2], n_vertices) == n_vertices)
+      n_vertices++;
+  return elapsed(&start);
+}
+
+static int benchmark_dedup(int argc, char **argv)
+{
+  int sizes[] = {10000, 65536, 250000, 1000000};
+  int n_sizes = argc ? argc : 4;
+  int i;
+  for (i=0; i<n_sizes; i++) {
+    int n_unique = argc ? atoi(argv[i]) : sizes[i];
+    if (n_unique <= 0) {
+      fprintf(stderr, "Syntax: benchmark dedup [<unique vertices> ...]\n");
+      return 1;
+    };
+    int n_corners = 6 * n_unique;
+    int *corner = make_corners(n_unique, n_corners);
+    int n_string_corners = n_corners;
+    double strings = time_string_keys(corner, &n_string_corners);
+    double hash = time_index_hash(corner, n_corners);
+    printf("%8d unique: string keys %7.2f M/s", n_unique, 1e-6 * n_string_corners / strings);
+    if (n_string_corners < n_corners)
+      printf(" (table full after %d of %d corners)", n_string_corners, n_corners);
+    printf(", index hash %7.2f M/s\n", 1e-6 * n_corners / hash);
+  };
+  return 0;
+}
+
+static void report_vertex_data(const char *label, object_t *object)
+{
+  long bytes = 0;
+  int n_buffers = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (!group->pool) {
+      bytes += group->array->size * sizeof(GLfloat);
+      n_buffers++;
+    };
+  };
+  for (i=0; i<object->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    bytes += pool->array->size * sizeof(GLfloat);
+    n_buffers++;
+  };
+  printf("%-15s: %8.1f MB vertex data, %6d vertex buffers\n", label, bytes / 1048576.0, n_buffers);
+}
+
+static int benchmark_pool(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark pool <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  object_t *object = parse_file(argv[0]);
+  set_parser_shared_vertices(1);
+  object_t *shared = parse_file(argv[0]);
+  set_parser_shared_vertices(0);
+  if (!object || !shared) {
+    fprintf(stderr, "Error reading object file %s\n", argv[0]);
+    return 1;
+  };
+  report_vertex_data("per group", object);
+  report_vertex_data("shared pool", shared);
+  return 0;
+}
+
+static double resident_megabytes(void)
+{
+  long pages = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%*ld %ld", &pages) != 1)
+      pages = 0;
+    fclose(f);
+  };
+  return pages * (sysconf(_SC_PAGESIZE) / 1048576.0);
+}
+
+// Vertex data and indices kept in main memory.
+static double geometry_megabytes(object_t *object)
+{
+  int64_t bytes = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    bytes += group->array->buffer_size + group->vertex_index->buffer_size;
+  };
+  for (i=0; i<object->pool->size; i++)
+    bytes += ((vertex_pool_t *)get_pointer(object->pool)[i])->array->buffer_size;
+  return bytes / 1048576.0;
+}
+
+static const char *upload_modes[] = {"keep", "compact", "release", NULL};
+
+static int benchmark_upload(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark upload <object file> [keep|compact|release]\n");
+    return 1;
+  };
+  int mode = 0;
+  while (argc >= 2 && upload_modes[mode] && strcmp(argv[1], upload_modes[mode]))
+    mode++;
+  if (!upload_modes[mode]) {
+    fprintf(stderr, "Unknown upload mode %s\n", argv[1]);
+    return 1;
+  };
+  setup_gl();
+  program_t *program = make_program("vertex.glsl", "fragment.glsl");
+  object_t *object = parse_file(argv[0]);
+  if (!program || !object) {
+    fprintf(stderr, "Error reading object file %s\n", argv[0]);
+    return 1;
+  };
+  GC_gcollect();
+  printf("%-7s: parsed   %8.1f MB resident, %8.1f MB geometry\n", upload_modes[mode], resident_megabytes(),
+         geometry_megabytes(object));
+  set_upload_mode(mode);
+  list_t *list = make_vertex_array_object_list(program, object);
+  glFinish();
+  GC_gcollect();
+  printf("%-7s: uploaded %8.1f MB resident, %8.1f MB geometry, %8.1f MB buffers, %d vertex array objects\n",
+         upload_modes[mode], resident_megabytes(), geometry_megabytes(object),
+         memory_usage(MEMORY_GL_BUFFER).bytes / 1048576.0, (int)list->size);
+  return 0;
+}
+
+// Load several objects sharing material libraries with and without the material library cache.
+static int benchmark_library(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark library <object file> ...\n");
+    return 1;
+  };
+  setup_gl();
+  int cached;
+  for (cached=0; cached<=1; cached++) {
+    set_material_library_cache(cached);
+    int64_t texture_bytes = memory_usage(MEMORY_GL_TEXTURE).allocated_bytes;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int i;
+    for (i=0; i<argc; i++)
+      if (!parse_file(argv[i])) {
+        fprintf(stderr, "Error reading object file %s\n", argv[i]);
+        return 1;
+      };
+    printf("%-8s: %d objects in %6.3f s, %7.2f MB of textures uploaded, %d library hits\n",
+           cached ? "cached" : "uncached", argc, elapsed(&start),
+           (memory_usage(MEMORY_GL_TEXTURE).allocated_bytes - texture_bytes) / 1048576.0, (int)material_library_hits());
+  };
+  return 0;
+}
+
+static const char *texture_cache_modes[] = {"uncached", "path", "content", NULL};
+
+// Load objects without texture cache, with the cache keyed by file name and with content hashes.
+static int benchmark_textures(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark textures <object file> ...\n");
+    return 1;
+  };
+  setup_gl();
+  int mode;
+  for (mode=0; texture_cache_modes[mode]; mode++) {
+    clear_texture_cache();
+    set_texture_cache(mode > 0);
+    set_texture_content_hash(mode > 1);
+    int64_t texture_bytes = memory_usage(MEMORY_GL_TEXTURE).allocated_bytes;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int i;
+    for (i=0; i<argc; i++)
+      if (!parse_file(argv[i])) {
+        fprintf(stderr, "Error reading object file %s\n", argv[i]);
+        return 1;
+      };
+    printf("%-8s: %6.3f s, %7.2f MB of textures uploaded, %4d hits, %4d misses, %7.2f MB saved\n",
+           texture_cache_modes[mode], elapsed(&start),
+           (memory_usage(MEMORY_GL_TEXTURE).allocated_bytes - texture_bytes) / 1048576.0, (int)texture_cache_hits(),
+           (int)texture_cache_misses(), texture_bytes_saved() / 1048576.0);
+  };
+  return 0;
+}
+
+// Growth strategy of the list before it used GC_REALLOC: a fresh block for every doubling.
+static void append_copying(list_t *list, GLfloat value)
+{
+  if (list->buffer_size < (list->size + 1) * (int64_t)sizeof(GLfloat)) {
+    list->buffer_size = list->buffer_size ? 2 * list->buffer_size : sizeof(GLfloat);
+    GLfloat *space = GC_MALLOC_ATOMIC(list->buffer_size);
+    memcpy(space, list->element, list->size * sizeof(GLfloat));
+    list->element = space;
+  };
+  get_glfloat(list)[list->size++] = value;
+}
+
+static const char *append_methods[] = {"copying", "append", "append3", "reserve"};
+
+static void append_values(list_t *list, int method, int64_t n)
+{
+  int64_t i;
+  if (method == 3)
+    reserve_glfloat(list, n);
+  for (i=0; i + 2<n; i+=3) {
+    if (method == 0) {
+      append_copying(list, i);
+      append_copying(list, i + 1);
+      append_copying(list, i + 2);
+    } else if (method == 2)
+      append_glfloat3(list, i, i + 1, i + 2);
+    else {
+      append_glfloat(list, i);
+      append_glfloat(list, i + 1);
+      append_glfloat(list, i + 2);
+    };
+  };
+}
+
+// Measure in a separate process so that the peak resident set size is not affected by the other runs.
+static int measure_append(int method, int64_t n)
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    list_t *list = make_list();
+    append_values(list, method, n);
+    double seconds = elapsed(&start);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-8s: %8.3f s, %7.1f M/s, %8.1f MB list, %8.1f MB peak RSS\n", append_methods[method], seconds,
+           1e-6 * list->size / seconds, list->buffer_size / 1048576.0, usage.ru_maxrss / 1024.0);
+    exit(0);
+  };
+  int status;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static int benchmark_append(int argc, char **argv)
+{
+  int64_t n = argc ? atoll(argv[0]) : 100000000;
+  if (n <= 0) {
+    fprintf(stderr, "Syntax: benchmark append [<number of floats>]\n");
+    return 1;
+  };
+  int method;
+  for (method=0; method<4; method++)
+    if (measure_append(method, n))
+      return 1;
+  return 0;
+}
+
+#define N_PAUSE_BUCKETS 12
+
+static struct timespec pause_start;
+static int pause_histogram[N_PAUSE_BUCKETS];
+static double longest_pause;
+static double total_pause;
+
+// Bucket i counts the pauses shorter than 2^i milliseconds.
+static void record_pause(GC_EventType event)
+{
+  if (event == GC_EVENT_START)
+    clock_gettime(CLOCK_MONOTONIC, &pause_start);
+  else if (event == GC_EVENT_END) {
+    double pause = elapsed(&pause_start);
+    int i = 0;
+    while (i < N_PAUSE_BUCKETS - 1 && pause * 1e3 >= (1 << i))
+      i++;
+    pause_histogram[i]++;
+    total_pause += pause;
+    if (pause > longest_pause)
+      longest_pause = pause;
+  };
+}
+
+static int benchmark_pauses(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark pauses <object file>\n");
+    return 1;
+  };
+  setup_gl();
+  GC_set_on_collection_event(record_pause);
+  size_t allocated = GC_get_total_bytes();
+  double seconds = time_parse_file(argv[0]);
+  GC_set_on_collection_event(NULL);
+  if (seconds < 0)
+    return 1;
+  int n_pauses = 0;
+  int i;
+  for (i=0; i<N_PAUSE_BUCKETS; i++)
+    n_pauses += pause_histogram[i];
+  printf("parse: %8.3f s, %8.1f MB allocated, %d collections, %8.3f s paused, longest %8.3f s\n", seconds,
+         (GC_get_total_bytes() - allocated) / 1048576.0, n_pauses, total_pause, longest_pause);
+  for (i=0; i<N_PAUSE_BUCKETS; i++)
+    if (pause_histogram[i])
+      printf("%s%5d ms: %4d\n", i < N_PAUSE_BUCKETS - 1 ? "< " : ">=", 1 << (i < N_PAUSE_BUCKETS - 1 ? i : i - 1),
+             pause_histogram[i]);
+  return 0;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Each frame loads an object and drops it again. Run this with and without --disable-gc to compare the frame time
+// distribution of collector pauses with explicit releases.
+static int benchmark_jitter(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark jitter <object file> [frames]\n");
+    return 1;
+  };
+  int n_frames = argc >= 2 ? atoi(argv[1]) : 1000;
+  if (n_frames < 1)
+    n_frames = 1;
+  setup_gl();
+  double *frame = malloc(n_frames * sizeof(double));
+  double total = 0;
+  int i;
+  for (i=0; i<n_frames; i++) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    object_t *object = parse_file(argv[0]);
+    if (!object) {
+      fprintf(stderr, "Error reading object file %s\n", argv[0]);
+      free(frame);
+      return 1;
+    };
+#ifdef FSIM_NO_GC
+    destroy_object(object);
+#endif
+    frame[i] = elapsed(&start);
+    total += frame[i];
+  };
+  qsort(frame, n_frames, sizeof(double), compare_doubles);
+#ifdef FSIM_NO_GC
+  const char *mode = "destroy";
+#else
+  const char *mode = "gc";
+#endif
+  printf("%-7s: %d frames, mean %8.3f ms, p50 %8.3f ms, p99 %8.3f ms, max %8.3f ms\n", mode, n_frames,
+         1e3 * total / n_frames, 1e3 * frame[n_frames / 2], 1e3 * frame[n_frames * 99 / 100], 1e3 * frame[n_frames - 1]);
+  free(frame);
+  return 0;
+}
+
+static const char *vertex_optimizations[] = {"original", "cache", "overdraw", "fetch", NULL};
+
+// Compare the simulated post-transform cache statistics, the overdraw, the vertex fetch overhead and the rendering time
+// of an object without optimization and with the vertex cache, overdraw and vertex fetch passes added one by one.
+static int benchmark_vertexcache(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark vertexcache <object file> [frames]\n");
+    return 1;
+  };
+  int n_frames = argc >= 2 ? atoi(argv[1]) : 100;
+  if (n_frames < 1)
+    n_frames = 1;
+  setup_gl();
+  program_t *program = make_program("vertex.glsl", "fragment.glsl");
+  if (!program) {
+    fprintf(stderr, "Error compiling shaders\n");
+    return 1;
+  };
+  float identity[] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  glUseProgram(program->program);
+  uniform_matrix(program, "projection", identity);
+  uniform_matrix(program, "yaw", identity);
+  uniform_matrix(program, "pitch", identity);
+  uniform_matrix(program, "translation", identity);
+  int mode;
+  for (mode=0; vertex_optimizations[mode]; mode++) {
+    set_vertex_cache_optimization(mode >= 1);
+    set_overdraw_optimization(mode >= 2);
+    set_vertex_fetch_optimization(mode >= 3);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    object_t *object = parse_file(argv[0]);
+    if (!object) {
+      fprintf(stderr, "Error reading object file %s\n", argv[0]);
+      return 1;
+    };
+    double parse_time = elapsed(&start);
+    vertex_cache_statistics_t fifo16 = object_vertex_cache_statistics(object, 16);
+    vertex_cache_statistics_t fifo32 = object_vertex_cache_statistics(object, 32);
+    double overhead = object_vertex_fetch_overhead(object);
+    double overdraw = object_overdraw_statistics(object).overdraw;
+    list_t *list = make_vertex_array_object_list(program, object);
+    render(list);
+    glFinish();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int i;
+    for (i=0; i<n_frames; i++)
+      render(list);
+    glFinish();
+    double frame_time = elapsed(&start) / n_frames;
+    printf("%-8s: parse %6.3f s, ACMR %5.3f (FIFO 16) %5.3f (FIFO 32), ATVR %5.3f (FIFO 16) %5.3f (FIFO 32), "
+           "overdraw %5.3f, fetch overhead %5.3f, %8.3f ms per frame\n", vertex_optimizations[mode], parse_time,
+           fifo16.acmr, fifo32.acmr, fifo16.atvr, fifo32.atvr, overdraw, overhead, 1e3 * frame_time);
+    destroy_vertex_array_object_list(list);
+    destroy_object(object);
+  };
+  return 0;
+}
+
+static void update_format_error(vertex_format_error_t *error, list_t *array, int stride)
+{
+  if (!stride)
+    return;
+  vertex_format_error_t current = vertex_format_error(get_glfloat(array), array->size / stride, stride);
+  if (current.position > error->position) error->position = current.position;
+  if (current.texcoord > error->texcoord) error->texcoord = current.texcoord;
+  if (current.normal > error->normal) error->normal = current.normal;
+}
+
+static const char *vertex_formats[] = {"float", "compact", NULL};
+
+// Upload an object with float and compact vertex buffers and report the buffer sizes, the rendering time and the
+// largest errors of the compact format.
+static int benchmark_format(int argc, char **argv)
+{
+  if (argc < 1) {
+    fprintf(stderr, "Syntax: benchmark format <object file> [frames]\n");
+    return 1;
+  };
+  int n_frames = argc >= 2 ? atoi(argv[1]) : 100;
+  if (n_frames < 1)
+    n_frames = 1;
+  setup_gl();
+  program_t *program = make_program("vertex.glsl", "fragment.glsl");
+  object_t *object = parse_file(argv[0]);
+  if (!program || !object) {
+    fprintf(stderr, "Error reading object file %s\n", argv[0]);
+    return 1;
+  };
+  int format;
+  for (format=0; vertex_formats[format]; format++) {
+    set_vertex_format(format);
+    int64_t before = memory_usage(MEMORY_GL_BUFFER).bytes;
+    list_t *list = make_vertex_array_object_list(program, object);
+    int64_t bytes = memory_usage(MEMORY_GL_BUFFER).bytes - before;
+    render(list);
+    glFinish();
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int i;
+    for (i=0; i<n_frames; i++)
+      render(list);
+    glFinish();
+    printf("%-7s: %8.2f MB buffers, %8.3f ms per frame\n", vertex_formats[format], bytes / 1048576.0,
+           1e3 * elapsed(&start) / n_frames);
+    destroy_vertex_array_object_list(list);
+  };
+  vertex_format_error_t error = {0, 0, 0};
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    update_format_error(&error, group->array, group->stride);
+  };
+  for (i=0; i<object->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    update_format_error(&error, pool->array, pool->stride);
+  };
+  printf("compact: largest error %g (position), %g (texture coordinate), %g degrees (normal)\n", error.position,
+         error.texcoord, error.normal * 180 / M_PI);
+  return 0;
+}
+
+typedef struct {
+  const char *name;
+  int (*run)(int argc, char **argv);
+} benchmark_t;
+
+static benchmark_t benchmarks[] = {
+  {"parse"      , benchmark_parse      },
+  {"threads"    , benchmark_threads    },
+  {"numbers"    , benchmark_numbers    },
+  {"cache"      , benchmark_cache      },
+  {"stream"     , benchmark_stream     },
+  {"prescan"    , benchmark_prescan    },
+  {"compressed" , benchmark_compressed },
+  {"groups"     , benchmark_groups     },
+  {"dedup"      , benchmark_dedup      },
+  {"pool"       , benchmark_pool       },
+  {"append"     , benchmark_append     },
+  {"pauses"     , benchmark_pauses     },
+  {"jitter"     , benchmark_jitter     },
+  {"upload"     , benchmark_upload     },
+  {"library"    , benchmark_library    },
+  {"textures"   , benchmark_textures   },
+  {"vertexcache", benchmark_vertexcache},
+  {"format"     , benchmark_format     },
+  {NULL         , NULL                 }
+};
+
+int main(int argc, char **argv)
+{
+  GC_INIT();
+  int i;
+  for (i=0; argc >= 2 && benchmarks[i].name; i++)
+    if (!strcmp(argv[1], benchmarks[i].name))
+      return benchmarks[i].run(argc - 2, argv + 2);
+  fprintf(stderr, "Syntax: benchmark <benchmark> ...\n");
+  for (i=0; benchmarks[i].name; i++)
+    fprintf(stderr, "  %s\n", benchmarks[i].name);
+  return 1;
+}
@@ -0,0 +1,96 @@
+#include <stdatomic.h>
+#include "accounting.h"
+
+
+typedef struct {
+  atomic_int_fast64_t bytes;
+  atomic_int_fast64_t peak_bytes;
+  atomic_int_fast64_t allocated_bytes;
+  atomic_int_fast64_t allocations;
+  atomic_int_fast64_t releases;
+} account_t;
+
+static account_t account[MEMORY_CATEGORIES];
+
+static const char *category_name[] = {"arena", "list", "hash", "group", "image", "gl buffer", "gl texture"};
+
+static void add_bytes(account_t *target, int64_t bytes)
+{
+  int64_t current = atomic_fetch_add(&target->bytes, bytes) + bytes;
+  int64_t peak = atomic_load(&target->peak_bytes);
+  while (current > peak && !atomic_compare_exchange_weak(&target->peak_bytes, &peak, current));
+}
+
+void account_allocation(memory_category_t category, int64_t bytes)
+{
+  add_bytes(&account[category], bytes);
+  atomic_fetch_add(&account[category].allocated_bytes, bytes);
+  atomic_fetch_add(&account[category].allocations, 1);
+}
+
+void account_release(memory_category_t category, int64_t bytes)
+{
+  atomic_fetch_sub(&account[category].bytes, bytes);
+  atomic_fetch_add(&account[category].releases, 1);
+}
+
+void account_resize(memory_category_t category, int64_t old_bytes, int64_t bytes)
+{
+  if (!old_bytes)
+    account_allocation(category, bytes);
+  else if (!bytes)
+    account_release(category, old_bytes);
+  else if (bytes > old_bytes) {
+    add_bytes(&account[category], bytes - old_bytes);
+    atomic_fetch_add(&account[category].allocated_bytes, bytes - old_bytes);
+    atomic_fetch_add(&account[category].allocations, 1);
+  } else
+    atomic_fetch_sub(&account[category].bytes, old_bytes - bytes);
+}
+
+memory_usage_t memory_usage(memory_category_t category)
+{
+  memory_usage_t result;
+  result.bytes = atomic_load(&account[category].bytes);
+  result.peak_bytes = atomic_load(&account[category].peak_bytes);
+  result.allocated_bytes = atomic_load(&account[category].allocated_bytes);
+  result.allocations = atomic_load(&account[category].allocations);
+  result.releases = atomic_load(&account[category].releases);
+  return result;
+}
+
+const char *memory_category_name(memory_category_t category)
+{
+  return category_name[category];
+}
+
+void dump_memory_usage(FILE *file)
+{
+  memory_usage_t total = {0, 0, 0, 0, 0};
+  fprintf(file, "%-10s %12s %12s %12s %12s %10s\n", "category", "current MB", "peak MB", "allocated MB", "allocations",
+          "releases");
+  int i;
+  for (i=0; i<MEMORY_CATEGORIES; i++) {
+    memory_usage_t usage = memory_usage(i);
+    fprintf(file, "%-10s %12.2f %12.2f %12.2f %12lld %10lld\n", category_name[i], usage.bytes / 1048576.0,
+            usage.peak_bytes / 1048576.0, usage.allocated_bytes / 1048576.0, (long long)usage.allocations,
+            (long long)usage.releases);
+    total.bytes += usage.bytes;
+    total.allocated_bytes += usage.allocated_bytes;
+    total.allocations += usage.allocations;
+    total.releases += usage.releases;
+  };
+  fprintf(file, "%-10s %12.2f %12s %12.2f %12lld %10lld\n", "total", total.bytes / 1048576.0, "", total.allocated_bytes
+          / 1048576.0, (long long)total.allocations, (long long)total.releases);
+}
+
+void reset_memory_usage(void)
+{
+  int i;
+  for (i=0; i<MEMORY_CATEGORIES; i++) {
+    atomic_store(&account[i].peak_bytes, atomic_load(&account[i].bytes));
+    atomic_store(&account[i].allocated_bytes, 0);
+    atomic_store(&account[i].allocations, 0);
+    atomic_store(&account[i].releases, 0);
+  };
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+
+// Memory held by the subsystems of librender. Arena blocks are counted as a whole and lists and hashes only count
+// storage outside arenas. The OpenGL categories count the bytes uploaded to buffers and textures. Memory is released
+// from the accounts by the destroy_* functions and by finalizers of the OpenGL objects. Blocks reclaimed silently by
+// the garbage collector stay on the accounts, so with the collector the current bytes are an upper bound. The counters
+// are updated atomically.
+typedef enum {
+  MEMORY_ARENA,
+  MEMORY_LIST,
+  MEMORY_HASH,
+  MEMORY_GROUP,
+  MEMORY_IMAGE,
+  MEMORY_GL_BUFFER,
+  MEMORY_GL_TEXTURE,
+  MEMORY_CATEGORIES
+} memory_category_t;
+
+typedef struct {
+  int64_t bytes;
+  int64_t peak_bytes;
+  int64_t allocated_bytes;
+  int64_t allocations;
+  int64_t releases;
+} memory_usage_t;
+
+void account_allocation(memory_category_t category, int64_t bytes);
+
+void account_release(memory_category_t category, int64_t bytes);
+
+// Account for a block being resized from old_bytes to bytes. Growing a block counts as an allocation.
+void account_resize(memory_category_t category, int64_t old_bytes, int64_t bytes);
+
+memory_usage_t memory_usage(memory_category_t category);
+
+const char *memory_category_name(memory_category_t category);
+
+// Print a table with the usage of each category and the totals.
+void dump_memory_usage(FILE *file);
+
+// Restart the statistics. The current bytes are kept and become the peak.
+void reset_memory_usage(void);
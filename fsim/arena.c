@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "memory.h"
+#include "arena.h"
+#include "accounting.h"
+
+
+#define BLOCK_SIZE (1 << 16)
+#define LARGE_SIZE (BLOCK_SIZE / 8)
+#define ALIGNMENT 16
+
+typedef struct block_t {
+  struct block_t *next;
+  int64_t used;
+} block_t;
+
+// Large allocations remember their slot in the table of large blocks so that they can be resized and freed.
+typedef struct {
+  int64_t slot;
+  int64_t padding;
+} large_t;
+
+struct arena_t {
+  pthread_mutex_t mutex;
+  block_t *block;
+  large_t **large;
+  int64_t n_large;
+  int64_t max_large;
+  int64_t bytes;
+};
+
+static void finalize_arena(GC_PTR obj, GC_PTR env)
+{
+  arena_t *arena = (arena_t *)obj;
+  clear_arena(arena);
+  free(arena->large);
+  pthread_mutex_destroy(&arena->mutex);
+}
+
+arena_t *make_arena(void)
+{
+  arena_t *result = GC_MALLOC_ATOMIC(sizeof(arena_t));
+  GC_register_finalizer(result, finalize_arena, 0, 0, 0);
+  memset(result, 0, sizeof(arena_t));
+  pthread_mutex_init(&result->mutex, NULL);
+  return result;
+}
+
+static int64_t align(int64_t size)
+{
+  return (size + ALIGNMENT - 1) & ~(int64_t)(ALIGNMENT - 1);
+}
+
+static void *block_data(block_t *block)
+{
+  return (char *)block + align(sizeof(block_t));
+}
+
+static void *alloc_large(arena_t *arena, int64_t size)
+{
+  if (arena->n_large == arena->max_large) {
+    arena->max_large = arena->max_large ? 2 * arena->max_large : 64;
+    arena->large = realloc(arena->large, arena->max_large * sizeof(large_t *));
+  };
+  large_t *large = malloc(sizeof(large_t) + size);
+  large->slot = arena->n_large;
+  arena->large[arena->n_large++] = large;
+  arena->bytes += size;
+  account_allocation(MEMORY_ARENA, size);
+  return large + 1;
+}
+
+static void *alloc_small(arena_t *arena, int64_t size)
+{
+  size = align(size);
+  block_t *block = arena->block;
+  if (!block || block->used + size > BLOCK_SIZE) {
+    block = malloc(align(sizeof(block_t)) + BLOCK_SIZE);
+    block->next = arena->block;
+    block->used = 0;
+    arena->block = block;
+    arena->bytes += BLOCK_SIZE;
+    account_allocation(MEMORY_ARENA, BLOCK_SIZE);
+  };
+  void *result = (char *)block_data(block) + block->used;
+  block->used += size;
+  return result;
+}
+
+static void *alloc_locked(arena_t *arena, int64_t size)
+{
+  return size > LARGE_SIZE ? alloc_large(arena, size) : alloc_small(arena, size);
+}
+
+void *arena_alloc(arena_t *arena, int64_t size)
+{
+  pthread_mutex_lock(&arena->mutex);
+  void *result = alloc_locked(arena, size);
+  pthread_mutex_unlock(&arena->mutex);
+  return result;
+}
+
+static void free_large(arena_t *arena, void *data, int64_t size)
+{
+  large_t *large = (large_t *)data - 1;
+  large_t *last = arena->large[--arena->n_large];
+  last->slot = large->slot;
+  arena->large[large->slot] = last;
+  arena->bytes -= size;
+  account_release(MEMORY_ARENA, size);
+  free(large);
+}
+
+void *arena_realloc(arena_t *arena, void *data, int64_t old_size, int64_t size)
+{
+  if (!data)
+    return arena_alloc(arena, size);
+  pthread_mutex_lock(&arena->mutex);
+  void *result;
+  if (old_size > LARGE_SIZE && size > LARGE_SIZE) {
+    large_t *large = realloc((large_t *)data - 1, sizeof(large_t) + size);
+    arena->large[large->slot] = large;
+    arena->bytes += size - old_size;
+    account_resize(MEMORY_ARENA, old_size, size);
+    result = large + 1;
+  } else if (size <= old_size && old_size <= LARGE_SIZE)
+    result = data;
+  else {
+    result = alloc_locked(arena, size);
+    memcpy(result, data, old_size < size ? old_size : size);
+    if (old_size > LARGE_SIZE)
+      free_large(arena, data, old_size);
+  };
+  pthread_mutex_unlock(&arena->mutex);
+  return result;
+}
+
+void arena_free(arena_t *arena, void *data, int64_t size)
+{
+  if (!data || size <= LARGE_SIZE)
+    return;
+  pthread_mutex_lock(&arena->mutex);
+  free_large(arena, data, size);
+  pthread_mutex_unlock(&arena->mutex);
+}
+
+int64_t arena_bytes(arena_t *arena)
+{
+  pthread_mutex_lock(&arena->mutex);
+  int64_t result = arena->bytes;
+  pthread_mutex_unlock(&arena->mutex);
+  return result;
+}
+
+void clear_arena(arena_t *arena)
+{
+  pthread_mutex_lock(&arena->mutex);
+  while (arena->block) {
+    block_t *next = arena->block->next;
+    free(arena->block);
+    arena->block = next;
+  };
+  while (arena->n_large)
+    free(arena->large[--arena->n_large]);
+  if (arena->bytes)
+    account_release(MEMORY_ARENA, arena->bytes);
+  arena->bytes = 0;
+  pthread_mutex_unlock(&arena->mutex);
+}
+
+void destroy_arena(arena_t *arena)
+{
+  GC_register_finalizer(arena, 0, 0, 0, 0);
+  finalize_arena(arena, 0);
+  GC_FREE(arena);
+}
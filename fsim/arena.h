@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+
+// Region allocator for the temporary data of a parse. Small allocations are taken from shared blocks and large ones
+// get a block of their own which can be resized in place. Everything is released at once by clear_arena or when
+// the arena is collected. Arena memory is not scanned by the garbage collector and must not hold the only
+// reference to collectable objects. The functions are thread-safe.
+typedef struct arena_t arena_t;
+
+arena_t *make_arena(void);
+
+void *arena_alloc(arena_t *arena, int64_t size);
+
+// Resize an allocation of old_size bytes. The data is moved if it cannot be resized in place.
+void *arena_realloc(arena_t *arena, void *data, int64_t old_size, int64_t size);
+
+// Release a large allocation early. Small allocations are only released by clear_arena.
+void arena_free(arena_t *arena, void *data, int64_t size);
+
+// Bytes currently held by the arena.
+int64_t arena_bytes(arena_t *arena);
+
+void clear_arena(arena_t *arena);
+
+void destroy_arena(arena_t *arena);
@@ -0,0 +1,705 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memory.h"
+#include "cache.h"
+#include "vertex_cache.h"
+#include "overdraw.h"
+#include "vertex_fetch.h"
+
+
+static const char object_magic[8] = "FSIMOBJ";
+static const char index_magic[8] = "FSIMIDX";
+
+typedef struct {
+  const char *p;
+  const char *end;
+} reader_t;
+
+char *object_cache_file_name(const char *file_name)
+{
+  char *result = GC_MALLOC_ATOMIC(strlen(file_name) + 7);
+  strcpy(result, file_name);
+  strcat(result, ".cache");
+  return result;
+}
+
+char *group_index_file_name(const char *file_name)
+{
+  char *result = GC_MALLOC_ATOMIC(strlen(file_name) + 7);
+  strcpy(result, file_name);
+  strcat(result, ".index");
+  return result;
+}
+
+group_index_t *make_group_index(void)
+{
+  group_index_t *result = GC_MALLOC(sizeof(group_index_t));
+  result->object_name = NULL;
+  result->definitions = make_list();
+  result->entries = make_list();
+  return result;
+}
+
+void destroy_group_entries(list_t *entries)
+{
+  int i;
+  for (i=0; i<entries->size; i++) {
+    group_entry_t *entry = get_pointer(entries)[i];
+    GC_FREE(entry->name);
+    GC_FREE(entry->material);
+    GC_FREE(entry);
+  };
+  destroy_list(entries);
+}
+
+void destroy_group_index(group_index_t *index)
+{
+  int i;
+  for (i=0; i<index->definitions->size; i++)
+    GC_FREE(get_pointer(index->definitions)[i]);
+  destroy_list(index->definitions);
+  destroy_group_entries(index->entries);
+  GC_FREE(index->object_name);
+  GC_FREE(index);
+}
+
+static void file_key(const char *file_name, int64_t *key)
+{
+  struct stat st;
+  if (stat(file_name, &st)) {
+    key[0] = -1;
+    key[1] = 0;
+    key[2] = 0;
+  } else {
+    key[0] = st.st_size;
+    key[1] = st.st_mtim.tv_sec;
+    key[2] = st.st_mtim.tv_nsec;
+  };
+}
+
+static void write_data(FILE *f, const void *data, size_t size)
+{
+  static const char padding[4] = {0, 0, 0, 0};
+  fwrite(data, 1, size, f);
+  fwrite(padding, 1, -size & 3, f);
+}
+
+static void write_int(FILE *f, int32_t value)
+{
+  write_data(f, &value, sizeof(value));
+}
+
+static void write_int64(FILE *f, int64_t value)
+{
+  write_data(f, &value, sizeof(value));
+}
+
+static void write_string(FILE *f, const char *text)
+{
+  int32_t length = text ? strlen(text) : 0;
+  write_int(f, length);
+  write_data(f, text, length);
+}
+
+static void write_file_key(FILE *f, const char *file_name)
+{
+  int64_t key[3];
+  file_key(file_name, key);
+  write_data(f, key, sizeof(key));
+  write_string(f, file_name);
+}
+
+static void write_header(FILE *f, const char *magic, int version, const char *source, list_t *dependencies)
+{
+  write_data(f, magic, 8);
+  write_int(f, version);
+  write_int(f, 1 + dependencies->size);
+  write_file_key(f, source);
+  int i;
+  for (i=0; i<dependencies->size; i++)
+    write_file_key(f, get_pointer(dependencies)[i]);
+}
+
+static FILE *create_temporary(const char *file_name, char **temporary)
+{
+  *temporary = GC_MALLOC_ATOMIC(strlen(file_name) + 8);
+  sprintf(*temporary, "%s.XXXXXX", file_name);
+  int fd = mkstemp(*temporary);
+  FILE *result = fd >= 0 ? fdopen(fd, "w") : NULL;
+  if (result)
+    fchmod(fd, 0644);
+  else {
+    if (fd >= 0)
+      close(fd);
+    GC_FREE(*temporary);
+  };
+  return result;
+}
+
+// Replacing the file atomically makes sure that concurrent readers never see a partially written file.
+static int commit_temporary(FILE *f, char *temporary, const char *file_name)
+{
+  int result = ferror(f);
+  result = fclose(f) || result;
+  if (!result)
+    result = rename(temporary, file_name);
+  if (result)
+    unlink(temporary);
+  GC_FREE(temporary);
+  return result;
+}
+
+static int material_index(list_t *materials, material_t *material)
+{
+  int i;
+  for (i=0; i<materials->size; i++)
+    if (get_pointer(materials)[i] == material)
+      return i;
+  return -1;
+}
+
+static int has_texture_file(texture_t *texture)
+{
+  return !texture || texture->file_name;
+}
+
+static const char *texture_file(texture_t *texture)
+{
+  return texture ? texture->file_name : NULL;
+}
+
+static void write_material(FILE *f, material_t *material)
+{
+  write_int(f, material->illumination);
+  write_data(f, material->ambient, sizeof(material->ambient));
+  write_data(f, material->diffuse, sizeof(material->diffuse));
+  write_data(f, material->specular, sizeof(material->specular));
+  write_data(f, &material->specular_exponent, sizeof(GLfloat));
+  write_data(f, &material->optical_density, sizeof(GLfloat));
+  write_data(f, &material->disolve, sizeof(GLfloat));
+  write_string(f, texture_file(material->diffuse_texture));
+  write_string(f, texture_file(material->specular_texture));
+}
+
+static int pool_index(object_t *object, vertex_pool_t *pool)
+{
+  int i;
+  for (i=0; i<object->pool->size; i++)
+    if (get_pointer(object->pool)[i] == pool)
+      return i;
+  return -1;
+}
+
+static void write_pool(FILE *f, vertex_pool_t *pool)
+{
+  write_int(f, pool->stride);
+  write_int64(f, pool->array->size);
+  write_data(f, pool->array->element, pool->array->size * sizeof(GLfloat));
+}
+
+static void write_group(FILE *f, group_t *group, list_t *materials, object_t *object)
+{
+  write_string(f, group->name);
+  write_int(f, group->stride);
+  write_int(f, material_index(materials, group->material));
+  write_int(f, pool_index(object, group->pool));
+  write_int64(f, group->array->size);
+  write_data(f, group->array->element, size_of_array(group));
+  write_int64(f, group->vertex_index->size);
+  write_data(f, group->vertex_index->element, size_of_indices(group));
+}
+
+// Flags recording the optimizations which were applied to the groups before writing the cache.
+#define VERTEX_CACHE_OPTIMIZED 1
+#define VERTEX_FETCH_OPTIMIZED 2
+#define OVERDRAW_OPTIMIZED 4
+
+static int optimizations(void)
+{
+  return (get_vertex_cache_optimization() ? VERTEX_CACHE_OPTIMIZED : 0) |
+         (get_vertex_fetch_optimization() ? VERTEX_FETCH_OPTIMIZED : 0) |
+         (get_overdraw_optimization() ? OVERDRAW_OPTIMIZED : 0);
+}
+
+int write_object_cache(const char *file_name, object_t *object, list_t *dependencies)
+{
+  char *source = realpath(file_name, NULL);
+  if (!source)
+    return 1;
+  list_t *materials = object_materials(object);
+  int i;
+  for (i=0; i<materials->size; i++) {
+    material_t *material = get_pointer(materials)[i];
+    if (!has_texture_file(material->diffuse_texture) || !has_texture_file(material->specular_texture)) {
+      free(source);
+      destroy_list(materials);
+      return 1;
+    };
+  };
+  char *cache_name = object_cache_file_name(file_name);
+  char *temporary;
+  FILE *f = create_temporary(cache_name, &temporary);
+  if (!f) {
+    free(source);
+    destroy_list(materials);
+    GC_FREE(cache_name);
+    return 1;
+  };
+  write_header(f, object_magic, OBJECT_CACHE_VERSION, source, dependencies);
+  free(source);
+  write_string(f, object->name);
+  write_int(f, optimizations());
+  write_int(f, materials->size);
+  for (i=0; i<materials->size; i++)
+    write_material(f, get_pointer(materials)[i]);
+  write_int(f, object->pool->size);
+  for (i=0; i<object->pool->size; i++)
+    write_pool(f, get_pointer(object->pool)[i]);
+  write_int(f, object->group->size);
+  for (i=0; i<object->group->size; i++)
+    write_group(f, get_pointer(object->group)[i], materials, object);
+  destroy_list(materials);
+  int result = commit_temporary(f, temporary, cache_name);
+  GC_FREE(cache_name);
+  return result;
+}
+
+static void write_range(FILE *f, text_range_t *range)
+{
+  write_int64(f, range->start);
+  write_int64(f, range->end);
+  write_int(f, range->line);
+}
+
+static void write_entry(FILE *f, group_entry_t *entry)
+{
+  write_string(f, entry->name);
+  write_string(f, entry->material);
+  write_range(f, &entry->block);
+  write_int64(f, entry->vertex_start);
+  write_int(f, entry->n_vertex);
+  write_int(f, entry->n_uv);
+  write_int(f, entry->n_normal);
+}
+
+int write_group_index(const char *file_name, group_index_t *index)
+{
+  char *source = realpath(file_name, NULL);
+  if (!source)
+    return 1;
+  char *index_name = group_index_file_name(file_name);
+  char *temporary;
+  FILE *f = create_temporary(index_name, &temporary);
+  if (!f) {
+    free(source);
+    GC_FREE(index_name);
+    return 1;
+  };
+  list_t *dependencies = make_list();
+  write_header(f, index_magic, GROUP_INDEX_VERSION, source, dependencies);
+  destroy_list(dependencies);
+  free(source);
+  write_string(f, index->object_name);
+  write_int(f, index->definitions->size);
+  int i;
+  for (i=0; i<index->definitions->size; i++)
+    write_range(f, get_pointer(index->definitions)[i]);
+  write_int(f, index->entries->size);
+  for (i=0; i<index->entries->size; i++)
+    write_entry(f, get_pointer(index->entries)[i]);
+  int result = commit_temporary(f, temporary, index_name);
+  GC_FREE(index_name);
+  return result;
+}
+
+static const void *read_data(reader_t *reader, size_t size)
+{
+  size_t padded = (size + 3) & ~(size_t)3;
+  if (!reader->p || reader->end - reader->p < padded) {
+    reader->p = NULL;
+    return NULL;
+  };
+  const void *result = reader->p;
+  reader->p += padded;
+  return result;
+}
+
+static int32_t read_int(reader_t *reader)
+{
+  int32_t result = 0;
+  const void *data = read_data(reader, sizeof(result));
+  if (data) memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+static int64_t read_int64(reader_t *reader)
+{
+  int64_t result = 0;
+  const void *data = read_data(reader, sizeof(result));
+  if (data) memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+static char *read_string(reader_t *reader)
+{
+  int32_t length = read_int(reader);
+  const char *data = length >= 0 ? read_data(reader, length) : NULL;
+  if (!data)
+    return NULL;
+  char *result = GC_MALLOC_ATOMIC(length + 1);
+  memcpy(result, data, length);
+  result[length] = '\0';
+  return result;
+}
+
+static int read_file_key(reader_t *reader, const char *expected_name)
+{
+  int64_t key[3];
+  int64_t actual[3];
+  const void *data = read_data(reader, sizeof(key));
+  char *file_name = read_string(reader);
+  if (!data || !file_name) {
+    GC_FREE(file_name);
+    return 0;
+  };
+  memcpy(key, data, sizeof(key));
+  int result = !expected_name || !strcmp(file_name, expected_name);
+  if (result) {
+    file_key(file_name, actual);
+    result = !memcmp(key, actual, sizeof(key));
+  };
+  GC_FREE(file_name);
+  return result;
+}
+
+static int read_header(reader_t *reader, const char *magic, int version, const char *file_name)
+{
+  const void *data = read_data(reader, 8);
+  if (!data || memcmp(data, magic, 8) || read_int(reader) != version)
+    return 0;
+  int n_files = read_int(reader);
+  char *source = realpath(file_name, NULL);
+  int result = source && n_files >= 1 && read_file_key(reader, source);
+  free(source);
+  int i;
+  for (i=1; result && i<n_files; i++)
+    result = read_file_key(reader, NULL);
+  return result && reader->p;
+}
+
+static void read_floats(reader_t *reader, GLfloat *result, int n)
+{
+  const void *data = read_data(reader, n * sizeof(GLfloat));
+  if (data) memcpy(result, data, n * sizeof(GLfloat));
+}
+
+static material_t *read_material(reader_t *reader, list_t *textures)
+{
+  material_t *result = make_material();
+  result->illumination = read_int(reader);
+  read_floats(reader, result->ambient, 3);
+  read_floats(reader, result->diffuse, 3);
+  read_floats(reader, result->specular, 3);
+  read_floats(reader, &result->specular_exponent, 1);
+  read_floats(reader, &result->optical_density, 1);
+  read_floats(reader, &result->disolve, 1);
+  char *diffuse_texture = read_string(reader);
+  char *specular_texture = read_string(reader);
+  if (reader->p) {
+    if (*diffuse_texture)
+      append_pointer(textures, request_diffuse_texture(result, diffuse_texture));
+    if (*specular_texture)
+      append_pointer(textures, request_specular_texture(result, specular_texture));
+  } else {
+    destroy_material(result);
+    result = NULL;
+  };
+  GC_FREE(diffuse_texture);
+  GC_FREE(specular_texture);
+  return result;
+}
+
+// An invalid element count stops the reader like a truncated file.
+static const void *read_elements(reader_t *reader, int64_t *size, size_t element_size)
+{
+  *size = read_int64(reader);
+  if (*size < 0 || *size > PTRDIFF_MAX / element_size) {
+    reader->p = NULL;
+    return NULL;
+  };
+  const void *data = read_data(reader, *size * element_size);
+  return *size ? data : NULL;
+}
+
+static void read_glfloats(reader_t *reader, list_t *list)
+{
+  int64_t size;
+  const void *data = read_elements(reader, &size, sizeof(GLfloat));
+  if (data)
+    append_glfloats(list, data, size);
+}
+
+static void read_gluints(reader_t *reader, list_t *list)
+{
+  int64_t size;
+  const void *data = read_elements(reader, &size, sizeof(GLuint));
+  if (data)
+    append_gluints(list, data, size);
+}
+
+static int valid_stride(int stride)
+{
+  return stride == 3 || stride == 5 || stride == 6 || stride == 8;
+}
+
+// Indices must refer to existing vertices because the optimization passes and the upload do not check them.
+static int valid_indices(group_t *group)
+{
+  list_t *array = group->pool ? group->pool->array : group->array;
+  int64_t n_vertices = array->size / group->stride;
+  GLuint *index = get_gluint(group->vertex_index);
+  int64_t i;
+  if (group->vertex_index->size % 3)
+    return 0;
+  for (i=0; i<group->vertex_index->size; i++)
+    if (index[i] >= n_vertices)
+      return 0;
+  return 1;
+}
+
+static vertex_pool_t *read_pool(reader_t *reader)
+{
+  vertex_pool_t *result = make_vertex_pool(read_int(reader));
+  if (valid_stride(result->stride))
+    read_glfloats(reader, result->array);
+  if (!reader->p || !valid_stride(result->stride) || result->array->size % result->stride) {
+    destroy_vertex_pool(result);
+    return NULL;
+  };
+  return result;
+}
+
+static group_t *read_group(reader_t *reader, list_t *materials, list_t *pools)
+{
+  char *name = read_string(reader);
+  int stride = read_int(reader);
+  int material = read_int(reader);
+  int pool = read_int(reader);
+  if (!name || !valid_stride(stride) || material < -1 || material >= materials->size || pool < -1 ||
+      pool >= pools->size || (pool >= 0 && ((vertex_pool_t *)get_pointer(pools)[pool])->stride != stride)) {
+    GC_FREE(name);
+    return NULL;
+  };
+  group_t *result = make_group(name, stride);
+  GC_FREE(name);
+  if (material >= 0)
+    use_material(result, get_pointer(materials)[material]);
+  if (pool >= 0)
+    result->pool = get_pointer(pools)[pool];
+  read_glfloats(reader, result->array);
+  read_gluints(reader, result->vertex_index);
+  if (!reader->p || result->array->size % stride || (result->pool && result->array->size) || !valid_indices(result)) {
+    destroy_group(result);
+    return NULL;
+  };
+  return result;
+}
+
+// Materials which are not used by any group are released as well.
+static void discard_materials(list_t *materials, object_t *object)
+{
+  list_t *used = object ? object_materials(object) : make_list();
+  int i;
+  for (i=0; i<materials->size; i++) {
+    material_t *material = get_pointer(materials)[i];
+    if (material_index(used, material) < 0)
+      destroy_material(material);
+  };
+  destroy_list(used);
+  destroy_list(materials);
+}
+
+static void discard_textures(list_t *textures)
+{
+  int i;
+  for (i=0; i<textures->size; i++)
+    destroy_pending_texture(get_pointer(textures)[i]);
+  destroy_list(textures);
+}
+
+static object_t *read_pools_and_groups(reader_t *reader, object_t *result, list_t *materials)
+{
+  int n_pools = read_int(reader);
+  int i;
+  for (i=0; i<n_pools; i++) {
+    vertex_pool_t *pool = read_pool(reader);
+    if (!pool)
+      return NULL;
+    append_pointer(result->pool, pool);
+  };
+  int n_groups = read_int(reader);
+  for (i=0; i<n_groups; i++) {
+    group_t *group = read_group(reader, materials, result->pool);
+    if (!group)
+      return NULL;
+    add_group(result, group);
+  };
+  return reader->p ? result : NULL;
+}
+
+// Apply the enabled optimizations missing in the cache. Each pass depends on the order produced by the previous ones.
+static void optimize_object(object_t *object, int optimized)
+{
+  int vertex_cache = get_vertex_cache_optimization() && !(optimized & VERTEX_CACHE_OPTIMIZED);
+  if (vertex_cache)
+    optimize_object_vertex_cache(object);
+  int overdraw = get_overdraw_optimization() && (vertex_cache || !(optimized & OVERDRAW_OPTIMIZED));
+  if (overdraw)
+    optimize_object_overdraw(object);
+  if (get_vertex_fetch_optimization() && (vertex_cache || overdraw || !(optimized & VERTEX_FETCH_OPTIMIZED)))
+    optimize_object_vertex_fetch(object);
+}
+
+static object_t *read_object(reader_t *reader, const char *file_name)
+{
+  if (!read_header(reader, object_magic, OBJECT_CACHE_VERSION, file_name))
+    return NULL;
+  char *name = read_string(reader);
+  if (!name)
+    return NULL;
+  object_t *result = make_object(name);
+  GC_FREE(name);
+  int optimized = read_int(reader);
+  list_t *materials = make_list();
+  list_t *textures = make_list();
+  int n_materials = read_int(reader);
+  int i;
+  for (i=0; result && i<n_materials; i++) {
+    material_t *material = read_material(reader, textures);
+    if (material)
+      append_pointer(materials, material);
+    else
+      result = NULL;
+  };
+  for (i=0; result && i<textures->size; i++)
+    upload_texture(get_pointer(textures)[i]);
+  discard_textures(textures);
+  if (result && !read_pools_and_groups(reader, result, materials)) {
+    // Groups do not own their materials. The materials are released below.
+    for (i=0; i<result->group->size; i++)
+      use_material(get_pointer(result->group)[i], NULL);
+    destroy_object(result);
+    result = NULL;
+  };
+  discard_materials(materials, result);
+  if (result)
+    optimize_object(result, optimized);
+  return result;
+}
+
+static const char *map_cache(const char *file_name, size_t *size)
+{
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  const char *result = NULL;
+  if (!fstat(fd, &st) && st.st_size) {
+    *size = st.st_size;
+    result = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (result == MAP_FAILED)
+      result = NULL;
+  };
+  close(fd);
+  return result;
+}
+
+object_t *read_object_cache(const char *file_name)
+{
+  size_t size;
+  char *cache_name = object_cache_file_name(file_name);
+  const char *text = map_cache(cache_name, &size);
+  GC_FREE(cache_name);
+  if (!text)
+    return NULL;
+  reader_t reader = {text, text + size};
+  object_t *result = read_object(&reader, file_name);
+  munmap((void *)text, size);
+  return result;
+}
+
+static void read_range(reader_t *reader, text_range_t *range)
+{
+  range->start = read_int64(reader);
+  range->end = read_int64(reader);
+  range->line = read_int(reader);
+}
+
+static group_entry_t *read_entry(reader_t *reader)
+{
+  group_entry_t *result = GC_MALLOC(sizeof(group_entry_t));
+  result->name = read_string(reader);
+  result->material = read_string(reader);
+  if (result->material && !*result->material) {
+    GC_FREE(result->material);
+    result->material = NULL;
+  };
+  read_range(reader, &result->block);
+  result->vertex_start = read_int64(reader);
+  result->n_vertex = read_int(reader);
+  result->n_uv = read_int(reader);
+  result->n_normal = read_int(reader);
+  if (!reader->p) {
+    GC_FREE(result->name);
+    GC_FREE(result->material);
+    GC_FREE(result);
+    return NULL;
+  };
+  return result;
+}
+
+static group_index_t *read_index(reader_t *reader, const char *file_name)
+{
+  if (!read_header(reader, index_magic, GROUP_INDEX_VERSION, file_name))
+    return NULL;
+  group_index_t *result = make_group_index();
+  result->object_name = read_string(reader);
+  int n_definitions = read_int(reader);
+  int i;
+  for (i=0; reader->p && i<n_definitions; i++) {
+    text_range_t *range = GC_MALLOC_ATOMIC(sizeof(text_range_t));
+    read_range(reader, range);
+    append_pointer(result->definitions, range);
+  };
+  int n_entries = read_int(reader);
+  for (i=0; reader->p && i<n_entries; i++) {
+    group_entry_t *entry = read_entry(reader);
+    if (entry)
+      append_pointer(result->entries, entry);
+  };
+  if (!reader->p) {
+    destroy_group_index(result);
+    return NULL;
+  };
+  return result;
+}
+
+group_index_t *read_group_index(const char *file_name)
+{
+  size_t size;
+  char *index_name = group_index_file_name(file_name);
+  const char *text = map_cache(index_name, &size);
+  GC_FREE(index_name);
+  if (!text)
+    return NULL;
+  reader_t reader = {text, text + size};
+  group_index_t *result = read_index(&reader, file_name);
+  munmap((void *)text, size);
+  return result;
+}
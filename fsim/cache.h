@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include "object.h"
+#include "list.h"
+
+
+// Binary cache of parsed object files. The cache file stores the vertex arrays, indices, strides and materials of
+// all groups as well as the shared vertex pools. It is only used if the object file and all files it depends on
+// (material libraries and textures) still have the same size and modification time as when the cache was written.
+#define OBJECT_CACHE_VERSION 4
+
+// The caller owns the returned file name.
+char *object_cache_file_name(const char *file_name);
+
+// Write the cache for an object file. Returns zero on success. The cache records which vertex cache, overdraw and
+// vertex fetch optimizations were enabled so that objects cached without them are optimized when they are read with
+// them enabled.
+int write_object_cache(const char *file_name, object_t *object, list_t *dependencies);
+
+// Memory-map the cache of an object file and create the object from it. Returns NULL if the cache is missing or stale
+// or if it contains invalid strides or vertex indices.
+object_t *read_object_cache(const char *file_name);
+
+// Index of the groups of an object file so that individual groups can be loaded without parsing the whole file.
+// Offsets are byte offsets into the object file. The index is valid as long as the object file is unchanged.
+#define GROUP_INDEX_VERSION 1
+
+typedef struct {
+  int64_t start;
+  int64_t end;
+  int line;
+} text_range_t;
+
+typedef struct {
+  char *name;
+  char *material;         // material selected before the "g" statement or NULL
+  text_range_t block;     // from the "g" statement to the next "g" or "o" statement
+  int64_t vertex_start;   // offset of the first coordinate record referenced by the group
+  int n_vertex;           // number of coordinate records before vertex_start
+  int n_uv;
+  int n_normal;
+} group_entry_t;
+
+typedef struct {
+  char *object_name;
+  list_t *definitions;    // ranges with "mtllib" statements and material definitions
+  list_t *entries;
+} group_index_t;
+
+group_index_t *make_group_index(void);
+
+// Release the entries, their names and the list itself.
+void destroy_group_entries(list_t *entries);
+
+void destroy_group_index(group_index_t *index);
+
+// The caller owns the returned file name.
+char *group_index_file_name(const char *file_name);
+
+// Write the group index of an object file. Returns zero on success.
+int write_group_index(const char *file_name, group_index_t *index);
+
+// Returns NULL if the index is missing or stale.
+group_index_t *read_group_index(const char *file_name);
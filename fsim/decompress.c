@@ -0,0 +1,277 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <lzma.h>
+#include "decompress.h"
+
+
+#define BLOCK_SIZE (1 << 20)
+#define INPUT_SIZE (1 << 16)
+#define QUEUE_SIZE 4
+
+static const unsigned char gzip_magic[] = {0x1f, 0x8b};
+static const unsigned char xz_magic[] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+
+typedef struct {
+  char *data;
+  size_t size;
+} block_t;
+
+struct decompressor_t {
+  gzFile gz;
+  FILE *file;
+  lzma_stream lzma;
+  unsigned char *input;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  block_t queue[QUEUE_SIZE];
+  int head;
+  int count;
+  char finished;
+  char error;
+  char cancelled;
+  char *current;
+  const char *position;
+  size_t remaining;
+};
+
+static int has_magic(const unsigned char *header, size_t size, const unsigned char *magic, size_t magic_size)
+{
+  return size >= magic_size && !memcmp(header, magic, magic_size);
+}
+
+static size_t read_header(const char *file_name, unsigned char *header, size_t size)
+{
+  FILE *f = fopen(file_name, "rb");
+  if (!f)
+    return 0;
+  size_t result = fread(header, 1, size, f);
+  fclose(f);
+  return result;
+}
+
+int is_compressed(const char *file_name)
+{
+  unsigned char header[sizeof(xz_magic)];
+  size_t size = read_header(file_name, header, sizeof(header));
+  return has_magic(header, size, gzip_magic, sizeof(gzip_magic)) || has_magic(header, size, xz_magic, sizeof(xz_magic));
+}
+
+// Returns the number of bytes read, zero at the end of the data, or -1 if the compressed data is corrupt.
+static long read_xz(decompressor_t *decompressor, char *buffer, size_t size)
+{
+  lzma_stream *lzma = &decompressor->lzma;
+  lzma->next_out = (uint8_t *)buffer;
+  lzma->avail_out = size;
+  while (lzma->avail_out) {
+    if (!lzma->avail_in && !feof(decompressor->file)) {
+      lzma->next_in = decompressor->input;
+      lzma->avail_in = fread(decompressor->input, 1, INPUT_SIZE, decompressor->file);
+      if (ferror(decompressor->file))
+        return -1;
+    };
+    lzma_ret status = lzma_code(lzma, feof(decompressor->file) ? LZMA_FINISH : LZMA_RUN);
+    if (status == LZMA_STREAM_END)
+      break;
+    if (status != LZMA_OK)
+      return -1;
+  };
+  return size - lzma->avail_out;
+}
+
+static long read_compressed(decompressor_t *decompressor, char *buffer, size_t size)
+{
+  if (decompressor->file)
+    return read_xz(decompressor, buffer, size);
+  return gzread(decompressor->gz, buffer, size);
+}
+
+static int push_block(decompressor_t *decompressor, char *data, size_t size)
+{
+  pthread_mutex_lock(&decompressor->mutex);
+  while (decompressor->count == QUEUE_SIZE && !decompressor->cancelled)
+    pthread_cond_wait(&decompressor->changed, &decompressor->mutex);
+  int result = !decompressor->cancelled;
+  if (result) {
+    block_t *block = &decompressor->queue[(decompressor->head + decompressor->count) % QUEUE_SIZE];
+    block->data = data;
+    block->size = size;
+    decompressor->count++;
+    pthread_cond_broadcast(&decompressor->changed);
+  };
+  pthread_mutex_unlock(&decompressor->mutex);
+  return result;
+}
+
+static void finish(decompressor_t *decompressor, int error)
+{
+  pthread_mutex_lock(&decompressor->mutex);
+  decompressor->finished = 1;
+  decompressor->error = error;
+  pthread_cond_broadcast(&decompressor->changed);
+  pthread_mutex_unlock(&decompressor->mutex);
+}
+
+// Incomplete lines at the end of a block are carried over to the next block.
+static void *decompress_blocks(void *data)
+{
+  decompressor_t *decompressor = data;
+  char *carry = NULL;
+  size_t n_carry = 0;
+  int error = 0;
+  while (1) {
+    char *buffer = malloc(n_carry + BLOCK_SIZE);
+    memcpy(buffer, carry, n_carry);
+    free(carry);
+    carry = NULL;
+    long n = read_compressed(decompressor, buffer + n_carry, BLOCK_SIZE);
+    if (n < 0) {
+      free(buffer);
+      error = 1;
+      break;
+    };
+    size_t size = n_carry + n;
+    n_carry = 0;
+    if (n) {
+      const char *last = memrchr(buffer, '\n', size);
+      size_t n_lines = last ? last + 1 - buffer : 0;
+      n_carry = size - n_lines;
+      if (n_carry) {
+        carry = malloc(n_carry);
+        memcpy(carry, buffer + n_lines, n_carry);
+      };
+      size = n_lines;
+    };
+    if (!size)
+      free(buffer);
+    else if (!push_block(decompressor, buffer, size)) {
+      free(buffer);
+      break;
+    };
+    if (!n)
+      break;
+  };
+  free(carry);
+  finish(decompressor, error);
+  return NULL;
+}
+
+decompressor_t *open_decompressor(const char *file_name)
+{
+  unsigned char header[sizeof(xz_magic)];
+  size_t size = read_header(file_name, header, sizeof(header));
+  decompressor_t *result = calloc(1, sizeof(decompressor_t));
+  if (has_magic(header, size, xz_magic, sizeof(xz_magic))) {
+    result->file = fopen(file_name, "rb");
+    lzma_stream lzma = LZMA_STREAM_INIT;
+    result->lzma = lzma;
+    result->input = malloc(INPUT_SIZE);
+    if (result->file && lzma_stream_decoder(&result->lzma, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+      fclose(result->file);
+      result->file = NULL;
+    };
+    if (!result->file) {
+      free(result->input);
+      free(result);
+      return NULL;
+    };
+  } else {
+    result->gz = gzopen(file_name, "rb");
+    if (!result->gz) {
+      free(result);
+      return NULL;
+    };
+    gzbuffer(result->gz, INPUT_SIZE);
+  };
+  pthread_mutex_init(&result->mutex, NULL);
+  pthread_cond_init(&result->changed, NULL);
+  pthread_create(&result->thread, NULL, decompress_blocks, result);
+  return result;
+}
+
+const char *next_block(decompressor_t *decompressor, size_t *size)
+{
+  pthread_mutex_lock(&decompressor->mutex);
+  free(decompressor->current);
+  decompressor->current = NULL;
+  while (!decompressor->count && !decompressor->finished)
+    pthread_cond_wait(&decompressor->changed, &decompressor->mutex);
+  if (decompressor->count) {
+    block_t *block = &decompressor->queue[decompressor->head];
+    decompressor->current = block->data;
+    *size = block->size;
+    decompressor->head = (decompressor->head + 1) % QUEUE_SIZE;
+    decompressor->count--;
+    pthread_cond_broadcast(&decompressor->changed);
+  };
+  pthread_mutex_unlock(&decompressor->mutex);
+  return decompressor->current;
+}
+
+int decompressor_error(decompressor_t *decompressor)
+{
+  pthread_mutex_lock(&decompressor->mutex);
+  int result = decompressor->error;
+  pthread_mutex_unlock(&decompressor->mutex);
+  return result;
+}
+
+void close_decompressor(decompressor_t *decompressor)
+{
+  pthread_mutex_lock(&decompressor->mutex);
+  decompressor->cancelled = 1;
+  pthread_cond_broadcast(&decompressor->changed);
+  pthread_mutex_unlock(&decompressor->mutex);
+  pthread_join(decompressor->thread, NULL);
+  while (decompressor->count) {
+    free(decompressor->queue[decompressor->head].data);
+    decompressor->head = (decompressor->head + 1) % QUEUE_SIZE;
+    decompressor->count--;
+  };
+  free(decompressor->current);
+  if (decompressor->file) {
+    lzma_end(&decompressor->lzma);
+    fclose(decompressor->file);
+  } else
+    gzclose(decompressor->gz);
+  free(decompressor->input);
+  pthread_cond_destroy(&decompressor->changed);
+  pthread_mutex_destroy(&decompressor->mutex);
+  free(decompressor);
+}
+
+static ssize_t read_cookie(void *cookie, char *buffer, size_t size)
+{
+  decompressor_t *decompressor = cookie;
+  while (!decompressor->remaining) {
+    decompressor->position = next_block(decompressor, &decompressor->remaining);
+    if (!decompressor->position)
+      return decompressor_error(decompressor) ? -1 : 0;
+  };
+  size_t n = size < decompressor->remaining ? size : decompressor->remaining;
+  memcpy(buffer, decompressor->position, n);
+  decompressor->position += n;
+  decompressor->remaining -= n;
+  return n;
+}
+
+static int close_cookie(void *cookie)
+{
+  close_decompressor(cookie);
+  return 0;
+}
+
+FILE *open_input(const char *file_name)
+{
+  if (!is_compressed(file_name))
+    return fopen(file_name, "r");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  if (!decompressor)
+    return NULL;
+  cookie_io_functions_t functions = {read_cookie, NULL, NULL, close_cookie};
+  return fopencookie(decompressor, "r", functions);
+}
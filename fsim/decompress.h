@@ -0,0 +1,23 @@
+#pragma once
+#include <stdio.h>
+
+
+// Files compressed with gzip or xz are decompressed by a background thread while the caller processes the
+// blocks which are already available. Each block ends at a line boundary except for the last one.
+typedef struct decompressor_t decompressor_t;
+
+// Check the magic bytes of a file.
+int is_compressed(const char *file_name);
+
+decompressor_t *open_decompressor(const char *file_name);
+
+// Get the next block of decompressed data. The block is valid until the next call. Returns NULL at the end.
+const char *next_block(decompressor_t *decompressor, size_t *size);
+
+// Returns non-zero if the compressed data could not be read.
+int decompressor_error(decompressor_t *decompressor);
+
+void close_decompressor(decompressor_t *decompressor);
+
+// Open a file for reading. Compressed files are decompressed transparently.
+FILE *open_input(const char *file_name);
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <GL/glew.h>
+#include "deletion_queue.h"
+
+
+// Nodes are pushed onto a lock-free stack. The render thread takes the whole stack at once and keeps the objects it
+// did not delete yet in a private list. Taking the whole stack instead of popping single nodes avoids the ABA
+// problem. The nodes are not allocated by the garbage collector because finalizers may run during a collection.
+typedef struct node_t {
+  struct node_t *next;
+  deletion_t type;
+  GLuint name;
+} node_t;
+
+static _Atomic(node_t *) queue_head = NULL;
+static node_t *pending = NULL;
+static node_t **pending_tail = &pending;
+static atomic_int_fast64_t n_queued = 0;
+static atomic_int_fast64_t n_completed = 0;
+
+void queue_deletion(deletion_t type, GLuint name)
+{
+  if (!name)
+    return;
+  node_t *node = malloc(sizeof(node_t));
+  node->type = type;
+  node->name = name;
+  node->next = atomic_load(&queue_head);
+  while (!atomic_compare_exchange_weak(&queue_head, &node->next, node));
+  atomic_fetch_add(&n_queued, 1);
+}
+
+static void delete_object(deletion_t type, GLuint name)
+{
+  switch (type) {
+  case DELETE_BUFFER:
+    glDeleteBuffers(1, &name);
+    break;
+  case DELETE_VERTEX_ARRAY:
+    glDeleteVertexArrays(1, &name);
+    break;
+  case DELETE_TEXTURE:
+    glDeleteTextures(1, &name);
+    break;
+  case DELETE_SHADER:
+    glDeleteShader(name);
+    break;
+  case DELETE_PROGRAM:
+    glDeleteProgram(name);
+    break;
+  };
+}
+
+// The newly queued nodes are deleted after the ones left over from earlier calls.
+static void take_queue(void)
+{
+  *pending_tail = atomic_exchange(&queue_head, NULL);
+  while (*pending_tail)
+    pending_tail = &(*pending_tail)->next;
+}
+
+int delete_queued(int max_count)
+{
+  take_queue();
+  int result = 0;
+  while (pending && (max_count <= 0 || result < max_count)) {
+    node_t *node = pending;
+    pending = node->next;
+    delete_object(node->type, node->name);
+    free(node);
+    result++;
+  };
+  if (!pending)
+    pending_tail = &pending;
+  atomic_fetch_add(&n_completed, result);
+  return result;
+}
+
+int64_t queued_deletions(void)
+{
+  return atomic_load(&n_queued);
+}
+
+int64_t completed_deletions(void)
+{
+  return atomic_load(&n_completed);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include <GL/gl.h>
+
+
+// Finalizers of the garbage collector run on arbitrary threads, possibly without a current OpenGL context. They
+// therefore only queue the names of OpenGL objects. The render thread deletes them at a frame boundary.
+// Queueing is lock-free and can be done from any thread. Deleting must only be done from the thread owning the
+// OpenGL context.
+typedef enum {
+  DELETE_BUFFER,
+  DELETE_VERTEX_ARRAY,
+  DELETE_TEXTURE,
+  DELETE_SHADER,
+  DELETE_PROGRAM
+} deletion_t;
+
+// Names which are zero are ignored.
+void queue_deletion(deletion_t type, GLuint name);
+
+// Delete at most max_count queued objects (all of them if max_count is not positive). Returns the number of deleted
+// objects.
+int delete_queued(int max_count);
+
+// Number of objects queued since the program started.
+int64_t queued_deletions(void);
+
+// Number of queued objects which have been deleted.
+int64_t completed_deletions(void);
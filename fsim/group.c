@@ -1,8 +1,19 @@
 #include <string.h>
-#include <gc.h>
+#include "memory.h"
 #include "group.h"
+#include "accounting.h"
 
 
+vertex_pool_t *make_vertex_pool(int stride)
+{
+  vertex_pool_t *retval = GC_MALLOC(sizeof(vertex_pool_t));
+  retval->array = make_list();
+  set_list_category(retval->array, MEMORY_GROUP);
+  retval->stride = stride;
+  account_allocation(MEMORY_GROUP, sizeof(vertex_pool_t));
+  return retval;
+}
+
 group_t *make_group(const char *name, int stride)
 {
   group_t *retval = GC_MALLOC(sizeof(group_t));
@@ -10,11 +21,32 @@ group_t *make_group(const char *name, int stride)
   strcpy(retval->name, name);
   retval->array = make_list();
   retval->vertex_index = make_list();
+  set_list_category(retval->array, MEMORY_GROUP);
+  set_list_category(retval->vertex_index, MEMORY_GROUP);
+  account_allocation(MEMORY_GROUP, sizeof(group_t) + strlen(name) + 1);
   retval->stride = stride;
   retval->material = NULL;
+  retval->pool = NULL;
+  memset(retval->bounds, 0, sizeof(retval->bounds));
   return retval;
 }
 
+void destroy_vertex_pool(vertex_pool_t *pool)
+{
+  destroy_list(pool->array);
+  account_release(MEMORY_GROUP, sizeof(vertex_pool_t));
+  GC_FREE(pool);
+}
+
+void destroy_group(group_t *group)
+{
+  account_release(MEMORY_GROUP, sizeof(group_t) + strlen(group->name) + 1);
+  GC_FREE(group->name);
+  destroy_list(group->array);
+  destroy_list(group->vertex_index);
+  GC_FREE(group);
+}
+
 void add_vertex_data(group_t *group, int n, ...)
 {
   va_list data;
@@ -24,26 +56,24 @@ void add_vertex_data(group_t *group, int n, ...)
     append_glfloat(group->array, va_arg(data, double));
 }
 
-int size_of_array(group_t *group)
+int64_t size_of_array(group_t *group)
 {
   return group->array->size * sizeof(GLfloat);
 }
 
-int size_of_indices(group_t *group)
+int64_t size_of_indices(group_t *group)
 {
   return group->vertex_index->size * sizeof(GLuint);
 }
 
 void add_triangle(group_t *group, int index1, int index2, int index3)
 {
-  append_gluint(group->vertex_index, index1);
-  append_gluint(group->vertex_index, index2);
-  append_gluint(group->vertex_index, index3);
+  append_gluint3(group->vertex_index, index1, index2, index3);
 }
 
 void extend_triangle(group_t *group, int index)
 {
-  int n = group->vertex_index->size;
+  int64_t n = group->vertex_index->size;
   int index1 = get_gluint(group->vertex_index)[n - 3];
   int index2 = get_gluint(group->vertex_index)[n - 1];
   add_triangle(group, index1, index2, index);
@@ -53,3 +83,57 @@ void use_material(group_t *group, material_t *material)
 {
   group->material = material;
 }
+
+void update_bounds(group_t *group)
+{
+  list_t *array = group->pool ? group->pool->array : group->array;
+  int stride = group->pool ? group->pool->stride : group->stride;
+  GLfloat *data = get_glfloat(array);
+  GLuint *index = get_gluint(group->vertex_index);
+  int64_t i;
+  for (i=0; i<group->vertex_index->size; i++) {
+    GLfloat *position = data + (int64_t)index[i] * stride;
+    int j;
+    for (j=0; j<3; j++) {
+      if (i == 0 || position[j] < group->bounds[j]) group->bounds[j] = position[j];
+      if (i == 0 || position[j] > group->bounds[j + 3]) group->bounds[j + 3] = position[j];
+    };
+  };
+}
+
+static void keep_positions(list_t *array, int stride)
+{
+  GLfloat *data = get_glfloat(array);
+  int64_t n = array->size / stride;
+  int64_t i;
+  for (i=0; i<n; i++)
+    memmove(data + 3 * i, data + stride * i, 3 * sizeof(GLfloat));
+  array->size = 3 * n;
+  shrink_glfloat(array);
+}
+
+void compact_group(group_t *group)
+{
+  update_bounds(group);
+  if (group->pool || group->stride <= 3)
+    return;
+  keep_positions(group->array, group->stride);
+  group->stride = 3;
+}
+
+void compact_vertex_pool(vertex_pool_t *pool)
+{
+  if (pool->stride <= 3)
+    return;
+  keep_positions(pool->array, pool->stride);
+  pool->stride = 3;
+}
+
+void release_group_data(group_t *group)
+{
+  update_bounds(group);
+  group->array->size = 0;
+  shrink_glfloat(group->array);
+  group->vertex_index->size = 0;
+  shrink_gluint(group->vertex_index);
+}
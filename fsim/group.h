@@ -5,24 +5,53 @@
 #include "material.h"
 
 
+// Vertex data shared by the groups of an object which have the same stride.
+typedef struct {
+  list_t *array;
+  int stride;
+} vertex_pool_t;
+
+// If the group uses a vertex pool, its own array is empty and the indices refer to the vertices of the pool.
+// The bounding box (lower and upper corner) is only valid after calling update_bounds.
 typedef struct {
   char *name;
   list_t *array;
   list_t *vertex_index;
   int stride;
   material_t *material;
+  vertex_pool_t *pool;
+  GLfloat bounds[6];
 } group_t;
 
+vertex_pool_t *make_vertex_pool(int stride);
+
 group_t *make_group(const char *name, int stride);
 
+void destroy_vertex_pool(vertex_pool_t *pool);
+
+// The material and the vertex pool of the group are not released because they can be shared with other groups.
+void destroy_group(group_t *group);
+
 void add_vertex_data(group_t *group, int n, ...);
 
-int size_of_array(group_t *group);
+int64_t size_of_array(group_t *group);
 
-int size_of_indices(group_t *group);
+int64_t size_of_indices(group_t *group);
 
 void add_triangle(group_t *group, int index1, int index2, int index3);
 
 void extend_triangle(group_t *group, int index);
 
 void use_material(group_t *group, material_t *material);
+
+// Compute the bounding box of the vertices referenced by the indices of the group.
+void update_bounds(group_t *group);
+
+// Keep only the vertex positions and the indices, which is sufficient for picking. The stride becomes 3. A vertex
+// pool is not compacted because other groups may still need its texture coordinates and normals.
+void compact_group(group_t *group);
+
+void compact_vertex_pool(vertex_pool_t *pool);
+
+// Release the vertex data and the indices. Only the bounding box is kept.
+void release_group_data(group_t *group);
@@ -1,9 +1,11 @@
 #include <string.h>
-#include <stdio.h>
-#include <gc.h>
+#include "memory.h"
 #include "hash.h"
+#include "accounting.h"
 
 
+#define INITIAL_CAPACITY 64
+
 static void finalize_hash(GC_PTR obj, GC_PTR env)
 {
   hash_t *result = (hash_t *)obj;
@@ -17,9 +19,26 @@ hash_t *make_hash(void)
   memset(result, 0, sizeof(hash_t));
   hcreate_r(65536, &result->table);
   result->items = make_list();
+  set_list_category(result->items, MEMORY_HASH);
+  account_allocation(MEMORY_HASH, sizeof(hash_t));
   return result;
 }
 
+void destroy_hash(hash_t *hash)
+{
+  GC_register_finalizer(hash, 0, 0, 0, 0);
+  hdestroy_r(&hash->table);
+  int i;
+  for (i=0; i<hash->items->size; i+=2) {
+    char *key = get_pointer(hash->items)[i];
+    account_release(MEMORY_HASH, strlen(key) + 1);
+    GC_FREE(key);
+  };
+  destroy_list(hash->items);
+  account_release(MEMORY_HASH, sizeof(hash_t));
+  GC_FREE(hash);
+}
+
 static void *hash_find_str(hash_t *hash, char *key, void *value_if_not_found)
 {
   ENTRY item = {key, value_if_not_found};
@@ -30,14 +49,107 @@ static void *hash_find_str(hash_t *hash, char *key, void *value_if_not_found)
   return result->data;
 }
 
-int hash_find_index(hash_t *hash, int key1, int key2, int key3, int value_if_not_found)
+static index_entry_t *allocate_entries(arena_t *arena, int capacity)
+{
+  int64_t size = capacity * sizeof(index_entry_t);
+  index_entry_t *result;
+  if (arena)
+    result = arena_alloc(arena, size);
+  else {
+    result = GC_MALLOC_ATOMIC(size);
+    account_allocation(MEMORY_HASH, size);
+  };
+  int i;
+  for (i=0; i<capacity; i++)
+    result[i].value = -1;
+  return result;
+}
+
+static void init_index_hash(index_hash_t *hash, arena_t *arena)
+{
+  hash->size = 0;
+  hash->capacity = INITIAL_CAPACITY;
+  hash->entry = allocate_entries(arena, INITIAL_CAPACITY);
+  hash->arena = arena;
+}
+
+index_hash_t *make_index_hash(void)
+{
+  index_hash_t *result = GC_MALLOC(sizeof(index_hash_t));
+  account_allocation(MEMORY_HASH, sizeof(index_hash_t));
+  init_index_hash(result, NULL);
+  return result;
+}
+
+index_hash_t *make_arena_index_hash(arena_t *arena)
+{
+  index_hash_t *result = arena_alloc(arena, sizeof(index_hash_t));
+  init_index_hash(result, arena);
+  return result;
+}
+
+void destroy_index_hash(index_hash_t *hash)
+{
+  if (hash->arena)
+    arena_free(hash->arena, hash->entry, hash->capacity * sizeof(index_entry_t));
+  else {
+    account_release(MEMORY_HASH, hash->capacity * sizeof(index_entry_t) + sizeof(index_hash_t));
+    GC_FREE(hash->entry);
+    GC_FREE(hash);
+  };
+}
+
+static unsigned int hash_key(int key1, int key2, int key3)
+{
+  unsigned int result = key1 * 0x9e3779b1u ^ key2 * 0x85ebca77u ^ key3 * 0xc2b2ae3du;
+  return result ^ (result >> 16);
+}
+
+// Linear probing ends at the entry with the key or at an empty entry.
+static index_entry_t *find_entry(index_entry_t *entry, int capacity, int key1, int key2, int key3)
+{
+  unsigned int mask = capacity - 1;
+  unsigned int i = hash_key(key1, key2, key3) & mask;
+  while (entry[i].value >= 0 && (entry[i].key[0] != key1 || entry[i].key[1] != key2 || entry[i].key[2] != key3))
+    i = (i + 1) & mask;
+  return &entry[i];
+}
+
+static void grow_index_hash(index_hash_t *hash)
+{
+  int capacity = 2 * hash->capacity;
+  index_entry_t *entry = allocate_entries(hash->arena, capacity);
+  int i;
+  for (i=0; i<hash->capacity; i++) {
+    index_entry_t *source = &hash->entry[i];
+    if (source->value >= 0)
+      *find_entry(entry, capacity, source->key[0], source->key[1], source->key[2]) = *source;
+  };
+  if (hash->arena)
+    arena_free(hash->arena, hash->entry, hash->capacity * sizeof(index_entry_t));
+  else {
+    account_release(MEMORY_HASH, hash->capacity * sizeof(index_entry_t));
+    GC_FREE(hash->entry);
+  };
+  hash->capacity = capacity;
+  hash->entry = entry;
+}
+
+int hash_find_index(index_hash_t *hash, int key1, int key2, int key3, int value_if_not_found)
 {
-  const int keysize = 30;
-  char *str = GC_MALLOC_ATOMIC(keysize);
-  snprintf(str, keysize, "%d,%d,%d", key1, key2, key3);
-  long int result = value_if_not_found;
-  result = (long int)hash_find_str(hash, str, (void *)result);
-  return (int)result;
+  index_entry_t *entry = find_entry(hash->entry, hash->capacity, key1, key2, key3);
+  if (entry->value >= 0)
+    return entry->value;
+  if (2 * (hash->size + 1) > hash->capacity) {
+    grow_index_hash(hash);
+    entry = find_entry(hash->entry, hash->capacity, key1, key2, key3);
+  };
+  entry->key[0] = key1;
+  entry->key[1] = key2;
+  entry->key[2] = key3;
+  entry->value = value_if_not_found;
+  hash->size++;
+  return value_if_not_found;
 }
 
 material_t *hash_find_material(hash_t *hash, const char *key, material_t *material)
@@ -45,7 +157,10 @@ material_t *hash_find_material(hash_t *hash, const char *key, material_t *materi
   char *str = GC_MALLOC_ATOMIC(strlen(key) + 1);
   strcpy(str, key);
   material_t *result = hash_find_str(hash, str, material);
-  if (result == material)
+  if (result == material) {
     append_pointer(hash->items, material);
+    account_allocation(MEMORY_HASH, strlen(key) + 1);
+  } else
+    GC_FREE(str);
   return result;
 }
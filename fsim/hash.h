@@ -1,7 +1,10 @@
 #pragma once
 #define _GNU_SOURCE
+#ifndef __USE_GNU
 #define __USE_GNU
+#endif
 #include <search.h>
+#include "arena.h"
 #include "list.h"
 #include "material.h"
 
@@ -11,8 +14,34 @@ typedef struct {
   list_t *items;
 } hash_t;
 
+// Open-addressing table mapping vertex, texture coordinate and normal index triples to vertex indices.
+// The entries are stored in one flat array which is doubled when it is half full.
+typedef struct {
+  int key[3];
+  int value;
+} index_entry_t;
+
+typedef struct {
+  int size;
+  int capacity;
+  index_entry_t *entry;
+  arena_t *arena;
+} index_hash_t;
+
 hash_t *make_hash(void);
 
-int hash_find_index(hash_t *hash, int key1, int key2, int key3, int value_if_not_found);
+index_hash_t *make_index_hash(void);
+
+// Index table which is allocated from an arena together with its entries.
+index_hash_t *make_arena_index_hash(arena_t *arena);
+
+// Release the table and its copies of the keys. The materials are not released.
+void destroy_hash(hash_t *hash);
+
+// Tables allocated from an arena are released together with the arena.
+void destroy_index_hash(index_hash_t *hash);
+
+// Values must not be negative.
+int hash_find_index(index_hash_t *hash, int key1, int key2, int key3, int value_if_not_found);
 
 material_t *hash_find_material(hash_t *hash, const char *key, material_t *material);
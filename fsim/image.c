@@ -1,10 +1,28 @@
-#include <gc.h>
+#include <string.h>
+#define GC_THREADS
+#include "memory.h"
+#include <pthread.h>
 #include <magick/MagickCore.h>
 #include "image.h"
+#include "accounting.h"
 
 
+static int64_t image_bytes(image_t *image)
+{
+  return sizeof(image_t) + (int64_t)image->width * image->height * 3 + strlen(image->file_name) + 1;
+}
+
+static pthread_once_t magick_once = PTHREAD_ONCE_INIT;
+
+// Images are decoded concurrently, so ImageMagick has to be initialised before the first image is read.
+static void setup_magick(void)
+{
+  MagickCoreGenesis(NULL, MagickFalse);
+}
+
 image_t *read_image(const char *file_name)
 {
+  pthread_once(&magick_once, setup_magick);
   image_t *retval = NULL;
   ExceptionInfo *exception_info = AcquireExceptionInfo();
   ImageInfo *image_info = CloneImageInfo((ImageInfo *)NULL);
@@ -20,12 +38,17 @@ image_t *read_image(const char *file_name)
     retval->width = flipped->columns;
     retval->height = flipped->rows;
     retval->data = GC_MALLOC_ATOMIC(flipped->rows * flipped->columns * 3);
+    retval->file_name = GC_MALLOC_ATOMIC(strlen(file_name) + 1);
+    strcpy(retval->file_name, file_name);
     ExportImagePixels(flipped, 0, 0, flipped->columns, flipped->rows, "BGR", CharPixel, retval->data, exception_info);
     if (exception_info->severity < ErrorException)
       CatchException(exception_info);
     DestroyImage(flipped);
+    account_allocation(MEMORY_IMAGE, image_bytes(retval));
   };
   if (exception_info->severity >= ErrorException) {
+    if (retval)
+      destroy_image(retval);
     retval = NULL;
     fprintf(stderr, "%s\n", exception_info->reason);
     CatchException(exception_info);
@@ -34,3 +57,11 @@ image_t *read_image(const char *file_name)
   DestroyExceptionInfo(exception_info);
   return retval;
 }
+
+void destroy_image(image_t *image)
+{
+  account_release(MEMORY_IMAGE, image_bytes(image));
+  GC_FREE(image->data);
+  GC_FREE(image->file_name);
+  GC_FREE(image);
+}
@@ -6,6 +6,9 @@ typedef struct
   int width;
   int height;
   unsigned char *data;
+  char *file_name;
 } image_t;
 
 image_t *read_image(const char *file_name);
+
+void destroy_image(image_t *image);
@@ -0,0 +1,81 @@
+#include <string.h>
+#include <unistd.h>
+#define GC_THREADS
+#include "memory.h"
+#include <pthread.h>
+#include "image_pool.h"
+
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static image_request_t *queue_head = NULL;
+static image_request_t *queue_tail = NULL;
+
+static void *decode_images(void *data)
+{
+  while (1) {
+    pthread_mutex_lock(&pool_mutex);
+    while (!queue_head)
+      pthread_cond_wait(&pool_queued, &pool_mutex);
+    image_request_t *request = queue_head;
+    queue_head = request->next;
+    if (!queue_head) queue_tail = NULL;
+    request->next = NULL;
+    pthread_mutex_unlock(&pool_mutex);
+    image_t *image = read_image(request->file_name);
+    pthread_mutex_lock(&pool_mutex);
+    request->image = image;
+    request->done = 1;
+    pthread_cond_broadcast(&pool_done);
+    pthread_mutex_unlock(&pool_mutex);
+  };
+  return NULL;
+}
+
+static void start_pool(void)
+{
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int i;
+  for (i=0; i<n_threads; i++) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, decode_images, NULL);
+    pthread_detach(thread);
+  };
+}
+
+image_request_t *request_image(const char *file_name)
+{
+  pthread_once(&pool_once, start_pool);
+  image_request_t *result = GC_MALLOC(sizeof(image_request_t));
+  result->file_name = GC_MALLOC_ATOMIC(strlen(file_name) + 1);
+  strcpy(result->file_name, file_name);
+  result->image = NULL;
+  result->done = 0;
+  result->next = NULL;
+  pthread_mutex_lock(&pool_mutex);
+  if (queue_tail)
+    queue_tail->next = result;
+  else
+    queue_head = result;
+  queue_tail = result;
+  pthread_cond_signal(&pool_queued);
+  pthread_mutex_unlock(&pool_mutex);
+  return result;
+}
+
+image_t *wait_for_image(image_request_t *request)
+{
+  pthread_mutex_lock(&pool_mutex);
+  while (!request->done)
+    pthread_cond_wait(&pool_done, &pool_mutex);
+  pthread_mutex_unlock(&pool_mutex);
+  return request->image;
+}
+
+void destroy_image_request(image_request_t *request)
+{
+  GC_FREE(request->file_name);
+  GC_FREE(request);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "image.h"
+
+
+// Images are decoded on a pool of worker threads, which is started when the first image is requested.
+typedef struct image_request_t {
+  char *file_name;
+  image_t *image;
+  int done;
+  struct image_request_t *next;
+} image_request_t;
+
+image_request_t *request_image(const char *file_name);
+
+// Wait until the image has been decoded. Returns NULL if the image could not be read. The caller owns the image.
+image_t *wait_for_image(image_request_t *request);
+
+// Release a request after waiting for it. The image is not released.
+void destroy_image_request(image_request_t *request);
@@ -1,5 +1,5 @@
 #include <string.h>
-#include <gc.h>
+#include "memory.h"
 #include "list.h"
 
 list_t *make_list(void)
@@ -8,33 +8,164 @@ list_t *make_list(void)
   result->size = 0;
   result->buffer_size = 0;
   result->element = NULL;
+  result->arena = NULL;
+  result->category = MEMORY_LIST;
+  account_allocation(MEMORY_LIST, sizeof(list_t));
   return result;
 }
 
-static void grow_list(list_t *list, int element_size, char atomic)
+list_t *make_arena_list(arena_t *arena)
 {
-  if (list->buffer_size < (list->size + 1) * element_size) {
-    list->buffer_size = list->buffer_size ? 2 * list->buffer_size : element_size;
-    GLuint *space = atomic ? GC_MALLOC_ATOMIC(list->buffer_size) : GC_MALLOC(list->buffer_size);
-    memcpy(space, list->element, list->size * element_size);
-    list->element = space;
+  list_t *result = make_list();
+  result->arena = arena;
+  return result;
+}
+
+// Arena storage is accounted by the arena.
+static int64_t accounted_bytes(list_t *list)
+{
+  return list->arena ? 0 : list->buffer_size;
+}
+
+void set_list_category(list_t *list, memory_category_t category)
+{
+  account_release(list->category, sizeof(list_t) + accounted_bytes(list));
+  list->category = category;
+  account_allocation(category, sizeof(list_t) + accounted_bytes(list));
+}
+
+void destroy_list(list_t *list)
+{
+  account_release(list->category, sizeof(list_t) + accounted_bytes(list));
+  if (list->arena)
+    arena_free(list->arena, list->element, list->buffer_size);
+  else
+    GC_FREE(list->element);
+  GC_FREE(list);
+}
+
+// Existing blocks are resized with GC_REALLOC which keeps the kind (atomic or not) of the block.
+static void resize_list(list_t *list, int64_t buffer_size, char atomic)
+{
+  if (list->arena)
+    list->element = arena_realloc(list->arena, list->element, list->buffer_size, buffer_size);
+  else {
+    if (!list->element)
+      list->element = atomic ? GC_MALLOC_ATOMIC(buffer_size) : GC_MALLOC(buffer_size);
+    else
+      list->element = GC_REALLOC(list->element, buffer_size);
+    account_resize(list->category, list->buffer_size, buffer_size);
   };
+  list->buffer_size = buffer_size;
+}
+
+static void reserve_list(list_t *list, int64_t n, int64_t element_size, char atomic)
+{
+  if (list->buffer_size < n * element_size)
+    resize_list(list, n * element_size, atomic);
+}
+
+static void grow_list(list_t *list, int64_t n, int64_t element_size, char atomic)
+{
+  if (list->buffer_size < (list->size + n) * element_size) {
+    int64_t capacity = list->buffer_size ? 2 * list->buffer_size / element_size : 1;
+    reserve_list(list, capacity < list->size + n ? list->size + n : capacity, element_size, atomic);
+  };
+}
+
+static void shrink_list(list_t *list, int64_t element_size)
+{
+  if (!list->size) {
+    if (list->arena)
+      arena_free(list->arena, list->element, list->buffer_size);
+    else {
+      GC_FREE(list->element);
+      account_resize(list->category, list->buffer_size, 0);
+    };
+    list->element = NULL;
+    list->buffer_size = 0;
+  } else if (list->buffer_size > list->size * element_size)
+    resize_list(list, list->size * element_size, 0);
+}
+
+void reserve_gluint(list_t *list, int64_t n)
+{
+  reserve_list(list, n, sizeof(GLuint), 1);
+}
+
+void reserve_glfloat(list_t *list, int64_t n)
+{
+  reserve_list(list, n, sizeof(GLfloat), 1);
+}
+
+void reserve_pointer(list_t *list, int64_t n)
+{
+  reserve_list(list, n, sizeof(void *), 0);
 }
 
 void append_gluint(list_t *list, GLuint value)
 {
-  grow_list(list, sizeof(GLuint), 1);
+  grow_list(list, 1, sizeof(GLuint), 1);
   ((GLuint *)list->element)[list->size++] = value;
 }
 
+void append_gluint3(list_t *list, GLuint value1, GLuint value2, GLuint value3)
+{
+  grow_list(list, 3, sizeof(GLuint), 1);
+  GLuint *p = (GLuint *)list->element + list->size;
+  p[0] = value1;
+  p[1] = value2;
+  p[2] = value3;
+  list->size += 3;
+}
+
+void append_gluints(list_t *list, const GLuint *values, int64_t n)
+{
+  grow_list(list, n, sizeof(GLuint), 1);
+  memcpy((GLuint *)list->element + list->size, values, n * sizeof(GLuint));
+  list->size += n;
+}
+
 void append_glfloat(list_t *list, GLfloat value)
 {
-  grow_list(list, sizeof(GLfloat), 1);
+  grow_list(list, 1, sizeof(GLfloat), 1);
   ((GLfloat *)list->element)[list->size++] = value;
 }
 
+void append_glfloat3(list_t *list, GLfloat value1, GLfloat value2, GLfloat value3)
+{
+  grow_list(list, 3, sizeof(GLfloat), 1);
+  GLfloat *p = (GLfloat *)list->element + list->size;
+  p[0] = value1;
+  p[1] = value2;
+  p[2] = value3;
+  list->size += 3;
+}
+
+void append_glfloats(list_t *list, const GLfloat *values, int64_t n)
+{
+  grow_list(list, n, sizeof(GLfloat), 1);
+  memcpy((GLfloat *)list->element + list->size, values, n * sizeof(GLfloat));
+  list->size += n;
+}
+
 void append_pointer(list_t *list, void *value)
 {
-  grow_list(list, sizeof(void *), 0);
+  grow_list(list, 1, sizeof(void *), 0);
   ((void **)list->element)[list->size++] = value;
 }
+
+void shrink_gluint(list_t *list)
+{
+  shrink_list(list, sizeof(GLuint));
+}
+
+void shrink_glfloat(list_t *list)
+{
+  shrink_list(list, sizeof(GLfloat));
+}
+
+void shrink_pointer(list_t *list)
+{
+  shrink_list(list, sizeof(void *));
+}
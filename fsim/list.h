@@ -1,22 +1,62 @@
 #pragma once
+#include <stdint.h>
 #include <GL/gl.h>
+#include "arena.h"
+#include "accounting.h"
 
+// Growable vector. The size is the number of elements and the buffer size is the allocated storage in bytes.
+// The elements are allocated from the arena if there is one and from the garbage collected heap otherwise.
+// Storage outside arenas is accounted to the category of the list (MEMORY_LIST by default).
 typedef struct {
-  int size;
-  int buffer_size;
+  int64_t size;
+  int64_t buffer_size;
   void *element;
+  arena_t *arena;
+  memory_category_t category;
 } list_t;
 
 list_t *make_list(void);
 
+// List for temporary data which must not contain the only references to collectable objects.
+list_t *make_arena_list(arena_t *arena);
+
+// Move the accounted storage of the list to another category.
+void set_list_category(list_t *list, memory_category_t category);
+
+// Release the list and its buffer. Objects referenced by the elements are not released.
+void destroy_list(list_t *list);
+
+// Allocate space for n elements at once.
+void reserve_gluint(list_t *list, int64_t n);
+
+void reserve_glfloat(list_t *list, int64_t n);
+
+void reserve_pointer(list_t *list, int64_t n);
+
 void append_gluint(list_t *list, GLuint value);
 
+void append_gluint3(list_t *list, GLuint value1, GLuint value2, GLuint value3);
+
+// Append n values with a single capacity check.
+void append_gluints(list_t *list, const GLuint *values, int64_t n);
+
 static GLuint *get_gluint(list_t *list) { return (GLuint *)list->element; }
 
 void append_glfloat(list_t *list, GLfloat value);
 
+void append_glfloat3(list_t *list, GLfloat value1, GLfloat value2, GLfloat value3);
+
+void append_glfloats(list_t *list, const GLfloat *values, int64_t n);
+
 static GLfloat *get_glfloat(list_t *list) { return (GLfloat *)list->element; }
 
 void append_pointer(list_t *list, void *value);
 
 static void **get_pointer(list_t *list) { return (void **)list->element; }
+
+// Release the storage beyond the current size.
+void shrink_gluint(list_t *list);
+
+void shrink_glfloat(list_t *list);
+
+void shrink_pointer(list_t *list);
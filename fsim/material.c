@@ -1,6 +1,8 @@
-#include <gc.h>
+#include <string.h>
+#include "memory.h"
 #include <GL/glew.h>
 #include "material.h"
+#include "accounting.h"
 
 
 material_t *make_material(void)
@@ -21,9 +23,19 @@ material_t *make_material(void)
   result->disolve = 1.0f;
   result->diffuse_texture = NULL;
   result->specular_texture = NULL;
+  result->cached = 0;
   return result;
 }
 
+void destroy_material(material_t *material)
+{
+  if (material->diffuse_texture)
+    destroy_texture(material->diffuse_texture);
+  if (material->specular_texture)
+    destroy_texture(material->specular_texture);
+  GC_FREE(material);
+}
+
 void set_illumination(material_t *material, int illumination)
 {
   material->illumination = illumination;
@@ -69,8 +81,12 @@ static texture_t *setup_texture(const char *name, image_t *image)
 {
   if (!image) return NULL;
   texture_t *result = make_texture(name);
+  result->file_name = GC_MALLOC_ATOMIC(strlen(image->file_name) + 1);
+  strcpy(result->file_name, image->file_name);
   glBindTexture(GL_TEXTURE_2D, result->texture);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->width, image->height, 0, GL_BGR, GL_UNSIGNED_BYTE, image->data);
+  result->bytes = (int64_t)image->width * image->height * 3;
+  account_allocation(MEMORY_GL_TEXTURE, result->bytes);
   // http://www.opengl-tutorial.org/beginners-tutorials/tutorial-5-a-textured-cube/
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
@@ -85,12 +101,95 @@ static texture_t *setup_texture(const char *name, image_t *image)
   return result;
 }
 
+static void replace_texture(texture_t **target, texture_t *texture)
+{
+  if (*target)
+    destroy_texture(*target);
+  *target = texture;
+}
+
 void set_diffuse_texture(material_t *material, image_t *image)
 {
-  material->diffuse_texture = setup_texture("map_Kd", image);
+  replace_texture(&material->diffuse_texture, setup_texture("map_Kd", image));
 }
 
 void set_specular_texture(material_t *material, image_t *image)
 {
-  material->specular_texture = setup_texture("map_Ks", image);
+  replace_texture(&material->specular_texture, setup_texture("map_Ks", image));
+}
+
+static texture_t **texture_target(pending_texture_t *texture)
+{
+  return texture->specular ? &texture->material->specular_texture : &texture->material->diffuse_texture;
+}
+
+static pending_texture_t *request_texture(material_t *material, char specular, const char *file_name)
+{
+  pending_texture_t *result = GC_MALLOC(sizeof(pending_texture_t));
+  result->material = material;
+  result->specular = specular;
+  result->request = NULL;
+  result->entry = NULL;
+  if (get_texture_cache())
+    result->entry = request_texture_entry(specular ? "map_Ks" : "map_Kd", file_name, result);
+  if (!result->entry || loads_texture_entry(result->entry, result))
+    result->request = request_image(file_name);
+  return result;
+}
+
+pending_texture_t *request_diffuse_texture(material_t *material, const char *file_name)
+{
+  return request_texture(material, 0, file_name);
+}
+
+pending_texture_t *request_specular_texture(material_t *material, const char *file_name)
+{
+  return request_texture(material, 1, file_name);
+}
+
+// A texture shared with an earlier request waits for it. Requests of other threads are only waited for because
+// their textures have to be uploaded with the OpenGL context of their thread.
+void upload_texture(pending_texture_t *texture)
+{
+  texture_entry_t *entry = texture->entry;
+  if (entry && !loads_texture_entry(entry, texture)) {
+    texture->entry = NULL;
+    pending_texture_t *loader;
+    while ((loader = wait_for_texture_entry(entry)))
+      upload_texture(loader);
+    replace_texture(texture_target(texture), share_texture(entry));
+    return;
+  };
+  if (!texture->request) {
+    if (entry)
+      complete_texture_entry(entry, NULL);
+    texture->entry = NULL;
+    return;
+  };
+  image_t *image = wait_for_image(texture->request);
+  if (texture->specular)
+    set_specular_texture(texture->material, image);
+  else
+    set_diffuse_texture(texture->material, image);
+  if (image)
+    destroy_image(image);
+  destroy_image_request(texture->request);
+  texture->request = NULL;
+  if (entry) {
+    complete_texture_entry(entry, *texture_target(texture));
+    texture->entry = NULL;
+  };
+}
+
+void destroy_pending_texture(pending_texture_t *texture)
+{
+  if (texture->entry && loads_texture_entry(texture->entry, texture))
+    complete_texture_entry(texture->entry, NULL);
+  if (texture->request) {
+    image_t *image = wait_for_image(texture->request);
+    if (image)
+      destroy_image(image);
+    destroy_image_request(texture->request);
+  };
+  GC_FREE(texture);
 }
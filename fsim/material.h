@@ -1,7 +1,9 @@
 #pragma once
 #include <GL/gl.h>
 #include "texture.h"
+#include "texture_cache.h"
 #include "image.h"
+#include "image_pool.h"
 
 
 typedef struct
@@ -15,10 +17,15 @@ typedef struct
   GLfloat disolve;
   texture_t *diffuse_texture;
   texture_t *specular_texture;
+  char cached;
 } material_t;
 
+// A material owns its textures. Materials of the material library cache are marked as cached.
 material_t* make_material(void);
 
+// Release the material and delete its textures. This requires the OpenGL context to be current.
+void destroy_material(material_t *material);
+
 void set_illumination(material_t *material, int illumination);
 
 void set_ambient(material_t *material, GLfloat red, GLfloat green, GLfloat blue);
@@ -36,3 +43,23 @@ void set_disolve(material_t *material, GLfloat disolve);
 void set_diffuse_texture(material_t *material, image_t *texture);
 
 void set_specular_texture(material_t *material, image_t *texture);
+
+// Texture image which is decoded in the background while the rest of the file is read. With the texture cache enabled
+// only the first request for an image decodes it and the others share its texture.
+typedef struct pending_texture_t
+{
+  material_t *material;
+  char specular;
+  image_request_t *request;
+  texture_entry_t *entry;
+} pending_texture_t;
+
+pending_texture_t *request_diffuse_texture(material_t *material, const char *file_name);
+
+pending_texture_t *request_specular_texture(material_t *material, const char *file_name);
+
+// Wait for the image and upload it. This has to be called on the thread with the OpenGL context.
+void upload_texture(pending_texture_t *texture);
+
+// Release a pending texture. A texture which was not uploaded yet is waited for and discarded.
+void destroy_pending_texture(pending_texture_t *texture);
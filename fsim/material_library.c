@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "memory.h"
+#include "material_library.h"
+
+
+static int material_library_cache = 0;
+static pthread_mutex_t library_mutex = PTHREAD_MUTEX_INITIALIZER;
+static list_t *libraries = NULL;
+static int64_t hits = 0;
+static int64_t misses = 0;
+
+void set_material_library_cache(int enabled)
+{
+  material_library_cache = enabled;
+}
+
+int get_material_library_cache(void)
+{
+  return material_library_cache;
+}
+
+// The canonical path is copied to the heap of the library.
+static char *canonical_name(const char *file_name, struct stat *st)
+{
+  char *path = realpath(file_name, NULL);
+  if (!path)
+    return NULL;
+  char *result = NULL;
+  if (!stat(path, st)) {
+    result = GC_MALLOC_ATOMIC(strlen(path) + 1);
+    strcpy(result, path);
+  };
+  free(path);
+  return result;
+}
+
+material_library_t *make_material_library(const char *file_name)
+{
+  struct stat st;
+  char *name = canonical_name(file_name, &st);
+  if (!name)
+    return NULL;
+  material_library_t *result = GC_MALLOC(sizeof(material_library_t));
+  result->file_name = name;
+  result->mtime = st.st_mtim;
+  result->size = st.st_size;
+  result->name = make_list();
+  result->material = make_list();
+  return result;
+}
+
+void add_library_material(material_library_t *library, const char *name, material_t *material)
+{
+  char *copy = GC_MALLOC_ATOMIC(strlen(name) + 1);
+  strcpy(copy, name);
+  append_pointer(library->name, copy);
+  append_pointer(library->material, material);
+}
+
+void destroy_material_library(material_library_t *library)
+{
+  int i;
+  for (i=0; i<library->name->size; i++)
+    GC_FREE(get_pointer(library->name)[i]);
+  destroy_list(library->name);
+  destroy_list(library->material);
+  GC_FREE(library->file_name);
+  GC_FREE(library);
+}
+
+static int same_file(material_library_t *library, const char *file_name, struct stat *st)
+{
+  return !strcmp(library->file_name, file_name) && library->mtime.tv_sec == st->st_mtim.tv_sec &&
+         library->mtime.tv_nsec == st->st_mtim.tv_nsec && library->size == st->st_size;
+}
+
+// The caller holds the mutex.
+static material_library_t *lookup(const char *file_name, struct stat *st)
+{
+  int i;
+  for (i=0; libraries && i<libraries->size; i++) {
+    material_library_t *library = get_pointer(libraries)[i];
+    if (same_file(library, file_name, st))
+      return library;
+  };
+  return NULL;
+}
+
+material_library_t *find_material_library(const char *file_name)
+{
+  struct stat st;
+  char *name = canonical_name(file_name, &st);
+  if (!name)
+    return NULL;
+  pthread_mutex_lock(&library_mutex);
+  material_library_t *result = lookup(name, &st);
+  if (result)
+    hits++;
+  else
+    misses++;
+  pthread_mutex_unlock(&library_mutex);
+  GC_FREE(name);
+  return result;
+}
+
+int cache_material_library(material_library_t *library)
+{
+  struct stat st;
+  st.st_mtim = library->mtime;
+  st.st_size = library->size;
+  pthread_mutex_lock(&library_mutex);
+  int result = !lookup(library->file_name, &st);
+  if (result) {
+    int i;
+    for (i=0; i<library->material->size; i++)
+      ((material_t *)get_pointer(library->material)[i])->cached = 1;
+    if (!libraries)
+      libraries = make_list();
+    append_pointer(libraries, library);
+  };
+  pthread_mutex_unlock(&library_mutex);
+  return result;
+}
+
+void clear_material_library_cache(void)
+{
+  pthread_mutex_lock(&library_mutex);
+  int i;
+  for (i=0; libraries && i<libraries->size; i++) {
+    material_library_t *library = get_pointer(libraries)[i];
+    int j;
+    for (j=0; j<library->material->size; j++)
+      destroy_material(get_pointer(library->material)[j]);
+    destroy_material_library(library);
+  };
+  if (libraries)
+    destroy_list(libraries);
+  libraries = NULL;
+  hits = 0;
+  misses = 0;
+  pthread_mutex_unlock(&library_mutex);
+}
+
+int64_t material_library_hits(void)
+{
+  pthread_mutex_lock(&library_mutex);
+  int64_t result = hits;
+  pthread_mutex_unlock(&library_mutex);
+  return result;
+}
+
+int64_t material_library_misses(void)
+{
+  pthread_mutex_lock(&library_mutex);
+  int64_t result = misses;
+  pthread_mutex_unlock(&library_mutex);
+  return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <time.h>
+#include <sys/types.h>
+#include "list.h"
+#include "material.h"
+
+
+// Materials defined by one material library file. The cache of material libraries is shared by all parsers of the
+// process so that objects using the same library get the same materials and textures. A library is identified by
+// its canonical path, its modification time and its size. A changed file is read again and cached as a new library.
+// The materials of cached libraries are owned by the cache and are not released together with the objects.
+typedef struct {
+  char *file_name;
+  struct timespec mtime;
+  off_t size;
+  list_t *name;
+  list_t *material;
+} material_library_t;
+
+void set_material_library_cache(int enabled);
+
+int get_material_library_cache(void);
+
+// Start recording the materials of a library file. Returns NULL if the file does not exist.
+material_library_t *make_material_library(const char *file_name);
+
+void add_library_material(material_library_t *library, const char *name, material_t *material);
+
+// Release a library which was not added to the cache. The materials are not released.
+void destroy_material_library(material_library_t *library);
+
+// Get the cached library for the file if it did not change since it was read.
+material_library_t *find_material_library(const char *file_name);
+
+// Hand a library over to the cache. Returns 0 and leaves the library with the caller if another parser cached the
+// same file in the meantime.
+int cache_material_library(material_library_t *library);
+
+// Release all cached libraries and their materials. Textures are deleted, so the OpenGL context has to be current.
+// Objects must not use the materials any more.
+void clear_material_library_cache(void);
+
+int64_t material_library_hits(void);
+
+int64_t material_library_misses(void);
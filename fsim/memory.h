@@ -0,0 +1,31 @@
+#pragma once
+// librender allocates through the Boehm garbage collector unless it is configured with --disable-gc, which defines
+// FSIM_NO_GC. Without the collector the allocation macros map to the C library, finalizers and disappearing links
+// are not registered and all objects have to be released with the destroy_* functions. Define GC_THREADS before
+// including this header in files which create threads.
+#ifdef FSIM_NO_GC
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef void *GC_PTR;
+typedef uintptr_t GC_hidden_pointer;
+typedef enum {GC_EVENT_START, GC_EVENT_END} GC_EventType;
+
+#define GC_MALLOC(size) calloc(1, size)
+#define GC_MALLOC_ATOMIC(size) malloc(size)
+#define GC_REALLOC(data, size) realloc(data, size)
+#define GC_FREE(data) free(data)
+#define GC_register_finalizer(obj, fn, cd, ofn, ocd) ((void)(fn))
+#define GC_INIT() ((void)0)
+#define GC_gcollect() ((void)0)
+#define GC_get_total_bytes() ((size_t)0)
+#define GC_get_gc_no() ((size_t)0)
+#define GC_set_on_collection_event(fn) ((void)(fn))
+#define GC_HIDE_POINTER(p) (~(GC_hidden_pointer)(p))
+#define GC_REVEAL_POINTER(p) ((void *)GC_HIDE_POINTER(p))
+#define GC_general_register_disappearing_link(link, obj) ((void)0)
+#define GC_unregister_disappearing_link(link) ((void)0)
+#define GC_call_with_alloc_lock(fn, data) ((fn)(data))
+#else
+#include <gc.h>
+#endif
@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "number.h"
+
+
+// A mantissa of up to 53 bits multiplied or divided by an exactly representable power of ten is correctly
+// rounded. The result is therefore identical to the one returned by strtod.
+// https://www.exploringbinary.com/fast-path-decimal-to-floating-point-conversion/
+static const double power_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+  1e20, 1e21, 1e22
+};
+
+#define MAX_POWER 22
+#define MAX_DIGITS 19
+#define MAX_MANTISSA (1ULL << 53)
+
+static int is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// The text has already been checked to be a decimal number.
+static void parse_float_slow(const char *p, const char *q, float *result)
+{
+  char small[64];
+  char *buffer = q - p < sizeof(small) ? small : malloc(q - p + 1);
+  memcpy(buffer, p, q - p);
+  buffer[q - p] = '\0';
+  *result = strtod(buffer, NULL);
+  if (buffer != small)
+    free(buffer);
+}
+
+static const char *parse_digits(const char *p, const char *end, uint64_t *mantissa, int *n_digits)
+{
+  while (p < end && is_digit(*p)) {
+    *mantissa = *mantissa * 10 + (*p++ - '0');
+    if (*mantissa) (*n_digits)++;
+  };
+  return p;
+}
+
+static const char *parse_exponent(const char *p, const char *end, int *exponent)
+{
+  const char *q = p + 1;
+  int negative = 0;
+  if (q < end && (*q == '-' || *q == '+'))
+    negative = *q++ == '-';
+  if (q == end || !is_digit(*q))
+    return p;
+  int value = 0;
+  while (q < end && is_digit(*q)) {
+    if (value < 10000) value = value * 10 + (*q - '0');
+    q++;
+  };
+  *exponent += negative ? -value : value;
+  return q;
+}
+
+const char *parse_float(const char *p, const char *end, float *result)
+{
+  const char *q = p;
+  int negative = 0;
+  if (q < end && (*q == '-' || *q == '+'))
+    negative = *q++ == '-';
+  uint64_t mantissa = 0;
+  int n_digits = 0;
+  const char *integer = q;
+  q = parse_digits(q, end, &mantissa, &n_digits);
+  int n_integer = q - integer;
+  int n_fraction = 0;
+  if (q < end && *q == '.') {
+    const char *fraction = q + 1;
+    const char *fraction_end = parse_digits(fraction, end, &mantissa, &n_digits);
+    n_fraction = fraction_end - fraction;
+    if (n_integer + n_fraction > 0)
+      q = fraction_end;
+  };
+  if (n_integer + n_fraction == 0)
+    return NULL;
+  int exponent = -n_fraction;
+  if (q < end && *q == 'e')
+    q = parse_exponent(q, end, &exponent);
+  if (mantissa == 0) {
+    *result = negative ? -0.0f : 0.0f;
+    return q;
+  };
+  if (n_digits > MAX_DIGITS || mantissa > MAX_MANTISSA || exponent < -MAX_POWER || exponent > MAX_POWER) {
+    parse_float_slow(p, q, result);
+    return q;
+  };
+  double value = mantissa;
+  value = exponent < 0 ? value / power_of_ten[-exponent] : value * power_of_ten[exponent];
+  *result = negative ? -value : value;
+  return q;
+}
+
+const char *parse_int(const char *p, const char *end, int *result)
+{
+  int64_t limit = INT_MAX;
+  int sign = 1;
+  int64_t value = 0;
+  if (p < end && *p == '-') {
+    limit = -(int64_t)INT_MIN;
+    sign = -1;
+    p++;
+  };
+  const char *q = p;
+  while (q < end && is_digit(*q)) {
+    value = value * 10 + (*q++ - '0');
+    if (value > limit)
+      return NULL;
+  };
+  if (q == p)
+    return NULL;
+  *result = sign * value;
+  return q;
+}
+
+float fast_atof(const char *text)
+{
+  float result;
+  return parse_float(text, text + strlen(text), &result) ? result : 0.0f;
+}
+
+int fast_atoi(const char *text)
+{
+  int result;
+  return parse_int(text, text + strlen(text), &result) ? result : 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+
+// Parse the longest prefix of [p, end) which is a decimal number as accepted by the lexer of the flex backend
+// (optional sign, digits with an optional fraction, and an optional exponent with a lower case 'e'). Returns a
+// pointer to the first character after the number or NULL if there is none. Hexadecimal numbers, "inf" and "nan"
+// are not accepted. Numbers the fast path cannot convert exactly are passed on to strtod.
+const char *parse_float(const char *p, const char *end, float *result);
+
+// Parse an optionally negative integer. Returns a pointer after the last digit or NULL if there are no digits or
+// the value is outside the range of int.
+const char *parse_int(const char *p, const char *end, int *result);
+
+// Replacements for atof and atoi on null-terminated strings.
+float fast_atof(const char *text);
+
+int fast_atoi(const char *text);
@@ -1,6 +1,6 @@
 #include <string.h>
 #include <GL/glew.h>
-#include <gc.h>
+#include "memory.h"
 #include "object.h"
 
 
@@ -10,11 +10,86 @@ object_t *make_object(const char *name)
   retval->name = GC_MALLOC_ATOMIC(strlen(name) + 1);
   strcpy(retval->name, name);
   retval->group = make_list();
+  retval->pool = make_list();
   return retval;
 }
 
+void destroy_object(object_t *object)
+{
+  list_t *materials = object_materials(object);
+  int i;
+  for (i=0; i<materials->size; i++) {
+    material_t *material = get_pointer(materials)[i];
+    if (!material->cached)
+      destroy_material(material);
+  };
+  destroy_list(materials);
+  for (i=0; i<object->group->size; i++)
+    destroy_group(get_pointer(object->group)[i]);
+  for (i=0; i<object->pool->size; i++)
+    destroy_vertex_pool(get_pointer(object->pool)[i]);
+  destroy_list(object->group);
+  destroy_list(object->pool);
+  GC_FREE(object->name);
+  GC_FREE(object);
+}
+
 object_t *add_group(object_t *object, group_t *group)
 {
   append_pointer(object->group, group);
   return object;
 }
+
+vertex_pool_t *object_pool(object_t *object, int stride)
+{
+  int i;
+  for (i=0; i<object->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    if (pool->stride == stride)
+      return pool;
+  };
+  vertex_pool_t *retval = make_vertex_pool(stride);
+  append_pointer(object->pool, retval);
+  return retval;
+}
+
+list_t *object_materials(object_t *object)
+{
+  list_t *result = make_list();
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    int j = 0;
+    while (j < result->size && get_pointer(result)[j] != group->material)
+      j++;
+    if (group->material && j == result->size)
+      append_pointer(result, group->material);
+  };
+  return result;
+}
+
+void compact_object(object_t *object)
+{
+  int i;
+  for (i=0; i<object->group->size; i++)
+    compact_group(get_pointer(object->group)[i]);
+  for (i=0; i<object->pool->size; i++)
+    compact_vertex_pool(get_pointer(object->pool)[i]);
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (group->pool)
+      group->stride = group->pool->stride;
+  };
+}
+
+void release_object_data(object_t *object)
+{
+  int i;
+  for (i=0; i<object->group->size; i++)
+    release_group_data(get_pointer(object->group)[i]);
+  for (i=0; i<object->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    pool->array->size = 0;
+    shrink_glfloat(pool->array);
+  };
+}
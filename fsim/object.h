@@ -6,8 +6,28 @@
 typedef struct {
   char *name;
   list_t *group;
+  list_t *pool;
 } object_t;
 
+// An object owns its groups, its vertex pools and the materials used by its groups except for the ones owned by the
+// material library cache.
 object_t *make_object(const char *name);
 
+// Release the object with its groups, vertex pools and uncached materials. Textures of the materials are deleted, which
+// requires the OpenGL context to be current.
+void destroy_object(object_t *object);
+
 object_t *add_group(object_t *object, group_t *group);
+
+// Get the vertex pool for the given stride. The pool is created if the object does not have one yet.
+vertex_pool_t *object_pool(object_t *object, int stride);
+
+// Get the distinct materials used by the groups of an object. The caller owns the returned list but not the
+// materials.
+list_t *object_materials(object_t *object);
+
+// Keep only the vertex positions and indices of all groups and vertex pools (see compact_group).
+void compact_object(object_t *object);
+
+// Release the vertex data and indices of all groups and vertex pools. Only the bounding boxes of the groups are kept.
+void release_object_data(object_t *object);
@@ -0,0 +1,317 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "vertex_cache.h"
+#include "overdraw.h"
+
+
+static int overdraw_optimization = 0;
+
+void set_overdraw_optimization(int enabled)
+{
+  overdraw_optimization = enabled;
+}
+
+int get_overdraw_optimization(void)
+{
+  return overdraw_optimization;
+}
+
+typedef struct {
+  const GLuint *index;
+  int64_t n_indices;
+  const GLfloat *array;
+  int stride;
+} mesh_t;
+
+typedef struct {
+  float lower[3];
+  float scale;
+  float *depth;
+} rasterizer_t;
+
+static void mesh_bounds(mesh_t *mesh, int n_meshes, float *lower, float *upper)
+{
+  int k;
+  for (k=0; k<3; k++) {
+    lower[k] = FLT_MAX;
+    upper[k] = -FLT_MAX;
+  };
+  int i;
+  for (i=0; i<n_meshes; i++) {
+    int64_t j;
+    for (j=0; j<mesh[i].n_indices; j++) {
+      const GLfloat *point = mesh[i].array + (int64_t)mesh[i].index[j] * mesh[i].stride;
+      for (k=0; k<3; k++) {
+        if (point[k] < lower[k]) lower[k] = point[k];
+        if (point[k] > upper[k]) upper[k] = point[k];
+      };
+    };
+  };
+}
+
+// Project a point onto the pixel grid. The view looks along the given axis in the given direction.
+static void project(rasterizer_t *rasterizer, const GLfloat *point, int axis, int direction, float *result)
+{
+  int u = (axis + 1) % 3;
+  int v = (axis + 2) % 3;
+  result[0] = (point[u] - rasterizer->lower[u]) * rasterizer->scale;
+  result[1] = (point[v] - rasterizer->lower[v]) * rasterizer->scale;
+  result[2] = direction * point[axis];
+}
+
+static float edge(const float *a, const float *b, float x, float y)
+{
+  return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+static int64_t rasterize_triangle(rasterizer_t *rasterizer, const float *a, const float *b, const float *c)
+{
+  float area = edge(a, b, c[0], c[1]);
+  if (area == 0)
+    return 0;
+  int x0 = (int)fmaxf(0, floorf(fminf(a[0], fminf(b[0], c[0]))));
+  int x1 = (int)fminf(OVERDRAW_RESOLUTION - 1, ceilf(fmaxf(a[0], fmaxf(b[0], c[0]))));
+  int y0 = (int)fmaxf(0, floorf(fminf(a[1], fminf(b[1], c[1]))));
+  int y1 = (int)fminf(OVERDRAW_RESOLUTION - 1, ceilf(fmaxf(a[1], fmaxf(b[1], c[1]))));
+  int64_t result = 0;
+  int x;
+  int y;
+  for (y=y0; y<=y1; y++)
+    for (x=x0; x<=x1; x++) {
+      float w0 = edge(b, c, x + 0.5f, y + 0.5f) / area;
+      float w1 = edge(c, a, x + 0.5f, y + 0.5f) / area;
+      float w2 = edge(a, b, x + 0.5f, y + 0.5f) / area;
+      if (w0 < 0 || w1 < 0 || w2 < 0)
+        continue;
+      float z = w0 * a[2] + w1 * b[2] + w2 * c[2];
+      float *depth = &rasterizer->depth[y * OVERDRAW_RESOLUTION + x];
+      if (z < *depth) {
+        *depth = z;
+        result++;
+      };
+    };
+  return result;
+}
+
+static overdraw_statistics_t analyze(mesh_t *mesh, int n_meshes)
+{
+  overdraw_statistics_t result = {0, 0, 0};
+  rasterizer_t rasterizer;
+  float upper[3];
+  mesh_bounds(mesh, n_meshes, rasterizer.lower, upper);
+  float extent = fmaxf(upper[0] - rasterizer.lower[0], fmaxf(upper[1] - rasterizer.lower[1],
+                                                               upper[2] - rasterizer.lower[2]));
+  if (extent <= 0)
+    return result;
+  rasterizer.scale = (OVERDRAW_RESOLUTION - 1) / extent;
+  rasterizer.depth = GC_MALLOC_ATOMIC(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION * sizeof(float));
+  int view;
+  for (view=0; view<6; view++) {
+    int axis = view / 2;
+    int direction = view % 2 ? -1 : 1;
+    int p;
+    for (p=0; p<OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION; p++)
+      rasterizer.depth[p] = FLT_MAX;
+    int i;
+    for (i=0; i<n_meshes; i++) {
+      int64_t j;
+      for (j=0; j+2<mesh[i].n_indices; j+=3) {
+        float corner[3][3];
+        int k;
+        for (k=0; k<3; k++)
+          project(&rasterizer, mesh[i].array + (int64_t)mesh[i].index[j + k] * mesh[i].stride, axis, direction,
+                  corner[k]);
+        result.shaded += rasterize_triangle(&rasterizer, corner[0], corner[1], corner[2]);
+      };
+    };
+    for (p=0; p<OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION; p++)
+      if (rasterizer.depth[p] < FLT_MAX)
+        result.covered++;
+  };
+  GC_FREE(rasterizer.depth);
+  if (result.covered)
+    result.overdraw = (double)result.shaded / result.covered;
+  return result;
+}
+
+overdraw_statistics_t overdraw_statistics(const GLuint *index, int64_t n_indices, const GLfloat *array, int stride)
+{
+  mesh_t mesh = {index, n_indices, array, stride};
+  return analyze(&mesh, 1);
+}
+
+static list_t *group_array(group_t *group)
+{
+  return group->pool ? group->pool->array : group->array;
+}
+
+overdraw_statistics_t object_overdraw_statistics(object_t *object)
+{
+  mesh_t *mesh = GC_MALLOC_ATOMIC((object->group->size + 1) * sizeof(mesh_t));
+  int n_meshes = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (group->stride && group->vertex_index->size) {
+      mesh_t group_mesh = {get_gluint(group->vertex_index), group->vertex_index->size,
+                           get_glfloat(group_array(group)), group->stride};
+      mesh[n_meshes++] = group_mesh;
+    };
+  };
+  overdraw_statistics_t result = analyze(mesh, n_meshes);
+  GC_FREE(mesh);
+  return result;
+}
+
+typedef struct {
+  int64_t first;
+  int64_t n_triangles;
+  double key;
+} cluster_t;
+
+// Split the triangles into clusters. The simulated cache is emptied at the start of each cluster because the
+// clusters are drawn in a different order afterwards.
+static int64_t split_clusters(const GLuint *index, int64_t n_triangles, int cache_size, double target,
+                              cluster_t *cluster)
+{
+  GLuint first = index[0];
+  GLuint last = index[0];
+  int64_t i;
+  for (i=1; i<n_triangles * 3; i++) {
+    if (index[i] < first) first = index[i];
+    if (index[i] > last) last = index[i];
+  };
+  int64_t *stamp = GC_MALLOC_ATOMIC(((int64_t)last - first + 1) * sizeof(int64_t));
+  memset(stamp, 0xff, ((int64_t)last - first + 1) * sizeof(int64_t));
+  int64_t result = 0;
+  int64_t time = 0;
+  int64_t start_time = 0;
+  int64_t misses = 0;
+  int open = 1;
+  int64_t t;
+  for (t=0; t<n_triangles; t++) {
+    int64_t triangle_time = time;
+    int triangle_misses = 0;
+    int k;
+    for (k=0; k<3; k++) {
+      int64_t *vertex_stamp = &stamp[index[3 * t + k] - first];
+      if (*vertex_stamp < start_time || time - *vertex_stamp >= cache_size) {
+        *vertex_stamp = time++;
+        triangle_misses++;
+      };
+    };
+    if (triangle_misses == 3) {
+      open = 1;
+      start_time = triangle_time;
+    };
+    if (open) {
+      cluster[result].first = t;
+      cluster[result].n_triangles = 0;
+      result++;
+      misses = 0;
+      open = 0;
+    };
+    cluster[result - 1].n_triangles++;
+    misses += triangle_misses;
+    if (misses <= target * cluster[result - 1].n_triangles) {
+      open = 1;
+      start_time = time;
+    };
+  };
+  GC_FREE(stamp);
+  return result;
+}
+
+// Area-weighted centroid and normal of a range of triangles.
+static void triangle_moments(const GLuint *index, int64_t n_triangles, const GLfloat *array, int stride,
+                             double *centroid, double *normal, double *area)
+{
+  int k;
+  for (k=0; k<3; k++) {
+    centroid[k] = 0;
+    normal[k] = 0;
+  };
+  *area = 0;
+  int64_t t;
+  for (t=0; t<n_triangles; t++) {
+    const GLfloat *a = array + (int64_t)index[3 * t] * stride;
+    const GLfloat *b = array + (int64_t)index[3 * t + 1] * stride;
+    const GLfloat *c = array + (int64_t)index[3 * t + 2] * stride;
+    double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+    double weight = 0.5 * sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    for (k=0; k<3; k++) {
+      centroid[k] += weight * (a[k] + b[k] + c[k]) / 3;
+      normal[k] += n[k];
+    };
+    *area += weight;
+  };
+  if (*area > 0)
+    for (k=0; k<3; k++)
+      centroid[k] /= *area;
+}
+
+static int compare_clusters(const void *a, const void *b)
+{
+  const cluster_t *x = a;
+  const cluster_t *y = b;
+  if (x->key != y->key)
+    return x->key < y->key ? 1 : -1;
+  return (x->first > y->first) - (x->first < y->first);
+}
+
+void optimize_overdraw(GLuint *index, int64_t n_indices, const GLfloat *array, int stride, int cache_size,
+                       float threshold)
+{
+  int64_t n_triangles = n_indices / 3;
+  if (n_triangles < 2)
+    return;
+  double target = threshold * vertex_cache_statistics(index, n_triangles * 3, cache_size).acmr;
+  cluster_t *cluster = GC_MALLOC_ATOMIC(n_triangles * sizeof(cluster_t));
+  int64_t n_clusters = split_clusters(index, n_triangles, cache_size, target, cluster);
+  double centre[3];
+  double normal[3];
+  double area;
+  triangle_moments(index, n_triangles, array, stride, centre, normal, &area);
+  int64_t i;
+  for (i=0; i<n_clusters; i++) {
+    double centroid[3];
+    triangle_moments(index + 3 * cluster[i].first, cluster[i].n_triangles, array, stride, centroid, normal, &area);
+    double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    cluster[i].key = 0;
+    if (length > 0) {
+      int k;
+      for (k=0; k<3; k++)
+        cluster[i].key += (centroid[k] - centre[k]) * normal[k] / length;
+    };
+  };
+  qsort(cluster, n_clusters, sizeof(cluster_t), compare_clusters);
+  GLuint *result = GC_MALLOC_ATOMIC(n_triangles * 3 * sizeof(GLuint));
+  int64_t n_result = 0;
+  for (i=0; i<n_clusters; i++) {
+    memcpy(result + n_result, index + 3 * cluster[i].first, cluster[i].n_triangles * 3 * sizeof(GLuint));
+    n_result += cluster[i].n_triangles * 3;
+  };
+  memcpy(index, result, n_result * sizeof(GLuint));
+  GC_FREE(result);
+  GC_FREE(cluster);
+}
+
+void optimize_group_overdraw(group_t *group)
+{
+  if (!group->stride)
+    return;
+  optimize_overdraw(get_gluint(group->vertex_index), group->vertex_index->size, get_glfloat(group_array(group)),
+                    group->stride, VERTEX_CACHE_SIZE, OVERDRAW_THRESHOLD);
+}
+
+void optimize_object_overdraw(object_t *object)
+{
+  int i;
+  for (i=0; i<object->group->size; i++)
+    optimize_group_overdraw(get_pointer(object->group)[i]);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <GL/gl.h>
+#include "group.h"
+#include "object.h"
+
+
+// Reduce overdraw by splitting the triangles of a group into clusters and drawing the clusters facing away from the
+// centre of the group first, so that they occlude the clusters further inside (Sander, Nehab and Barczak: Fast
+// Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007). The sort key does not depend on the view and
+// the triangles are only reordered, so the image rendered with depth test does not change.
+//
+// A cluster ends where the simulated vertex cache misses all vertices of a triangle or where the average cache miss
+// ratio of the cluster drops below the threshold times the ratio of the whole group. Run the vertex cache
+// optimization first so that the clusters are runs of neighbouring triangles.
+#define OVERDRAW_THRESHOLD 1.05f
+#define OVERDRAW_RESOLUTION 256
+
+// Optimize the groups completed by the parser and the groups read from object caches written without optimization.
+void set_overdraw_optimization(int enabled);
+
+int get_overdraw_optimization(void);
+
+// Rasterize the triangles in order from the six axis directions (orthographic projection of the bounding box onto
+// OVERDRAW_RESOLUTION pixels) and count the fragments passing the depth test against the pixels covered.
+typedef struct {
+  int64_t covered;
+  int64_t shaded;
+  double overdraw;
+} overdraw_statistics_t;
+
+// The vertex positions are the first three values of each vertex of the interleaved array.
+overdraw_statistics_t overdraw_statistics(const GLuint *index, int64_t n_indices, const GLfloat *array, int stride);
+
+// Statistics of drawing all groups of the object in order.
+overdraw_statistics_t object_overdraw_statistics(object_t *object);
+
+void optimize_overdraw(GLuint *index, int64_t n_indices, const GLfloat *array, int stride, int cache_size,
+                       float threshold);
+
+void optimize_group_overdraw(group_t *group);
+
+void optimize_object_overdraw(object_t *object);
@@ -1,86 +1,553 @@
+#include <assert.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <unistd.h>
+#include "memory.h"
 #include "parser.h"
-#include "hash.h"
+#include "parser_actions.h"
+#include "scanner.h"
+#include "cache.h"
+#include "decompress.h"
+#include "vertex_cache.h"
+#include "overdraw.h"
+#include "vertex_fetch.h"
+#include "vertex_array_object.h"
 
 
 // https://stackoverflow.com/questions/780676/string-input-to-flex-lexer
+// https://westes.github.io/flex/manual/Reentrant-Overview.html
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
-extern void yyrestart (FILE *input_file);
-extern int yyparse(void);
-extern YY_BUFFER_STATE yy_scan_string(const char * str);
-extern int yylex_destroy(void);
+typedef void *yyscan_t;
+extern int yylex_init_extra(parser_context_t *context, yyscan_t *scanner);
+extern void yyrestart(FILE *input_file, yyscan_t scanner);
+extern int yyparse(yyscan_t scanner, parser_context_t *context);
+extern YY_BUFFER_STATE yy_scan_string(const char *str, yyscan_t scanner);
+extern int yylex_destroy(yyscan_t scanner);
 
-object_t *parse_result = NULL;
-hash_t *parse_materials = NULL;
-material_t *parse_material = NULL;
-material_t *parse_use_material = NULL;
-list_t *parse_vertex = NULL;
-list_t *parse_uv = NULL;
-list_t *parse_normal = NULL;
-hash_t *parse_hash =  NULL;
+static parser_backend_t parser_backend = PARSER_MMAP;
+static int parser_threads = 1;
+static int parser_cache = 0;
+static int parser_prescan = 0;
+static int parser_shared_vertices = 0;
 
 
-static void parser_init(void)
+void set_parser_backend(parser_backend_t backend)
 {
-  parse_result = NULL;
-  parse_material = NULL;
-  parse_materials = make_hash();
-  parse_use_material = NULL;// TODO: test
-  parse_vertex = make_list();
-  parse_uv = make_list();
-  parse_normal = make_list();
-  parse_hash = NULL;
+  parser_backend = backend;
 }
 
-static void parser_cleanup(void)
+parser_backend_t get_parser_backend(void)
 {
-  yylex_destroy();
-  parse_result = NULL;
-  parse_material = NULL;// TODO: test
-  parse_use_material = NULL;// TODO: test
-  parse_vertex = NULL;
-  parse_uv = NULL;
-  parse_normal = NULL;
-  parse_hash = NULL;
+  return parser_backend;
 }
 
-object_t *parse_string_core(const char *text)
+void set_parser_threads(int n_threads)
 {
-  parser_init();
-  YY_BUFFER_STATE buffer = yy_scan_string(text);
-  if (yyparse())
-    parse_result = NULL;
-  return parse_result;
+  parser_threads = n_threads;
 }
 
-object_t *parse_file_core(const char *file_name)
+int get_parser_threads(void)
 {
-  parser_init();
-  FILE *f = fopen(file_name, "r");
-  if (!f) {
-    fprintf(stderr, "Error opening file %s: %s\n", file_name, strerror(errno));
-    parse_result = NULL;
+  return parser_threads > 0 ? parser_threads : sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+void set_parser_prescan(int enabled)
+{
+  parser_prescan = enabled;
+}
+
+int get_parser_prescan(void)
+{
+  return parser_prescan;
+}
+
+void set_parser_shared_vertices(int enabled)
+{
+  parser_shared_vertices = enabled;
+}
+
+int get_parser_shared_vertices(void)
+{
+  return parser_shared_vertices;
+}
+
+void set_parser_cache(int enabled)
+{
+  parser_cache = enabled;
+}
+
+int get_parser_cache(void)
+{
+  return parser_cache;
+}
+
+group_t *last_group(parser_context_t *context)
+{
+  list_t *group = context->result->group;
+  return get_pointer(group)[group->size - 1];
+}
+
+// Without the garbage collector an object which is replaced or which was only partially parsed has to be released
+// explicitly. Its materials are still owned by the material table at this point.
+static void discard_result(parser_context_t *context)
+{
+#ifdef FSIM_NO_GC
+  if (context->result) {
+    int i;
+    for (i=0; i<context->result->group->size; i++)
+      use_material(get_pointer(context->result->group)[i], NULL);
+    destroy_object(context->result);
+  };
+#endif
+  context->result = NULL;
+  context->pool_object = NULL;
+}
+
+void begin_object(parser_context_t *context, const char *name)
+{
+  discard_result(context);
+  context->result = make_object(name);
+}
+
+void add_dependency(parser_context_t *context, const char *file_name)
+{
+  char *copy = GC_MALLOC_ATOMIC(strlen(file_name) + 1);
+  strcpy(copy, file_name);
+  append_pointer(context->dependencies, copy);
+}
+
+void diffuse_texture(parser_context_t *context, const char *file_name)
+{
+  add_dependency(context, file_name);
+  append_pointer(context->textures, request_diffuse_texture(context->material, file_name));
+}
+
+void specular_texture(parser_context_t *context, const char *file_name)
+{
+  add_dependency(context, file_name);
+  append_pointer(context->textures, request_specular_texture(context->material, file_name));
+}
+
+// Upload the decoded textures of a material or of all materials if it is NULL.
+static void upload_textures(parser_context_t *context, material_t *material)
+{
+  int i;
+  for (i=0; i<context->textures->size; i++) {
+    pending_texture_t *texture = get_pointer(context->textures)[i];
+    if (!material || texture->material == material)
+      upload_texture(texture);
+  };
+}
+
+// Groups passed to a callback must not change afterwards. Vertex pools keep growing until the last group and are
+// renumbered by shrink_pools, so streamed groups always get their own vertices.
+static int share_vertices(parser_context_t *context)
+{
+  return context->shared_vertices && !context->group_callback;
+}
+
+// Release the spare capacity of the completed group and pass it to the group callback.
+static void finish_group(parser_context_t *context)
+{
+  if (context->result && context->result->group->size) {
+    group_t *group = last_group(context);
+    if (get_vertex_cache_optimization())
+      optimize_group_vertex_cache(group);
+    if (get_overdraw_optimization())
+      optimize_group_overdraw(group);
+    if (get_vertex_fetch_optimization())
+      optimize_group_vertex_fetch(group);
+    shrink_glfloat(group->array);
+    shrink_gluint(group->vertex_index);
+  };
+  if (context->group_callback && context->result && context->result->group->size) {
+    group_t *group = last_group(context);
+    if (group->material)
+      upload_textures(context, group->material);
+    context->group_callback(group, context->callback_data);
+  };
+}
+
+void begin_group(parser_context_t *context, const char *name)
+{
+  finish_group(context);
+  if (!context->result) context->result = make_object("");
+  group_t *group = make_group(name, 0);
+  if (context->group_indices && context->group_count < context->group_indices->size)
+    reserve_gluint(group->vertex_index, get_gluint(context->group_indices)[context->group_count]);
+  context->group_count++;
+  add_group(context->result, group);
+  use_material(last_group(context), context->use_material);
+  if (!share_vertices(context))
+    context->hash = make_arena_index_hash(context->arena);
+}
+
+void begin_material(parser_context_t *context, const char *name)
+{
+  context->material = make_material();
+  hash_find_material(context->materials, name, context->material);
+  if (context->library)
+    add_library_material(context->library, name, context->material);
+}
+
+int begin_material_library(parser_context_t *context, const char *file_name)
+{
+  if (!get_material_library_cache() || context->library_depth++)
+    return 0;
+  material_library_t *library = find_material_library(file_name);
+  if (library) {
+    int i;
+    for (i=0; i<library->name->size; i++)
+      hash_find_material(context->materials, get_pointer(library->name)[i], get_pointer(library->material)[i]);
+    context->library_depth--;
+    return 1;
+  };
+  context->library = make_material_library(file_name);
+  return 0;
+}
+
+void end_material_library(parser_context_t *context, int success)
+{
+  if (!context->library_depth || --context->library_depth)
+    return;
+  material_library_t *library = context->library;
+  context->library = NULL;
+  if (library && !(success && cache_material_library(library)))
+    destroy_material_library(library);
+}
+
+void select_material(parser_context_t *context, const char *name)
+{
+  context->use_material = hash_find_material(context->materials, name, NULL);
+}
+
+static void copy_vertex_data(list_t *array, int index, int stride, list_t *source)
+{
+  assert(index >= 0);
+  assert((int64_t)index * stride < source->size);
+  append_glfloats(array, get_glfloat(source) + (int64_t)index * stride, stride);
+}
+
+// Each vertex pool of the current object has its own deduplication table.
+static index_hash_t *pool_hash(parser_context_t *context, vertex_pool_t *pool)
+{
+  if (context->pool_object != context->result) {
+    context->pool_object = context->result;
+    if (context->pool_hash)
+      destroy_list(context->pool_hash);
+    context->pool_hash = make_arena_list(context->arena);
+  };
+  int i = 0;
+  while (get_pointer(context->result->pool)[i] != pool)
+    i++;
+  while (context->pool_hash->size <= i)
+    append_pointer(context->pool_hash, make_arena_index_hash(context->arena));
+  return get_pointer(context->pool_hash)[i];
+}
+
+int index_vertex(parser_context_t *context, int stride, int vertex_index, int uv_index, int normal_index)
+{
+  if (vertex_index < 0) vertex_index += 1 + context->vertex_base + context->vertex->size / 3;
+  if (uv_index     < 0) uv_index     += 1 + context->uv_base     + context->uv->size     / 2;
+  if (normal_index < 0) normal_index += 1 + context->normal_base + context->normal->size / 3;
+  group_t *group = last_group(context);
+  group->stride = stride;
+  list_t *array = group->array;
+  index_hash_t *hash = context->hash;
+  if (share_vertices(context)) {
+    group->pool = object_pool(context->result, stride);
+    array = group->pool->array;
+    hash = pool_hash(context, group->pool);
+  };
+  int n_indices = array->size / stride;
+  int result = hash_find_index(hash, vertex_index, uv_index, normal_index, n_indices);
+  if (result == n_indices) {
+    copy_vertex_data(array, vertex_index - 1 - context->vertex_base, 3, context->vertex);
+    if (uv_index) copy_vertex_data(array, uv_index - 1 - context->uv_base, 2, context->uv);
+    if (normal_index) copy_vertex_data(array, normal_index - 1 - context->normal_base, 3, context->normal);
+  };
+  return result;
+}
+
+// Pools are renumbered after the last group because the vertex hash of the parser refers to the original order.
+static void shrink_pools(parser_context_t *context)
+{
+  int i;
+  for (i=0; context->result && i<context->result->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(context->result->pool)[i];
+    if (get_vertex_fetch_optimization())
+      optimize_pool_vertex_fetch(context->result, pool);
+    shrink_glfloat(pool->array);
+  };
+}
+
+parser_context_t *make_parser_context(void)
+{
+  parser_context_t *result = GC_MALLOC(sizeof(parser_context_t));
+  result->backend = parser_backend;
+  result->n_threads = get_parser_threads();
+  result->cache = parser_cache;
+  result->prescan = parser_prescan;
+  result->shared_vertices = parser_shared_vertices;
+  result->group_callback = NULL;
+  result->callback_data = NULL;
+  result->arena = make_arena();
+  return result;
+}
+
+static void parser_init(parser_context_t *context)
+{
+  context->result = NULL;
+  context->material = NULL;
+  context->materials = make_hash();
+  context->library = NULL;
+  context->library_depth = 0;
+  context->use_material = NULL;// TODO: test
+  context->vertex = make_arena_list(context->arena);
+  context->uv = make_arena_list(context->arena);
+  context->normal = make_arena_list(context->arena);
+  context->vertex_base = 0;
+  context->uv_base = 0;
+  context->normal_base = 0;
+  context->hash = NULL;
+  context->pool_object = NULL;
+  context->pool_hash = NULL;
+  context->dependencies = make_list();
+  context->textures = make_list();
+  context->group_indices = NULL;
+  context->group_count = 0;
+  context->scanner = NULL;
+  context->line_number = 1;
+  context->in_material = 0;
+  if (context->backend == PARSER_FLEX)
+    yylex_init_extra(context, &context->scanner);
+}
+
+static int contains_pointer(list_t *list, void *pointer)
+{
+  int i;
+  for (i=0; i<list->size; i++)
+    if (get_pointer(list)[i] == pointer)
+      return 1;
+  return 0;
+}
+
+// The result owns the materials used by its groups. The other materials of the material table are released unless
+// they are owned by the material library cache.
+static void release_materials(parser_context_t *context)
+{
+  list_t *used = context->result ? object_materials(context->result) : make_list();
+  list_t *items = context->materials->items;
+  int i;
+  for (i=1; i<items->size; i+=2) {
+    material_t *material = get_pointer(items)[i];
+    if (material && !material->cached && !contains_pointer(used, material))
+      destroy_material(material);
+  };
+  destroy_list(used);
+  destroy_hash(context->materials);
+}
+
+static void destroy_strings(list_t *list)
+{
+  int i;
+  for (i=0; i<list->size; i++)
+    GC_FREE(get_pointer(list)[i]);
+  destroy_list(list);
+}
+
+static void destroy_pending_textures(list_t *list)
+{
+  int i;
+  for (i=0; i<list->size; i++)
+    destroy_pending_texture(get_pointer(list)[i]);
+  destroy_list(list);
+}
+
+static void destroy_optional_list(list_t *list)
+{
+  if (list)
+    destroy_list(list);
+}
+
+void parser_cleanup(parser_context_t *context)
+{
+  if (context->scanner)
+    yylex_destroy(context->scanner);
+  context->scanner = NULL;
+  if (context->library)
+    destroy_material_library(context->library);
+  if (context->materials) {
+    destroy_pending_textures(context->textures);
+    release_materials(context);
+    destroy_strings(context->dependencies);
+    destroy_optional_list(context->vertex);
+    destroy_optional_list(context->uv);
+    destroy_optional_list(context->normal);
+    destroy_optional_list(context->pool_hash);
+    destroy_optional_list(context->group_indices);
+  };
+  context->result = NULL;
+  context->materials = NULL;
+  context->library = NULL;
+  context->library_depth = 0;
+  context->material = NULL;// TODO: test
+  context->use_material = NULL;// TODO: test
+  context->vertex = NULL;
+  context->uv = NULL;
+  context->normal = NULL;
+  context->hash = NULL;
+  context->pool_object = NULL;
+  context->pool_hash = NULL;
+  context->dependencies = NULL;
+  context->textures = NULL;
+  context->group_indices = NULL;
+  clear_arena(context->arena);
+}
+
+void destroy_parser_context(parser_context_t *context)
+{
+  destroy_arena(context->arena);
+  GC_FREE(context);
+}
+
+object_t *parse_string_core(parser_context_t *context, const char *text)
+{
+  parser_init(context);
+  if (context->backend == PARSER_MMAP) {
+    if (scan_buffer_parallel(context, text, strlen(text), context->n_threads))
+      discard_result(context);
   } else {
-    yyrestart(f);
-    if (yyparse())
-      parse_result = NULL;
-    fclose(f);
+    yy_scan_string(text, context->scanner);
+    if (yyparse(context->scanner, context))
+      discard_result(context);
   };
-  return parse_result;
+  upload_textures(context, NULL);
+  finish_group(context);
+  shrink_pools(context);
+  return context->result;
+}
+
+object_t *parse_file_core(parser_context_t *context, const char *file_name)
+{
+  parser_init(context);
+  if (context->cache) {
+    context->result = read_object_cache(file_name);
+    // A cache written with vertex pools is not used for streaming (see share_vertices) and is replaced below.
+    if (context->result && context->group_callback && context->result->pool->size) {
+      destroy_object(context->result);
+      context->result = NULL;
+    };
+    if (context->result) {
+      int i;
+      for (i=0; context->group_callback && i<context->result->group->size; i++)
+        context->group_callback(get_pointer(context->result->group)[i], context->callback_data);
+      return context->result;
+    };
+  };
+  if (context->backend == PARSER_MMAP) {
+    if (scan_file_parallel(context, file_name, context->n_threads))
+      discard_result(context);
+  } else {
+    FILE *f = open_input(file_name);
+    if (!f) {
+      fprintf(stderr, "Error opening file %s: %s\n", file_name, strerror(errno));
+      context->result = NULL;
+    } else {
+      yyrestart(f, context->scanner);
+      if (yyparse(context->scanner, context))
+        discard_result(context);
+      fclose(f);
+    };
+  };
+  upload_textures(context, NULL);
+  finish_group(context);
+  shrink_pools(context);
+  // Streamed groups may already have been compacted or released by make_vertex_array_object.
+  if (context->cache && context->result && (!context->group_callback || get_upload_mode() == UPLOAD_KEEP))
+    write_object_cache(file_name, context->result, context->dependencies);
+  return context->result;
 }
 
 object_t *parse_string(const char *text)
 {
-  object_t *result = parse_string_core(text);
-  parser_cleanup();
+  parser_context_t *context = make_parser_context();
+  object_t *result = parse_string_core(context, text);
+  parser_cleanup(context);
+  destroy_parser_context(context);
   return result;
 }
 
 object_t *parse_file(const char *file_name)
 {
-  object_t *result = parse_file_core(file_name);
-  parser_cleanup();
+  return parse_file_stream(file_name, NULL, NULL);
+}
+
+object_t *parse_file_stream(const char *file_name, group_callback_t callback, void *data)
+{
+  parser_context_t *context = make_parser_context();
+  context->group_callback = callback;
+  context->callback_data = data;
+  object_t *result = parse_file_core(context, file_name);
+  parser_cleanup(context);
+  destroy_parser_context(context);
+  return result;
+}
+
+// The selected groups and all vertex pools are moved to a new object. The rest of the object is released.
+static object_t *select_groups(object_t *object, const char **names)
+{
+  object_t *result = make_object(object->name);
+  int n_rest = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    int j = 0;
+    while (names[j] && strcmp(group->name, names[j]))
+      j++;
+    if (names[j])
+      add_group(result, group);
+    else
+      get_pointer(object->group)[n_rest++] = group;
+  };
+  object->group->size = n_rest;
+  for (i=0; i<object->pool->size; i++)
+    append_pointer(result->pool, get_pointer(object->pool)[i]);
+  object->pool->size = 0;
+  list_t *used = object_materials(result);
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (contains_pointer(used, group->material))
+      use_material(group, NULL);
+  };
+  destroy_list(used);
+  destroy_object(object);
+  return result;
+}
+
+object_t *parse_file_groups(const char *file_name, const char **names)
+{
+  group_index_t *index = read_group_index(file_name);
+  if (!index) {
+    index = index_groups(file_name);
+    if (!index) {
+      object_t *object = parse_file(file_name);
+      return object ? select_groups(object, names) : NULL;
+    };
+    write_group_index(file_name, index);
+  };
+  parser_context_t *context = make_parser_context();
+  context->backend = PARSER_MMAP;
+  parser_init(context);
+  if (scan_groups(context, file_name, index, names))
+    discard_result(context);
+  finish_group(context);
+  shrink_pools(context);
+  upload_textures(context, NULL);
+  object_t *result = context->result;
+  parser_cleanup(context);
+  destroy_parser_context(context);
+  destroy_group_index(index);
   return result;
 }
@@ -1,7 +1,110 @@
 #pragma once
 #include "object.h"
+#include "material.h"
+#include "hash.h"
+#include "list.h"
+#include "arena.h"
+#include "material_library.h"
 
 
+// The hand-written scanner over a memory-mapped file is the default.
+// The flex/bison parser is kept as the reference implementation.
+typedef enum {PARSER_MMAP, PARSER_FLEX} parser_backend_t;
+
+// Called with each group as soon as it is complete, i.e. when the next group starts or the input ends.
+typedef void (*group_callback_t)(group_t *group, void *data);
+
+// All state of a parse is kept in a context so that independent files can be parsed on separate threads at
+// the same time. Temporary data such as the coordinate lists and the deduplication tables is allocated from the
+// arena of the context, which is released by parser_cleanup. Threads must be created using the pthread wrappers of
+// the garbage collector. The textures of "map_Kd" and "map_Ks" statements are decoded while parsing, but they are
+// uploaded before a group is passed to the callback and before the parse functions return. Files with textured
+// materials therefore have to be parsed on the thread with the current OpenGL context. Only files without textures
+// can be parsed on other threads.
+typedef struct {
+  parser_backend_t backend;
+  int n_threads;
+  char cache;
+  char prescan;
+  char shared_vertices;
+  group_callback_t group_callback;
+  void *callback_data;
+  arena_t *arena;
+  object_t *result;
+  hash_t *materials;
+  material_library_t *library;
+  int library_depth;
+  material_t *material;
+  material_t *use_material;
+  list_t *vertex;
+  list_t *uv;
+  list_t *normal;
+  int vertex_base;
+  int uv_base;
+  int normal_base;
+  index_hash_t *hash;
+  object_t *pool_object;
+  list_t *pool_hash;
+  list_t *dependencies;
+  list_t *textures;
+  list_t *group_indices;
+  int group_count;
+  void *scanner;
+  int line_number;
+  char in_material;
+} parser_context_t;
+
+void set_parser_backend(parser_backend_t backend);
+
+parser_backend_t get_parser_backend(void);
+
+// Number of threads used by the mmap backend. Zero selects one thread per processor.
+void set_parser_threads(int n_threads);
+
+int get_parser_threads(void);
+
+// Count the records of the input before parsing it with the mmap backend so that the coordinate and index lists
+// can be allocated at their final size.
+void set_parser_prescan(int enabled);
+
+int get_parser_prescan(void);
+
+// Deduplicate the vertices of all groups of an object into shared vertex pools (one per stride) instead of giving
+// each group its own vertex array. The groups only keep their indices. Parses with a group callback do not share
+// vertices because the pools keep changing until the last group has been parsed.
+void set_parser_shared_vertices(int enabled);
+
+int get_parser_shared_vertices(void);
+
+// The material library cache is configured in material_library.h.
+
+// Store the result of parse_file in a binary cache file and use it for later loads of the same file. Streaming parses
+// only write the cache with the upload mode UPLOAD_KEEP because the callback may upload and then compact or release
+// the groups before the cache is written.
+void set_parser_cache(int enabled);
+
+int get_parser_cache(void);
+
+parser_context_t *make_parser_context(void);
+
+object_t *parse_string_core(parser_context_t *context, const char *text);
+
+object_t *parse_file_core(parser_context_t *context, const char *file_name);
+
+// Release the temporary data of a parse. The result is owned by the caller.
+void parser_cleanup(parser_context_t *context);
+
+// Release a context after parser_cleanup.
+void destroy_parser_context(parser_context_t *context);
+
 object_t *parse_string(const char *text);
 
 object_t *parse_file(const char *file_name);
+
+// Parse a file and pass each group to the callback while the remainder of the file is still being read.
+object_t *parse_file_stream(const char *file_name, group_callback_t callback, void *data);
+
+// Load only the groups with the given names (NULL-terminated array). The group index file is created on first use
+// and recreated when the object file changes. Only the coordinates between the first coordinate record referenced by
+// a group and the end of the group are read. Compressed files are parsed completely.
+object_t *parse_file_groups(const char *file_name, const char **names);
@@ -0,0 +1,31 @@
+#pragma once
+#include "parser.h"
+#include "group.h"
+#include "image.h"
+
+
+group_t *last_group(parser_context_t *context);
+
+// Start a new object. Groups read so far are dropped.
+void begin_object(parser_context_t *context, const char *name);
+
+void begin_group(parser_context_t *context, const char *name);
+
+void begin_material(parser_context_t *context, const char *name);
+
+void select_material(parser_context_t *context, const char *name);
+
+// Called for "mtllib" statements. If the material library cache has the library, its materials are added to the
+// material table and 1 is returned. Otherwise the materials defined until end_material_library are recorded and
+// cached if the library was read successfully. Libraries included by other libraries are not cached separately.
+int begin_material_library(parser_context_t *context, const char *file_name);
+
+void end_material_library(parser_context_t *context, int success);
+
+void add_dependency(parser_context_t *context, const char *file_name);
+
+void diffuse_texture(parser_context_t *context, const char *file_name);
+
+void specular_texture(parser_context_t *context, const char *file_name);
+
+int index_vertex(parser_context_t *context, int stride, int vertex_index, int uv_index, int normal_index);
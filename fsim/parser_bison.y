@@ -1,64 +1,26 @@
-%{
-#include <assert.h>
+%code requires {
+#include "parser.h"
+}
+
+%code {
 #include <stdio.h>
-#include "object.h"
-#include "group.h"
-#include "list.h"
-#include "hash.h"
+#include "parser_actions.h"
 
 
 #define YYERROR_VERBOSE 1
 
-extern object_t *parse_result;
-extern hash_t *parse_materials;
-extern material_t *parse_material;
-extern material_t *parse_use_material;
-extern list_t *parse_vertex;
-extern list_t *parse_uv;
-extern list_t *parse_normal;
-extern hash_t *parse_hash;
-extern int yylineno;
-
-extern int yylex(void);
-
-void yyerror(const char *message)
-{
-  fprintf(stderr, "Parsing line %d: %s\n", yylineno, message);
-}
+extern int yylex(YYSTYPE *lvalp, void *scanner);
+extern int yyget_lineno(void *scanner);
 
-static group_t *last_group(void)
+void yyerror(void *scanner, parser_context_t *context, const char *message)
 {
-  list_t *group = parse_result->group;
-  return get_pointer(group)[group->size - 1];
+  fprintf(stderr, "Parsing line %d: %s\n", yyget_lineno(scanner), message);
 }
-
-static void copy_vertex_data(int index, int stride, list_t *source)
-{
-  group_t *group = last_group();
-  int i;
-  assert(index >= 0);
-  assert(index * stride < source->size);
-  for (i=index * stride; i<index * stride + stride; i++)
-    append_glfloat(group->array, get_glfloat(source)[i]);
 }
 
-static int index_vertex(int stride, int vertex_index, int uv_index, int normal_index)
-{
-  if (vertex_index < 0) vertex_index += 1 + parse_vertex->size / 3;
-  if (uv_index     < 0) uv_index     += 1 + parse_uv->size     / 2;
-  if (normal_index < 0) normal_index += 1 + parse_normal->size / 3;
-  group_t *group = last_group();
-  group->stride = stride;
-  int n_indices = group->array->size / stride;
-  int result = hash_find_index(parse_hash, vertex_index, uv_index, normal_index, n_indices);
-  if (result == n_indices) {
-    copy_vertex_data(vertex_index - 1, 3, parse_vertex);
-    if (uv_index) copy_vertex_data(uv_index - 1, 2, parse_uv);
-    if (normal_index) copy_vertex_data(normal_index - 1, 3, parse_normal);
-  };
-  return result;
-}
-%}
+%define api.pure full
+%lex-param {void *scanner}
+%parse-param {void *scanner} {parser_context_t *context}
 
 %union {
   char *text;
@@ -90,62 +52,50 @@ primitive: object
          | facet
          ;
 
-object: OBJECT NAME { parse_result = make_object($2); }
+object: OBJECT NAME { begin_object(context, $2); }
 
-material: MATERIAL NAME {
-            parse_material = make_material();
-            hash_find_material(parse_materials, $2, parse_material);
-          } properties
+material: MATERIAL NAME { begin_material(context, $2); } properties
 
 properties: properties property
           | /* NULL */
           ;
 
-property: ILLUM INDEX             { set_illumination(parse_material, $2); }
-        | KA NUMBER NUMBER NUMBER { set_ambient(parse_material, $2, $3, $4); }
-        | KD NUMBER NUMBER NUMBER { set_diffuse(parse_material, $2, $3, $4); }
-        | KS NUMBER NUMBER NUMBER { set_specular(parse_material, $2, $3, $4); }
-        | NS NUMBER               { set_specular_exponent(parse_material, $2); }
-        | NI NUMBER               { set_optical_density(parse_material, $2); }
-        | D NUMBER                { set_disolve(parse_material, $2); }
-        | MAPKD NAME              { set_diffuse_texture(parse_material, read_image($2)); }
-        | MAPKS NAME              { set_specular_texture(parse_material, read_image($2)); }
+property: ILLUM INDEX             { set_illumination(context->material, $2); }
+        | KA NUMBER NUMBER NUMBER { set_ambient(context->material, $2, $3, $4); }
+        | KD NUMBER NUMBER NUMBER { set_diffuse(context->material, $2, $3, $4); }
+        | KS NUMBER NUMBER NUMBER { set_specular(context->material, $2, $3, $4); }
+        | NS NUMBER               { set_specular_exponent(context->material, $2); }
+        | NI NUMBER               { set_optical_density(context->material, $2); }
+        | D NUMBER                { set_disolve(context->material, $2); }
+        | MAPKD NAME              { diffuse_texture(context, $2); }
+        | MAPKS NAME              { specular_texture(context, $2); }
 
 vertex: VERTEX NUMBER NUMBER NUMBER {
-          append_glfloat(parse_vertex, $2);
-          append_glfloat(parse_vertex, $3);
-          append_glfloat(parse_vertex, $4);
+          append_glfloat3(context->vertex, $2, $3, $4);
         }
 
 texture_coordinate: UV NUMBER NUMBER {
-                      append_glfloat(parse_uv, $2);
-                      append_glfloat(parse_uv, $3);
+                      append_glfloat(context->uv, $2);
+                      append_glfloat(context->uv, $3);
                     }
 
 normal: NORMAL NUMBER NUMBER NUMBER {
-          append_glfloat(parse_normal, $2);
-          append_glfloat(parse_normal, $3);
-          append_glfloat(parse_normal, $4);
+          append_glfloat3(context->normal, $2, $3, $4);
         }
 
-group: GROUP NAME {
-         if (!parse_result) parse_result = make_object("");
-         add_group(parse_result, make_group($2, 0));
-         use_material(last_group(), parse_use_material);
-         parse_hash = make_hash();
-       }
+group: GROUP NAME { begin_group(context, $2); }
 
-use_material: USE NAME { parse_use_material = hash_find_material(parse_materials, $2, NULL); }
+use_material: USE NAME { select_material(context, $2); }
 
 facet: FACET indices more_indices
 
-indices: index index index { add_triangle(last_group(), $1, $2, $3); }
+indices: index index index { add_triangle(last_group(context), $1, $2, $3); }
 
-more_indices: index { extend_triangle(last_group(), $1); } more_indices
+more_indices: index { extend_triangle(last_group(context), $1); } more_indices
             | /* NULL */
             ;
 
-index: INDEX                         { $$ = index_vertex(3, $1,  0,  0); }
-     | INDEX SLASH INDEX             { $$ = index_vertex(5, $1, $3,  0); }
-     | INDEX SLASH SLASH INDEX       { $$ = index_vertex(6, $1,  0, $4); }
-     | INDEX SLASH INDEX SLASH INDEX { $$ = index_vertex(8, $1, $3, $5); }
+index: INDEX                         { $$ = index_vertex(context, 3, $1,  0,  0); }
+     | INDEX SLASH INDEX             { $$ = index_vertex(context, 5, $1, $3,  0); }
+     | INDEX SLASH SLASH INDEX       { $$ = index_vertex(context, 6, $1,  0, $4); }
+     | INDEX SLASH INDEX SLASH INDEX { $$ = index_vertex(context, 8, $1, $3, $5); }
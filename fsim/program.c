@@ -1,20 +1,32 @@
-#include <gc.h>
+#include "memory.h"
 #include <GL/glew.h>
 #include "program.h"
 #include "shader.h"
 #include "report_status.h"
+#include "deletion_queue.h"
 
 
+// Deleting a program detaches its shaders.
 static void finalize_program(GC_PTR obj, GC_PTR env)
 {
-  program_t *target = (program_t *)obj;
-  if (target->program) {
-    if (target->vertex_shader)
-      glDetachShader(target->program, target->vertex_shader->shader);
-    if (target->fragment_shader)
-      glDetachShader(target->program, target->fragment_shader->shader);
-    glDeleteProgram(target->program);
+  queue_deletion(DELETE_PROGRAM, ((program_t *)obj)->program);
+}
+
+void destroy_program(program_t *program)
+{
+  GC_register_finalizer(program, 0, 0, 0, 0);
+  if (program->program) {
+    if (program->vertex_shader)
+      glDetachShader(program->program, program->vertex_shader->shader);
+    if (program->fragment_shader)
+      glDetachShader(program->program, program->fragment_shader->shader);
+    glDeleteProgram(program->program);
   };
+  if (program->vertex_shader)
+    destroy_shader(program->vertex_shader);
+  if (program->fragment_shader)
+    destroy_shader(program->fragment_shader);
+  GC_FREE(program);
 }
 
 program_t *make_program(const char *vertex_shader_file_name, const char *fragment_shader_file_name)
@@ -28,10 +40,14 @@ program_t *make_program(const char *vertex_shader_file_name, const char *fragmen
     glAttachShader(retval->program, retval->vertex_shader->shader);
     glAttachShader(retval->program, retval->fragment_shader->shader);
     glLinkProgram(retval->program);
-    if (!report_link_status(retval->program))
+    if (!report_link_status(retval->program)) {
+      destroy_program(retval);
       retval = NULL;
-  } else
+    };
+  } else {
+    destroy_program(retval);
     retval = NULL;
+  };
   return retval;
 }
 
@@ -9,6 +9,10 @@ typedef struct {
   GLuint program;
 } program_t;
 
+// A program owns its shaders. Returns NULL if a shader does not compile or the program does not link.
 program_t *make_program(const char *vertex_shader_file_name, const char *fragment_shader_file_name);
 
+// Delete the program and its shaders. This requires the OpenGL context to be current.
+void destroy_program(program_t *program);
+
 void uniform_matrix(program_t *program, const char *name, float *columns);
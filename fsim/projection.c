@@ -1,4 +1,4 @@
-#include <gc.h>
+#include "memory.h"
 #include <string.h>
 #include <math.h>
 #include "projection.h"
@@ -1,4 +1,5 @@
 #pragma once
 
 
+// The caller owns the returned matrix.
 float *projection(int width, int height, float near, float far, float field_of_view);
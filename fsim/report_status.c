@@ -1,5 +1,5 @@
 #include <stdio.h>
-#include <gc.h>
+#include "memory.h"
 #include <GL/glew.h>
 #include "report_status.h"
 
@@ -21,6 +21,7 @@ int report_status(const char *text, GLuint context, GLuint status)
       fprintf(stderr, "%s: %s\n", text, info);
     else
       result = GL_TRUE;
+    GC_FREE(info);
   };
   return result;
 }
@@ -0,0 +1,915 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define GC_THREADS
+#include "memory.h"
+#include <pthread.h>
+#include "scanner.h"
+#include "number.h"
+#include "decompress.h"
+#include "parser_actions.h"
+
+
+// Line-oriented replacement for the flex scanner and bison grammar.
+// It accepts the same statements and calls the same semantic actions.
+
+static int scan_lines(parser_context_t *context, const char *text, const char *end);
+
+static int is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char *skip_space(const char *p, const char *end)
+{
+  while (p < end && is_space(*p)) p++;
+  return p;
+}
+
+static const char *token_end(const char *p, const char *end)
+{
+  while (p < end && !is_space(*p) && *p != '#') p++;
+  return p;
+}
+
+static int at_end(const char *p, const char *end)
+{
+  p = skip_space(p, end);
+  return p == end || *p == '#';
+}
+
+static int keyword(const char *p, const char *q, const char *word)
+{
+  size_t n = strlen(word);
+  return q - p == n && !memcmp(p, word, n);
+}
+
+static int syntax_error(parser_context_t *context)
+{
+  fprintf(stderr, "Parsing line %d: syntax error\n", context->line_number);
+  return 1;
+}
+
+// Names of statements are temporaries allocated from the arena of the parser context. Without an arena the caller
+// owns the copy.
+static char *copy_text(arena_t *arena, const char *p, const char *q)
+{
+  char *result = arena ? arena_alloc(arena, q - p + 1) : GC_MALLOC_ATOMIC(q - p + 1);
+  memcpy(result, p, q - p);
+  result[q - p] = '\0';
+  return result;
+}
+
+static char *scan_name(arena_t *arena, const char *p, const char *end)
+{
+  p = skip_space(p, end);
+  const char *q = p;
+  while (q < end && *q != '\t' && *q != '\r') q++;
+  if (p == q || skip_space(q, end) != end)
+    return NULL;
+  return copy_text(arena, p, q);
+}
+
+static const char *scan_number(const char *p, const char *end, float *result)
+{
+  p = skip_space(p, end);
+  const char *q = token_end(p, end);
+  if (p == q || parse_float(p, q, result) != q)
+    return NULL;
+  return q;
+}
+
+static const char *parse_corner(const char *p, const char *end, int *corner)
+{
+  corner[0] = 3;
+  corner[2] = 0;
+  corner[3] = 0;
+  p = parse_int(p, end, &corner[1]);
+  if (!p) return NULL;
+  if (p < end && *p == '/') {
+    p++;
+    if (p < end && *p == '/') {
+      p = parse_int(p + 1, end, &corner[3]);
+      corner[0] = 6;
+    } else {
+      p = parse_int(p, end, &corner[2]);
+      corner[0] = 5;
+      if (p && p < end && *p == '/') {
+        p = parse_int(p + 1, end, &corner[3]);
+        corner[0] = 8;
+      };
+    };
+    if (!p) return NULL;
+  };
+  if (p < end && !is_space(*p) && *p != '#')
+    return NULL;
+  return p;
+}
+
+static const char *scan_corner(parser_context_t *context, const char *p, const char *end, int *result)
+{
+  int corner[4];
+  p = parse_corner(p, end, corner);
+  if (p)
+    *result = index_vertex(context, corner[0], corner[1], corner[2], corner[3]);
+  return p;
+}
+
+static void add_corner(parser_context_t *context, int n, int index, int *first)
+{
+  if (n < 2)
+    first[n] = index;
+  else if (n == 2)
+    add_triangle(last_group(context), first[0], first[1], index);
+  else
+    extend_triangle(last_group(context), index);
+}
+
+static int has_group(parser_context_t *context)
+{
+  return context->result && context->result->group->size;
+}
+
+static int scan_facet(parser_context_t *context, const char *p, const char *end)
+{
+  int first[2];
+  int n = 0;
+  if (!has_group(context))
+    return syntax_error(context);
+  while (!at_end(p, end)) {
+    int index;
+    p = scan_corner(context, skip_space(p, end), end, &index);
+    if (!p)
+      return syntax_error(context);
+    add_corner(context, n++, index, first);
+  };
+  return n < 3 ? syntax_error(context) : 0;
+}
+
+static int scan_numbers(parser_context_t *context, const char *p, const char *end, int n, float *result)
+{
+  int i;
+  for (i=0; i<n; i++) {
+    p = scan_number(p, end, &result[i]);
+    if (!p)
+      return syntax_error(context);
+  };
+  return at_end(p, end) ? 0 : syntax_error(context);
+}
+
+static int scan_coordinates(parser_context_t *context, const char *p, const char *end, int n, list_t *list)
+{
+  float value[3];
+  if (scan_numbers(context, p, end, n, value))
+    return 1;
+  append_glfloats(list, value, n);
+  return 0;
+}
+
+static const char *map_file(const char *file_name, size_t *size)
+{
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  const char *result = NULL;
+  struct stat st;
+  if (!fstat(fd, &st)) {
+    *size = st.st_size;
+    if (*size) {
+      result = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (result == MAP_FAILED)
+        result = NULL;
+      else
+        madvise((void *)result, *size, MADV_SEQUENTIAL);
+    } else
+      result = "";
+  };
+  close(fd);
+  return result;
+}
+
+static void unmap_file(const char *text, size_t size)
+{
+  if (size)
+    munmap((void *)text, size);
+}
+
+// Compressed files are scanned block by block while the remaining data is decompressed in the background.
+static int scan_compressed(parser_context_t *context, const char *file_name)
+{
+  decompressor_t *decompressor = open_decompressor(file_name);
+  if (!decompressor)
+    return -1;
+  int result = 0;
+  const char *text;
+  size_t size;
+  while (!result && (text = next_block(decompressor, &size)))
+    result = scan_lines(context, text, text + size);
+  if (!result && decompressor_error(decompressor)) {
+    fprintf(stderr, "Error decompressing file %s\n", file_name);
+    result = 1;
+  };
+  close_decompressor(decompressor);
+  return result;
+}
+
+static int scan_include(parser_context_t *context, const char *p, const char *end)
+{
+  p = skip_space(p, end);
+  char *file_name = copy_text(context->arena, p, token_end(p, end));
+  add_dependency(context, file_name);
+  if (begin_material_library(context, file_name))
+    return 0;
+  int result = 0;
+  if (is_compressed(file_name))
+    result = scan_compressed(context, file_name);
+  else {
+    size_t size;
+    const char *text = map_file(file_name, &size);
+    if (text) {
+      result = scan_lines(context, text, text + size);
+      unmap_file(text, size);
+    } else
+      result = -1;
+  };
+  end_material_library(context, !result);
+  return result > 0;
+}
+
+static int is_property(const char *p, const char *q)
+{
+  return keyword(p, q, "illum") || keyword(p, q, "Ka") || keyword(p, q, "Kd") || keyword(p, q, "Ks") ||
+         keyword(p, q, "Ns") || keyword(p, q, "Ni") || keyword(p, q, "d") || keyword(p, q, "map_Kd") ||
+         keyword(p, q, "map_Ks");
+}
+
+static int scan_property(parser_context_t *context, const char *p, const char *q, const char *end)
+{
+  float value[3];
+  char *name;
+  int index;
+  if (keyword(p, q, "illum")) {
+    q = parse_int(skip_space(q, end), end, &index);
+    if (!q || !at_end(q, end)) return syntax_error(context);
+    set_illumination(context->material, index);
+  } else if (keyword(p, q, "Ka")) {
+    if (scan_numbers(context, q, end, 3, value)) return 1;
+    set_ambient(context->material, value[0], value[1], value[2]);
+  } else if (keyword(p, q, "Kd")) {
+    if (scan_numbers(context, q, end, 3, value)) return 1;
+    set_diffuse(context->material, value[0], value[1], value[2]);
+  } else if (keyword(p, q, "Ks")) {
+    if (scan_numbers(context, q, end, 3, value)) return 1;
+    set_specular(context->material, value[0], value[1], value[2]);
+  } else if (keyword(p, q, "Ns")) {
+    if (scan_numbers(context, q, end, 1, value)) return 1;
+    set_specular_exponent(context->material, value[0]);
+  } else if (keyword(p, q, "Ni")) {
+    if (scan_numbers(context, q, end, 1, value)) return 1;
+    set_optical_density(context->material, value[0]);
+  } else if (keyword(p, q, "d")) {
+    if (scan_numbers(context, q, end, 1, value)) return 1;
+    set_disolve(context->material, value[0]);
+  } else if (keyword(p, q, "map_Kd")) {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    diffuse_texture(context, name);
+  } else {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    specular_texture(context, name);
+  };
+  return 0;
+}
+
+static int scan_statement(parser_context_t *context, const char *p, const char *end)
+{
+  const char *q = token_end(p, end);
+  char *name;
+  if (keyword(p, q, "mtllib"))
+    return scan_include(context, q, end);
+  if (keyword(p, q, "newmtl")) {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    begin_material(context, name);
+    context->in_material = 1;
+    return 0;
+  };
+  // Material properties are only valid directly after "newmtl" or another property.
+  if (is_property(p, q))
+    return context->in_material ? scan_property(context, p, q, end) : syntax_error(context);
+  context->in_material = 0;
+  if (keyword(p, q, "v"))
+    return scan_coordinates(context, q, end, 3, context->vertex);
+  if (keyword(p, q, "vt"))
+    return scan_coordinates(context, q, end, 2, context->uv);
+  if (keyword(p, q, "vn"))
+    return scan_coordinates(context, q, end, 3, context->normal);
+  if (keyword(p, q, "f"))
+    return scan_facet(context, q, end);
+  if (keyword(p, q, "o")) {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    begin_object(context, name);
+  } else if (keyword(p, q, "g")) {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    begin_group(context, name);
+  } else if (keyword(p, q, "usemtl")) {
+    if (!(name = scan_name(context->arena, q, end))) return syntax_error(context);
+    select_material(context, name);
+  } else {
+    fprintf(stderr, "Tokenizing line %d: unexpected character '%c'.\n", context->line_number, *p);
+    return 1;
+  };
+  return 0;
+}
+
+static int scan_lines(parser_context_t *context, const char *text, const char *end)
+{
+  while (text < end) {
+    const char *line_end = memchr(text, '\n', end - text);
+    if (!line_end) line_end = end;
+    const char *p = skip_space(text, line_end);
+    if (p < line_end && *p != '#') {
+      int result = scan_statement(context, p, line_end);
+      if (result)
+        return result;
+    };
+    context->line_number++;
+    text = line_end + 1;
+  };
+  return 0;
+}
+
+static int count_tokens(const char *p, const char *end)
+{
+  int result = 0;
+  while (!at_end(p, end)) {
+    p = token_end(skip_space(p, end), end);
+    result++;
+  };
+  return result;
+}
+
+// Count coordinates and the indices of each group so that the lists can be allocated at their final size.
+// The number of unique vertices of a group is only known after deduplication.
+static void count_records(parser_context_t *context, const char *text, const char *end)
+{
+  int n_vertex = 0;
+  int n_uv = 0;
+  int n_normal = 0;
+  list_t *group_indices = make_arena_list(context->arena);
+  while (text < end) {
+    const char *line_end = memchr(text, '\n', end - text);
+    if (!line_end) line_end = end;
+    const char *p = skip_space(text, line_end);
+    const char *q = token_end(p, line_end);
+    if (keyword(p, q, "v"))
+      n_vertex++;
+    else if (keyword(p, q, "vt"))
+      n_uv++;
+    else if (keyword(p, q, "vn"))
+      n_normal++;
+    else if (keyword(p, q, "g"))
+      append_gluint(group_indices, 0);
+    else if (keyword(p, q, "f") && group_indices->size) {
+      int n = count_tokens(q, line_end);
+      if (n >= 3)
+        get_gluint(group_indices)[group_indices->size - 1] += 3 * (n - 2);
+    };
+    text = line_end + 1;
+  };
+  reserve_glfloat(context->vertex, 3 * n_vertex);
+  reserve_glfloat(context->uv, 2 * n_uv);
+  reserve_glfloat(context->normal, 3 * n_normal);
+  context->group_indices = group_indices;
+}
+
+// Parallel scanning splits the text at line boundaries. Worker threads convert vertex coordinates and facet
+// indices of their chunk into buffers. The chunks are then merged in order on the calling thread, which
+// resolves relative indices, deduplicates vertices and replays all other statements.
+
+enum {COMMAND_VERTEX, COMMAND_UV, COMMAND_NORMAL, COMMAND_FACET, COMMAND_LINE};
+
+typedef struct {
+  const char *text;
+  const char *end;
+  int n_lines;
+  list_t *vertex;
+  list_t *uv;
+  list_t *normal;
+  list_t *command;
+  int64_t run;
+  char threaded;
+} chunk_t;
+
+static void append_command(chunk_t *chunk, GLuint command, GLuint value)
+{
+  append_gluint(chunk->command, command);
+  append_gluint(chunk->command, value);
+}
+
+static void append_run(chunk_t *chunk, GLuint command)
+{
+  GLuint *element = get_gluint(chunk->command);
+  if (chunk->run >= 0 && element[chunk->run] == command)
+    element[chunk->run + 1]++;
+  else {
+    chunk->run = chunk->command->size;
+    append_command(chunk, command, 1);
+  };
+}
+
+static int chunk_coordinates(chunk_t *chunk, GLuint command, const char *p, const char *end, int n, list_t *list)
+{
+  float value[3];
+  int i;
+  for (i=0; i<n; i++) {
+    p = scan_number(p, end, &value[i]);
+    if (!p)
+      return 1;
+  };
+  if (!at_end(p, end))
+    return 1;
+  append_glfloats(list, value, n);
+  append_run(chunk, command);
+  return 0;
+}
+
+static int chunk_facet(chunk_t *chunk, const char *p, const char *end, int line)
+{
+  int64_t start = chunk->command->size;
+  int n = 0;
+  append_command(chunk, COMMAND_FACET, line);
+  append_gluint(chunk->command, 0);
+  while (!at_end(p, end)) {
+    int corner[4];
+    p = parse_corner(skip_space(p, end), end, corner);
+    if (!p) {
+      chunk->command->size = start;
+      return 1;
+    };
+    append_gluints(chunk->command, (GLuint *)corner, 4);
+    n++;
+  };
+  if (n < 3) {
+    chunk->command->size = start;
+    return 1;
+  };
+  get_gluint(chunk->command)[start + 2] = n;
+  chunk->run = -1;
+  return 0;
+}
+
+static void chunk_statement(chunk_t *chunk, const char *p, const char *end, int line)
+{
+  const char *q = token_end(p, end);
+  int result = 1;
+  if (keyword(p, q, "v"))
+    result = chunk_coordinates(chunk, COMMAND_VERTEX, q, end, 3, chunk->vertex);
+  else if (keyword(p, q, "vt"))
+    result = chunk_coordinates(chunk, COMMAND_UV, q, end, 2, chunk->uv);
+  else if (keyword(p, q, "vn"))
+    result = chunk_coordinates(chunk, COMMAND_NORMAL, q, end, 3, chunk->normal);
+  else if (keyword(p, q, "f"))
+    result = chunk_facet(chunk, q, end, line);
+  // Anything else including malformed records is replayed by the sequential scanner.
+  if (result) {
+    append_command(chunk, COMMAND_LINE, p - chunk->text);
+    append_gluint(chunk->command, end - p);
+    append_gluint(chunk->command, line);
+    chunk->run = -1;
+  };
+}
+
+static void *scan_chunk(void *arg)
+{
+  chunk_t *chunk = arg;
+  const char *text = chunk->text;
+  int line = 0;
+  while (text < chunk->end) {
+    const char *line_end = memchr(text, '\n', chunk->end - text);
+    if (!line_end) line_end = chunk->end;
+    const char *p = skip_space(text, line_end);
+    if (p < line_end && *p != '#')
+      chunk_statement(chunk, p, line_end, line);
+    line++;
+    text = line_end + 1;
+  };
+  chunk->n_lines = line;
+  return NULL;
+}
+
+static void merge_coordinates(list_t *target, list_t *source, int64_t *offset, int64_t n)
+{
+  append_glfloats(target, get_glfloat(source) + *offset, n);
+  *offset += n;
+}
+
+static int merge_chunk(parser_context_t *context, chunk_t *chunk, int first_line)
+{
+  GLuint *command = get_gluint(chunk->command);
+  int64_t vertex = 0;
+  int64_t uv = 0;
+  int64_t normal = 0;
+  int64_t i = 0;
+  while (i < chunk->command->size) {
+    GLuint type = command[i];
+    int result = 0;
+    switch (type) {
+    case COMMAND_VERTEX:
+      merge_coordinates(context->vertex, chunk->vertex, &vertex, 3 * (int64_t)command[i + 1]);
+      i += 2;
+      break;
+    case COMMAND_UV:
+      merge_coordinates(context->uv, chunk->uv, &uv, 2 * (int64_t)command[i + 1]);
+      i += 2;
+      break;
+    case COMMAND_NORMAL:
+      merge_coordinates(context->normal, chunk->normal, &normal, 3 * (int64_t)command[i + 1]);
+      i += 2;
+      break;
+    case COMMAND_FACET: {
+      context->line_number = first_line + command[i + 1];
+      int n = command[i + 2];
+      int *corner = (int *)&command[i + 3];
+      int first[2];
+      int j;
+      if (!has_group(context))
+        return syntax_error(context);
+      for (j=0; j<n; j++, corner += 4)
+        add_corner(context, j, index_vertex(context, corner[0], corner[1], corner[2], corner[3]), first);
+      i += 3 + 4 * n;
+      break;
+    }
+    default:
+      context->line_number = first_line + command[i + 3];
+      result = scan_statement(context, chunk->text + command[i + 1], chunk->text + command[i + 1] + command[i + 2]);
+      i += 4;
+    };
+    if (result)
+      return result;
+    if (type != COMMAND_LINE)
+      context->in_material = 0;
+  };
+  return 0;
+}
+
+// The buffers of a merged chunk are returned to the arena right away.
+static void release_chunk(chunk_t *chunk)
+{
+  destroy_list(chunk->vertex);
+  destroy_list(chunk->uv);
+  destroy_list(chunk->normal);
+  destroy_list(chunk->command);
+}
+
+// Scan a chunk on a new thread. If the thread cannot be created, the chunk is scanned on the calling thread when it
+// is merged.
+static void start_chunk(pthread_t *thread, chunk_t *chunk)
+{
+  chunk->threaded = !pthread_create(thread, NULL, scan_chunk, chunk);
+}
+
+int scan_buffer_parallel(parser_context_t *context, const char *text, size_t size, int n_threads)
+{
+  return scan_buffer_chunks(context, text, size, n_threads, SCAN_CHUNK_LIMIT);
+}
+
+int scan_buffer_chunks(parser_context_t *context, const char *text, size_t size, int n_threads, size_t chunk_limit)
+{
+  if (n_threads <= 1)
+    return scan_buffer(context, text, size);
+  if (context->prescan)
+    count_records(context, text, text + size);
+  int n_chunks = n_threads;
+  if (size / chunk_limit >= n_chunks)
+    n_chunks = size / chunk_limit + 1;
+  chunk_t *chunk = GC_MALLOC(n_chunks * sizeof(chunk_t));
+  pthread_t *thread = GC_MALLOC_ATOMIC(n_chunks * sizeof(pthread_t));
+  const char *start = text;
+  int i;
+  for (i=0; i<n_chunks; i++) {
+    const char *end = text + size * (i + 1) / n_chunks;
+    if (end < start) end = start;
+    const char *line_end = end < text + size ? memchr(end, '\n', text + size - end) : NULL;
+    end = line_end ? line_end + 1 : text + size;
+    chunk[i].text = start;
+    chunk[i].end = end;
+    chunk[i].vertex = make_arena_list(context->arena);
+    chunk[i].uv = make_arena_list(context->arena);
+    chunk[i].normal = make_arena_list(context->arena);
+    chunk[i].command = make_arena_list(context->arena);
+    chunk[i].run = -1;
+    start = end;
+  };
+  for (i=0; i<n_threads && i<n_chunks; i++)
+    start_chunk(&thread[i], &chunk[i]);
+  context->line_number = 1;
+  context->in_material = 0;
+  int first_line = 1;
+  int result = 0;
+  // Merge each chunk as soon as it is available so that finished groups are passed on early. A finished worker is
+  // replaced by one scanning the next chunk.
+  for (i=0; i<n_chunks; i++) {
+    if (chunk[i].threaded)
+      pthread_join(thread[i], NULL);
+    else
+      scan_chunk(&chunk[i]);
+    if (i + n_threads < n_chunks)
+      start_chunk(&thread[i + n_threads], &chunk[i + n_threads]);
+    if (!result)
+      result = merge_chunk(context, &chunk[i], first_line);
+    release_chunk(&chunk[i]);
+    first_line += chunk[i].n_lines;
+  };
+  GC_FREE(thread);
+  GC_FREE(chunk);
+  return result;
+}
+
+int scan_buffer(parser_context_t *context, const char *text, size_t size)
+{
+  context->line_number = 1;
+  context->in_material = 0;
+  if (context->prescan)
+    count_records(context, text, text + size);
+  return scan_lines(context, text, text + size);
+}
+
+int scan_file(parser_context_t *context, const char *file_name)
+{
+  return scan_file_parallel(context, file_name, 1);
+}
+
+int scan_file_parallel(parser_context_t *context, const char *file_name, int n_threads)
+{
+  if (is_compressed(file_name)) {
+    context->line_number = 1;
+    context->in_material = 0;
+    int result = scan_compressed(context, file_name);
+    if (result < 0)
+      fprintf(stderr, "Error opening file %s: %s\n", file_name, strerror(errno));
+    return result != 0;
+  };
+  size_t size;
+  const char *text = map_file(file_name, &size);
+  if (!text) {
+    fprintf(stderr, "Error opening file %s: %s\n", file_name, strerror(errno));
+    return 1;
+  };
+  int result = scan_buffer_parallel(context, text, size, n_threads);
+  unmap_file(text, size);
+  return result;
+}
+
+// Offsets of the coordinate records of one kind and the smallest index referenced by the current group.
+typedef struct {
+  int64_t *offset;
+  int size;
+  int buffer_size;
+  int first;
+} records_t;
+
+static void append_record(records_t *records, int64_t offset)
+{
+  if (records->size == records->buffer_size) {
+    records->buffer_size = records->buffer_size ? 2 * records->buffer_size : 1024;
+    if (records->offset)
+      records->offset = GC_REALLOC(records->offset, records->buffer_size * sizeof(int64_t));
+    else
+      records->offset = GC_MALLOC_ATOMIC(records->buffer_size * sizeof(int64_t));
+  };
+  records->offset[records->size++] = offset;
+}
+
+static void reference_record(records_t *records, int index)
+{
+  if (index < 0) index += 1 + records->size;
+  if (index > 0 && index < records->first) records->first = index;
+}
+
+static int records_before(records_t *records, int64_t offset)
+{
+  int lower = 0;
+  int upper = records->size;
+  while (lower < upper) {
+    int middle = (lower + upper) / 2;
+    if (records->offset[middle] < offset)
+      lower = middle + 1;
+    else
+      upper = middle;
+  };
+  return lower;
+}
+
+static void index_facet(records_t *records, const char *p, const char *end)
+{
+  while (!at_end(p, end)) {
+    int corner[4];
+    p = parse_corner(skip_space(p, end), end, corner);
+    if (!p)
+      return;
+    reference_record(&records[0], corner[1]);
+    reference_record(&records[1], corner[2]);
+    reference_record(&records[2], corner[3]);
+  };
+}
+
+static group_entry_t *begin_entry(group_index_t *index, records_t *records, char *name, char *material, int64_t offset,
+                                  int line)
+{
+  group_entry_t *result = GC_MALLOC(sizeof(group_entry_t));
+  result->name = name;
+  result->material = material ? copy_text(NULL, material, material + strlen(material)) : NULL;
+  result->block.start = offset;
+  result->block.line = line;
+  int i;
+  for (i=0; i<3; i++)
+    records[i].first = INT_MAX;
+  append_pointer(index->entries, result);
+  return result;
+}
+
+static void finish_entry(group_entry_t *entry, records_t *records, int64_t offset)
+{
+  entry->block.end = offset;
+  entry->vertex_start = entry->block.start;
+  int i;
+  for (i=0; i<3; i++)
+    if (records[i].first <= records[i].size && records[i].offset[records[i].first - 1] < entry->vertex_start)
+      entry->vertex_start = records[i].offset[records[i].first - 1];
+  entry->n_vertex = records_before(&records[0], entry->vertex_start);
+  entry->n_uv = records_before(&records[1], entry->vertex_start);
+  entry->n_normal = records_before(&records[2], entry->vertex_start);
+}
+
+// Consecutive lines are merged into one range.
+static void add_definition(group_index_t *index, int64_t start, int64_t end, int line)
+{
+  list_t *definitions = index->definitions;
+  text_range_t *last = definitions->size ? get_pointer(definitions)[definitions->size - 1] : NULL;
+  if (last && last->end == start)
+    last->end = end;
+  else {
+    text_range_t *range = GC_MALLOC_ATOMIC(sizeof(text_range_t));
+    range->start = start;
+    range->end = end;
+    range->line = line;
+    append_pointer(definitions, range);
+  };
+}
+
+group_index_t *index_groups(const char *file_name)
+{
+  if (is_compressed(file_name))
+    return NULL;
+  size_t size;
+  const char *text = map_file(file_name, &size);
+  if (!text)
+    return NULL;
+  group_index_t *result = make_group_index();
+  records_t records[3];
+  memset(records, 0, sizeof(records));
+  group_entry_t *entry = NULL;
+  char *material = NULL;
+  int in_material = 0;
+  int line = 1;
+  const char *end = text + size;
+  const char *line_start = text;
+  while (line_start < end) {
+    const char *line_end = memchr(line_start, '\n', end - line_start);
+    if (!line_end) line_end = end;
+    const char *p = skip_space(line_start, line_end);
+    const char *q = token_end(p, line_end);
+    int64_t offset = line_start - text;
+    int definition = keyword(p, q, "mtllib") || keyword(p, q, "newmtl") || (in_material && is_property(p, q));
+    if (keyword(p, q, "v"))
+      append_record(&records[0], offset);
+    else if (keyword(p, q, "vt"))
+      append_record(&records[1], offset);
+    else if (keyword(p, q, "vn"))
+      append_record(&records[2], offset);
+    else if (keyword(p, q, "f")) {
+      if (entry)
+        index_facet(records, q, line_end);
+    } else if (keyword(p, q, "g") || keyword(p, q, "o")) {
+      if (entry)
+        finish_entry(entry, records, offset);
+      entry = NULL;
+      char *name = scan_name(NULL, q, line_end);
+      if (keyword(p, q, "o")) {
+        // Like the parser, start over when a new object begins.
+        GC_FREE(result->object_name);
+        result->object_name = name;
+        destroy_group_entries(result->entries);
+        result->entries = make_list();
+      } else if (name)
+        entry = begin_entry(result, records, name, material, offset, line);
+    } else if (keyword(p, q, "usemtl")) {
+      GC_FREE(material);
+      material = scan_name(NULL, q, line_end);
+    } else if (definition)
+      add_definition(result, offset, (line_end < end ? line_end + 1 : end) - text, line);
+    if (p < line_end && *p != '#')
+      in_material = keyword(p, q, "newmtl") || (in_material && is_property(p, q));
+    line++;
+    line_start = line_end + 1;
+  };
+  if (entry)
+    finish_entry(entry, records, size);
+  unmap_file(text, size);
+  GC_FREE(material);
+  int i;
+  for (i=0; i<3; i++)
+    GC_FREE(records[i].offset);
+  return result;
+}
+
+static int is_requested(group_entry_t *entry, const char **names)
+{
+  int i;
+  for (i=0; names[i]; i++)
+    if (!strcmp(entry->name, names[i]))
+      return 1;
+  return 0;
+}
+
+static int scan_range(parser_context_t *context, const char *text, size_t size, text_range_t *range)
+{
+  if (range->start < 0 || range->start > range->end || range->end > size) {
+    fprintf(stderr, "Group index does not match object file\n");
+    return 1;
+  };
+  context->line_number = range->line;
+  return scan_lines(context, text + range->start, text + range->end);
+}
+
+// Only the coordinate records are read in front of a group.
+static int scan_coordinate_lines(parser_context_t *context, const char *text, const char *end)
+{
+  while (text < end) {
+    const char *line_end = memchr(text, '\n', end - text);
+    if (!line_end) line_end = end;
+    const char *p = skip_space(text, line_end);
+    const char *q = token_end(p, line_end);
+    int result = 0;
+    if (keyword(p, q, "v"))
+      result = scan_coordinates(context, q, line_end, 3, context->vertex);
+    else if (keyword(p, q, "vt"))
+      result = scan_coordinates(context, q, line_end, 2, context->uv);
+    else if (keyword(p, q, "vn"))
+      result = scan_coordinates(context, q, line_end, 3, context->normal);
+    if (result)
+      return result;
+    text = line_end + 1;
+  };
+  return 0;
+}
+
+static int scan_entry(parser_context_t *context, const char *text, size_t size, group_entry_t *entry)
+{
+  if (entry->vertex_start < 0 || entry->vertex_start > entry->block.start) {
+    fprintf(stderr, "Group index does not match object file\n");
+    return 1;
+  };
+  context->vertex->size = 0;
+  context->uv->size = 0;
+  context->normal->size = 0;
+  context->vertex_base = entry->n_vertex;
+  context->uv_base = entry->n_uv;
+  context->normal_base = entry->n_normal;
+  int result = scan_coordinate_lines(context, text + entry->vertex_start, text + entry->block.start);
+  if (result)
+    return result;
+  context->use_material = NULL;
+  if (entry->material)
+    select_material(context, entry->material);
+  context->in_material = 0;
+  return scan_range(context, text, size, &entry->block);
+}
+
+int scan_groups(parser_context_t *context, const char *file_name, group_index_t *index, const char **names)
+{
+  size_t size;
+  const char *text = map_file(file_name, &size);
+  if (!text) {
+    fprintf(stderr, "Error opening file %s: %s\n", file_name, strerror(errno));
+    return 1;
+  };
+  begin_object(context, index->object_name ? index->object_name : "");
+  context->in_material = 0;
+  int result = 0;
+  int i;
+  for (i=0; !result && i<index->definitions->size; i++)
+    result = scan_range(context, text, size, get_pointer(index->definitions)[i]);
+  for (i=0; !result && i<index->entries->size; i++) {
+    group_entry_t *entry = get_pointer(index->entries)[i];
+    if (is_requested(entry, names))
+      result = scan_entry(context, text, size, entry);
+  };
+  unmap_file(text, size);
+  return result;
+}
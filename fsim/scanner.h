@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include "parser.h"
+#include "cache.h"
+
+
+int scan_buffer(parser_context_t *context, const char *text, size_t size);
+
+// Chunks record statement offsets and lengths as 32-bit values. Files larger than n_threads chunks of this size
+// are split into more chunks than threads.
+#define SCAN_CHUNK_LIMIT ((size_t)1 << 30)
+
+int scan_buffer_parallel(parser_context_t *context, const char *text, size_t size, int n_threads);
+
+// Scan with chunks of at most chunk_limit bytes (plus the rest of the line at the end of a chunk).
+int scan_buffer_chunks(parser_context_t *context, const char *text, size_t size, int n_threads, size_t chunk_limit);
+
+int scan_file(parser_context_t *context, const char *file_name);
+
+// Files compressed with gzip or xz are scanned serially while they are being decompressed.
+int scan_file_parallel(parser_context_t *context, const char *file_name, int n_threads);
+
+// Record the file offsets of the groups and of the coordinates they reference. Returns NULL for compressed files.
+group_index_t *index_groups(const char *file_name);
+
+int scan_groups(parser_context_t *context, const char *file_name, group_index_t *index, const char **names);
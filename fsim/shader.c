@@ -1,16 +1,23 @@
 #include <stdio.h>
 #include <sys/stat.h>
-#include <gc.h>
+#include "memory.h"
 #include <GL/glew.h>
 #include "shader.h"
 #include "report_status.h"
+#include "deletion_queue.h"
 
 
 static void finalize_shader(GC_PTR obj, GC_PTR env)
 {
-  shader_t *target = (shader_t *)obj;
-  if (target->shader)
-    glDeleteShader(target->shader);
+  queue_deletion(DELETE_SHADER, ((shader_t *)obj)->shader);
+}
+
+void destroy_shader(shader_t *shader)
+{
+  GC_register_finalizer(shader, 0, 0, 0, 0);
+  if (shader->shader)
+    glDeleteShader(shader->shader);
+  GC_FREE(shader);
 }
 
 shader_t *make_shader(GLenum shader_type, const char *file_name)
@@ -30,9 +37,14 @@ shader_t *make_shader(GLenum shader_type, const char *file_name)
     const GLchar *shader_source = source;
     glShaderSource(retval->shader, 1, &shader_source, NULL);
     glCompileShader(retval->shader);
-    if (!report_compile_status(file_name, retval->shader))
+    GC_FREE(source);
+    if (!report_compile_status(file_name, retval->shader)) {
+      destroy_shader(retval);
       retval = NULL;
-  } else
+    };
+  } else {
+    destroy_shader(retval);
     retval = NULL;
+  };
   return retval;
 }
@@ -7,4 +7,8 @@ typedef struct
   GLuint shader;
 } shader_t;
 
+// Returns NULL if the file cannot be read or the shader does not compile.
 shader_t *make_shader(GLenum shader_type, const char *file_name);
+
+// Delete the shader. This requires the OpenGL context to be current.
+void destroy_shader(shader_t *shader);
@@ -1,18 +1,41 @@
-#include <gc.h>
+#include "memory.h"
 #include "texture.h"
+#include "deletion_queue.h"
+#include "accounting.h"
+#include "texture_cache.h"
 
 
+static void release_bytes(texture_t *texture)
+{
+  if (texture->bytes)
+    account_release(MEMORY_GL_TEXTURE, texture->bytes);
+}
+
 static void finalize_texture(GC_PTR obj, GC_PTR env)
 {
-  texture_t *target = (texture_t *)obj;
-  glDeleteTextures(1, &target->texture);
+  release_bytes((texture_t *)obj);
+  queue_deletion(DELETE_TEXTURE, ((texture_t *)obj)->texture);
+}
+
+void destroy_texture(texture_t *texture)
+{
+  if (release_texture_reference(texture) > 0)
+    return;
+  GC_register_finalizer(texture, 0, 0, 0, 0);
+  glDeleteTextures(1, &texture->texture);
+  release_bytes(texture);
+  GC_FREE(texture->file_name);
+  GC_FREE(texture);
 }
 
 texture_t *make_texture(const char *name)
 {
-  texture_t *retval = GC_MALLOC_ATOMIC(sizeof(texture_t));
+  texture_t *retval = GC_MALLOC(sizeof(texture_t));
   GC_register_finalizer(retval, finalize_texture, 0, 0, 0);
   retval->name = name;
+  retval->file_name = NULL;
+  retval->bytes = 0;
+  retval->references = 1;
   glGenTextures(1, &retval->texture);
   return retval;
 }
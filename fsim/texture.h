@@ -1,11 +1,21 @@
 #pragma once
+#include <stdint.h>
 #include <GL/gl.h>
 
 
+// The name is the sampler uniform and is not copied. The texture owns its copy of the file name. The bytes uploaded
+// to the texture are accounted as MEMORY_GL_TEXTURE until the texture is released. Textures shared by the texture
+// cache count the materials referencing them.
 typedef struct
 {
   const char *name;
   GLuint texture;
+  char *file_name;
+  int64_t bytes;
+  int references;
 } texture_t;
 
 texture_t *make_texture(const char *name);
+
+// Release a reference and delete the texture when it was the last one. This requires the OpenGL context to be current.
+void destroy_texture(texture_t *texture);
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memory.h"
+#include "texture_cache.h"
+
+
+static int texture_cache = 0;
+static int texture_content_hash = 0;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t entry_completed = PTHREAD_COND_INITIALIZER;
+static texture_entry_t *entries = NULL;
+static int64_t hits = 0;
+static int64_t misses = 0;
+static int64_t bytes_saved = 0;
+
+void set_texture_cache(int enabled)
+{
+  texture_cache = enabled;
+}
+
+int get_texture_cache(void)
+{
+  return texture_cache;
+}
+
+void set_texture_content_hash(int enabled)
+{
+  texture_content_hash = enabled;
+}
+
+int get_texture_content_hash(void)
+{
+  return texture_content_hash;
+}
+
+// 64-bit FNV-1a hash of the file content. Returns zero if the file cannot be read.
+static uint64_t hash_file(const char *file_name, off_t size)
+{
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  uint64_t result = 0;
+  const unsigned char *data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  if (data != MAP_FAILED) {
+    result = 0xcbf29ce484222325ull;
+    off_t i;
+    for (i=0; i<size; i++)
+      result = (result ^ data[i]) * 0x100000001b3ull;
+    if (data)
+      munmap((void *)data, size);
+  };
+  close(fd);
+  return result;
+}
+
+// Read the hidden texture pointer while the collector cannot clear it.
+static void *reveal_texture(void *entry)
+{
+  uintptr_t texture = ((texture_entry_t *)entry)->texture;
+  return texture ? GC_REVEAL_POINTER(texture) : NULL;
+}
+
+// Unlink the entries whose texture was collected. Other threads may still hold them, so they are left to the
+// collector as well.
+static void drop_collected_entries(void)
+{
+  texture_entry_t **entry = &entries;
+  while (*entry)
+    if ((*entry)->loaded && !(*entry)->texture)
+      *entry = (*entry)->next;
+    else
+      entry = &(*entry)->next;
+}
+
+// Entries without texture and loader failed to load and are not used any more.
+static int available(texture_entry_t *entry)
+{
+  return entry->texture || entry->loading;
+}
+
+static int same_file(texture_entry_t *entry, const char *name, const char *file_name, struct stat *st)
+{
+  return !strcmp(entry->name, name) && !strcmp(entry->file_name, file_name) &&
+         entry->mtime.tv_sec == st->st_mtim.tv_sec && entry->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+         entry->size == st->st_size;
+}
+
+static int same_content(texture_entry_t *entry, const char *name, uint64_t content, off_t size)
+{
+  return !strcmp(entry->name, name) && entry->content == content && entry->size == size;
+}
+
+texture_entry_t *request_texture_entry(const char *name, const char *file_name, struct pending_texture_t *loader)
+{
+  struct stat st;
+  char *path = realpath(file_name, NULL);
+  if (!path || stat(path, &st)) {
+    free(path);
+    return NULL;
+  };
+  uint64_t content = texture_content_hash ? hash_file(path, st.st_size) : 0;
+  pthread_mutex_lock(&cache_mutex);
+  drop_collected_entries();
+  texture_entry_t *result = entries;
+  while (result && !(available(result) && (same_file(result, name, path, &st) ||
+                                           (content && same_content(result, name, content, st.st_size)))))
+    result = result->next;
+  if (result)
+    hits++;
+  else {
+    misses++;
+    result = GC_MALLOC(sizeof(texture_entry_t));
+    result->name = name;
+    result->file_name = GC_MALLOC_ATOMIC(strlen(path) + 1);
+    strcpy(result->file_name, path);
+    result->mtime = st.st_mtim;
+    result->size = st.st_size;
+    result->content = content;
+    result->texture = 0;
+    result->loaded = 0;
+    result->loading = loader;
+    result->owner = pthread_self();
+    result->next = entries;
+    entries = result;
+  };
+  pthread_mutex_unlock(&cache_mutex);
+  free(path);
+  return result;
+}
+
+int loads_texture_entry(texture_entry_t *entry, struct pending_texture_t *loader)
+{
+  pthread_mutex_lock(&cache_mutex);
+  int result = entry->loading == loader;
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+// Find an entry which is still being loaded by the calling thread.
+static struct pending_texture_t *own_loader(void)
+{
+  texture_entry_t *entry = entries;
+  while (entry && !(entry->loading && pthread_equal(entry->owner, pthread_self())))
+    entry = entry->next;
+  return entry ? entry->loading : NULL;
+}
+
+struct pending_texture_t *wait_for_texture_entry(texture_entry_t *entry)
+{
+  pthread_mutex_lock(&cache_mutex);
+  struct pending_texture_t *result = NULL;
+  while (entry->loading && !(result = own_loader()))
+    pthread_cond_wait(&entry_completed, &cache_mutex);
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+texture_t *share_texture(texture_entry_t *entry)
+{
+  pthread_mutex_lock(&cache_mutex);
+  texture_t *result = GC_call_with_alloc_lock(reveal_texture, entry);
+  if (result) {
+    result->references++;
+    bytes_saved += result->bytes;
+  };
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+void complete_texture_entry(texture_entry_t *entry, texture_t *texture)
+{
+  pthread_mutex_lock(&cache_mutex);
+  if (texture) {
+    entry->texture = GC_HIDE_POINTER(texture);
+    entry->loaded = 1;
+    GC_general_register_disappearing_link((void **)&entry->texture, texture);
+  };
+  entry->loading = NULL;
+  pthread_cond_broadcast(&entry_completed);
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+static void destroy_entry(texture_entry_t *entry)
+{
+  GC_unregister_disappearing_link((void **)&entry->texture);
+  GC_FREE(entry->file_name);
+  GC_FREE(entry);
+}
+
+int release_texture_reference(texture_t *texture)
+{
+  pthread_mutex_lock(&cache_mutex);
+  int result = --texture->references;
+  if (!result) {
+    texture_entry_t **entry = &entries;
+    while (*entry && (*entry)->texture != GC_HIDE_POINTER(texture))
+      entry = &(*entry)->next;
+    if (*entry) {
+      texture_entry_t *forgotten = *entry;
+      *entry = forgotten->next;
+      destroy_entry(forgotten);
+    };
+  };
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+void clear_texture_cache(void)
+{
+  pthread_mutex_lock(&cache_mutex);
+  while (entries) {
+    texture_entry_t *next = entries->next;
+    destroy_entry(entries);
+    entries = next;
+  };
+  hits = 0;
+  misses = 0;
+  bytes_saved = 0;
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+int64_t texture_cache_hits(void)
+{
+  pthread_mutex_lock(&cache_mutex);
+  int64_t result = hits;
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+int64_t texture_cache_misses(void)
+{
+  pthread_mutex_lock(&cache_mutex);
+  int64_t result = misses;
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
+
+int64_t texture_bytes_saved(void)
+{
+  pthread_mutex_lock(&cache_mutex);
+  int64_t result = bytes_saved;
+  pthread_mutex_unlock(&cache_mutex);
+  return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "texture.h"
+
+
+struct pending_texture_t;
+
+// Textures requested for image files are shared between materials while the cache is enabled. An entry is found by
+// the sampler name together with the canonical path, modification time and size of the image file, or optionally by
+// a hash of the file content so that identical copies under different names are decoded and uploaded only once.
+// The first request of an entry loads the texture on its thread and later requests wait for it. The materials hold
+// references to the shared textures (see destroy_texture) and the entry is removed when the last reference is
+// released. The entry hides its pointer to the texture from the garbage collector, so that textures of collected
+// materials are still finalized. The collector then clears the pointer and the entry is dropped by the next request.
+typedef struct texture_entry_t {
+  const char *name;
+  char *file_name;
+  struct timespec mtime;
+  off_t size;
+  uint64_t content;
+  uintptr_t texture;
+  int loaded;
+  struct pending_texture_t *loading;
+  pthread_t owner;
+  struct texture_entry_t *next;
+} texture_entry_t;
+
+void set_texture_cache(int enabled);
+
+int get_texture_cache(void);
+
+void set_texture_content_hash(int enabled);
+
+int get_texture_content_hash(void);
+
+// Get the entry for the sampler and the image file. If the texture is not cached yet, a new entry is returned which
+// is loaded by the given pending texture. Returns NULL if the file does not exist.
+texture_entry_t *request_texture_entry(const char *name, const char *file_name, struct pending_texture_t *loader);
+
+// Check whether the pending texture is loading the entry.
+int loads_texture_entry(texture_entry_t *entry, struct pending_texture_t *loader);
+
+// Wait until the entry is complete. While the calling thread is loading entries itself, one of its pending textures
+// is returned instead. The caller has to upload it and call this function again, so that threads never wait for each
+// other. Returns NULL once the entry is complete.
+struct pending_texture_t *wait_for_texture_entry(texture_entry_t *entry);
+
+// Get a new reference to the texture of an entry. Returns NULL if the image could not be loaded.
+texture_t *share_texture(texture_entry_t *entry);
+
+// Store the texture loaded for an entry. The texture is NULL if loading failed or was abandoned, in which case the
+// entry is not used for later requests.
+void complete_texture_entry(texture_entry_t *entry, texture_t *texture);
+
+// Release a reference to a texture and remove its entry when it was the last one. Both happen under the lock of the
+// cache so that the texture cannot be shared again in between. Returns the number of remaining references.
+int release_texture_reference(texture_t *texture);
+
+// Release all entries. The textures are not released because they are owned by the materials.
+void clear_texture_cache(void);
+
+int64_t texture_cache_hits(void);
+
+int64_t texture_cache_misses(void);
+
+// Bytes which did not have to be decoded and uploaded because a texture was shared.
+int64_t texture_bytes_saved(void);
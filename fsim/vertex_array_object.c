@@ -1,80 +1,369 @@
-#include <gc.h>
+#include <string.h>
+#include "memory.h"
 #include <GL/glew.h>
 #include "vertex_array_object.h"
+#include "deletion_queue.h"
+#include "accounting.h"
 
 
+static upload_mode_t upload_mode = UPLOAD_KEEP;
+
+void set_upload_mode(upload_mode_t mode)
+{
+  upload_mode = mode;
+}
+
+upload_mode_t get_upload_mode(void)
+{
+  return upload_mode;
+}
+
 static void finalize_vertex_array_object(GC_PTR obj, GC_PTR env)
 {
   vertex_array_object_t *target = (vertex_array_object_t *)obj;
+  if (target->buffer_bytes)
+    account_release(MEMORY_GL_BUFFER, target->buffer_bytes);
+  queue_deletion(DELETE_BUFFER, target->element_buffer_object);
+  queue_deletion(DELETE_BUFFER, target->vertex_buffer_object);
+  queue_deletion(DELETE_VERTEX_ARRAY, target->vertex_array_object);
+}
+
+static void delete_vertex_array_object(vertex_array_object_t *target)
+{
   glBindVertexArray(target->vertex_array_object);
   int i;
   for (i=0; i<target->texture->size; i++) {
     glActiveTexture(GL_TEXTURE0 + i);
     glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
   };
-  glBindVertexArray(target->vertex_array_object);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   glDeleteBuffers(1, &target->element_buffer_object);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glDeleteBuffers(1, &target->vertex_buffer_object);
   glBindVertexArray(0);
-  glDeleteBuffers(1, &target->vertex_array_object);
+  glDeleteVertexArrays(1, &target->vertex_array_object);
+  if (target->buffer_bytes)
+    account_release(MEMORY_GL_BUFFER, target->buffer_bytes);
 }
 
 void setup_vertex_attribute_pointers(vertex_array_object_t *vertex_array_object, int stride)
 {
-  setup_vertex_attribute_pointer(vertex_array_object, "point", 3, stride);
-  if (stride == 5 || stride == 8)
-    setup_vertex_attribute_pointer(vertex_array_object, "texcoord", 2, stride);
-  if (stride == 6 || stride == 8)
-    setup_vertex_attribute_pointer(vertex_array_object, "vector", 3, stride);
+  if (vertex_array_object->vertex_format == VERTEX_FORMAT_FLOAT) {
+    setup_vertex_attribute_pointer(vertex_array_object, "point", 3, stride);
+    if (stride == 5 || stride == 8)
+      setup_vertex_attribute_pointer(vertex_array_object, "texcoord", 2, stride);
+    if (stride == 6 || stride == 8)
+      setup_vertex_attribute_pointer(vertex_array_object, "vector", 3, stride);
+  } else {
+    int size = vertex_format_size(VERTEX_FORMAT_COMPACT, stride);
+    setup_vertex_attribute_format(vertex_array_object, "point", 3, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(GLushort),
+                                  size);
+    if (stride == 5 || stride == 8)
+      setup_vertex_attribute_format(vertex_array_object, "texcoord", 2, GL_HALF_FLOAT, GL_FALSE, 2 * sizeof(GLushort),
+                                    size);
+    if (stride == 6 || stride == 8)
+      setup_vertex_attribute_format(vertex_array_object, "vector", 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(GLuint),
+                                    size);
+  };
 }
 
-vertex_array_object_t *make_vertex_array_object(program_t *program, group_t *group)
+// Upload the vertices of an array in the given vertex format and return the size of the buffer. Positions are
+// stored relative to the bounding box of the array in the compact format.
+static int64_t upload_vertices(list_t *array, int stride, vertex_format_t format, GLfloat *offset, GLfloat *scale)
+{
+  int k;
+  for (k=0; k<3; k++) {
+    offset[k] = 0;
+    scale[k] = 1;
+  };
+  if (format == VERTEX_FORMAT_FLOAT) {
+    glBufferData(GL_ARRAY_BUFFER, array->size * sizeof(GLfloat), array->element, GL_STATIC_DRAW);
+    return array->size * sizeof(GLfloat);
+  };
+  int64_t n_vertices = stride ? array->size / stride : 0;
+  int64_t bytes = n_vertices * vertex_format_size(format, stride);
+  vertex_format_bounds(get_glfloat(array), n_vertices, stride, offset, scale);
+  void *data = pack_vertices(get_glfloat(array), n_vertices, stride, offset, scale);
+  glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
+  GC_FREE(data);
+  return bytes;
+}
+
+static void finalize_shared_buffers(GC_PTR obj, GC_PTR env)
+{
+  shared_buffers_t *target = (shared_buffers_t *)obj;
+  account_release(MEMORY_GL_BUFFER, target->bytes);
+  queue_deletion(DELETE_BUFFER, target->element_buffer_object);
+  queue_deletion(DELETE_BUFFER, target->vertex_buffer_object);
+}
+
+static void release_shared_buffers(shared_buffers_t *shared)
+{
+  if (--shared->references)
+    return;
+  GC_register_finalizer(shared, 0, 0, 0, 0);
+  glDeleteBuffers(1, &shared->element_buffer_object);
+  glDeleteBuffers(1, &shared->vertex_buffer_object);
+  account_release(MEMORY_GL_BUFFER, shared->bytes);
+  GC_FREE(shared);
+}
+
+GLenum smallest_index_type(int64_t n_vertices)
+{
+  if (n_vertices <= 256)
+    return GL_UNSIGNED_BYTE;
+  if (n_vertices <= 65536)
+    return GL_UNSIGNED_SHORT;
+  return GL_UNSIGNED_INT;
+}
+
+int index_type_size(GLenum index_type)
+{
+  switch (index_type) {
+  case GL_UNSIGNED_BYTE:
+    return sizeof(GLubyte);
+  case GL_UNSIGNED_SHORT:
+    return sizeof(GLushort);
+  default:
+    return sizeof(GLuint);
+  };
+}
+
+// Convert the indices of a group to the index type. The caller releases the result with GC_FREE unless it is the index
+// list of the group itself.
+static void *pack_indices(group_t *group, GLenum index_type)
+{
+  GLuint *index = get_gluint(group->vertex_index);
+  int64_t n = group->vertex_index->size;
+  if (index_type == GL_UNSIGNED_INT)
+    return index;
+  void *result = GC_MALLOC_ATOMIC(n * index_type_size(index_type));
+  int64_t i;
+  if (index_type == GL_UNSIGNED_BYTE)
+    for (i=0; i<n; i++)
+      ((GLubyte *)result)[i] = index[i];
+  else
+    for (i=0; i<n; i++)
+      ((GLushort *)result)[i] = index[i];
+  return result;
+}
+
+static void upload_indices(GLintptr offset, group_t *group, GLenum index_type)
+{
+  void *data = pack_indices(group, index_type);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, group->vertex_index->size * index_type_size(index_type), data);
+  if (data != group->vertex_index->element)
+    GC_FREE(data);
+}
+
+// Upload the vertices of a pool and the indices of all groups using it. The caller holds the first reference.
+static shared_buffers_t *make_shared_buffers(vertex_pool_t *pool, list_t *group)
+{
+  shared_buffers_t *retval = GC_MALLOC_ATOMIC(sizeof(shared_buffers_t));
+  GC_register_finalizer(retval, finalize_shared_buffers, 0, 0, 0);
+  retval->references = 1;
+  // Binding the element buffer would otherwise replace the one of the vertex array object bound last.
+  glBindVertexArray(0);
+  glGenBuffers(1, &retval->vertex_buffer_object);
+  glBindBuffer(GL_ARRAY_BUFFER, retval->vertex_buffer_object);
+  retval->vertex_format = get_vertex_format();
+  int64_t vertex_bytes = upload_vertices(pool->array, pool->stride, retval->vertex_format, retval->point_offset,
+                                         retval->point_scale);
+  retval->index_type = smallest_index_type(pool->array->size / pool->stride);
+  int index_size = index_type_size(retval->index_type);
+  GLsizeiptr size = 0;
+  int i;
+  for (i=0; i<group->size; i++)
+    size += ((group_t *)get_pointer(group)[i])->vertex_index->size * index_size;
+  glGenBuffers(1, &retval->element_buffer_object);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, retval->element_buffer_object);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+  GLintptr offset = 0;
+  for (i=0; i<group->size; i++) {
+    group_t *current = get_pointer(group)[i];
+    upload_indices(offset, current, retval->index_type);
+    offset += current->vertex_index->size * index_size;
+  };
+  retval->bytes = vertex_bytes + size;
+  account_allocation(MEMORY_GL_BUFFER, retval->bytes);
+  return retval;
+}
+
+static vertex_array_object_t *allocate_vertex_array_object(program_t *program, group_t *group)
 {
   vertex_array_object_t *retval = GC_MALLOC(sizeof(vertex_array_object_t));
   GC_register_finalizer(retval, finalize_vertex_array_object, 0, 0, 0);
   retval->n_indices = group->vertex_index->size;
+  retval->index_type = GL_UNSIGNED_INT;
+  retval->vertex_format = VERTEX_FORMAT_FLOAT;
+  int k;
+  for (k=0; k<3; k++) {
+    retval->point_offset[k] = 0;
+    retval->point_scale[k] = 1;
+  };
   retval->program = program;
   retval->n_attributes = 0;
   retval->attribute_pointer = 0;
+  retval->vertex_buffer_object = 0;
+  retval->element_buffer_object = 0;
+  retval->buffer_bytes = 0;
+  retval->shared = NULL;
+  retval->index_offset = 0;
   retval->texture = make_list();
   glGenVertexArrays(1, &retval->vertex_array_object);
   glBindVertexArray(retval->vertex_array_object);
+  return retval;
+}
+
+static void setup_group(vertex_array_object_t *vertex_array_object, group_t *group)
+{
+  setup_vertex_attribute_pointers(vertex_array_object, group->stride);
+  vertex_array_object->material = group->material;
+  if (group->material) {
+    if (group->material->diffuse_texture) add_texture(vertex_array_object, group->material->diffuse_texture);
+    if (group->material->specular_texture) add_texture(vertex_array_object, group->material->specular_texture);
+  };
+}
+
+static vertex_array_object_t *make_shared_vertex_array_object(program_t *program, group_t *group,
+                                                              shared_buffers_t *shared, GLintptr index_offset)
+{
+  vertex_array_object_t *retval = allocate_vertex_array_object(program, group);
+  retval->shared = shared;
+  shared->references++;
+  retval->index_offset = index_offset;
+  retval->index_type = shared->index_type;
+  retval->vertex_format = shared->vertex_format;
+  memcpy(retval->point_offset, shared->point_offset, sizeof(retval->point_offset));
+  memcpy(retval->point_scale, shared->point_scale, sizeof(retval->point_scale));
+  glBindBuffer(GL_ARRAY_BUFFER, shared->vertex_buffer_object);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shared->element_buffer_object);
+  setup_group(retval, group);
+  return retval;
+}
+
+// The vertex pool of the group is left alone (see compact_group).
+static void apply_upload_mode(group_t *group)
+{
+  if (upload_mode == UPLOAD_COMPACT)
+    compact_group(group);
+  else if (upload_mode == UPLOAD_RELEASE)
+    release_group_data(group);
+}
+
+vertex_array_object_t *make_vertex_array_object(program_t *program, group_t *group)
+{
+  if (group->pool) {
+    list_t *single = make_list();
+    append_pointer(single, group);
+    shared_buffers_t *shared = make_shared_buffers(group->pool, single);
+    destroy_list(single);
+    vertex_array_object_t *retval = make_shared_vertex_array_object(program, group, shared, 0);
+    release_shared_buffers(shared);
+    apply_upload_mode(group);
+    return retval;
+  };
+  vertex_array_object_t *retval = allocate_vertex_array_object(program, group);
   glGenBuffers(1, &retval->vertex_buffer_object);
   glBindBuffer(GL_ARRAY_BUFFER, retval->vertex_buffer_object);
-  glBufferData(GL_ARRAY_BUFFER, size_of_array(group), group->array->element, GL_STATIC_DRAW);
+  retval->vertex_format = get_vertex_format();
+  int64_t vertex_bytes = upload_vertices(group->array, group->stride, retval->vertex_format, retval->point_offset,
+                                         retval->point_scale);
+  retval->index_type = smallest_index_type(group->stride ? group->array->size / group->stride : 0);
+  int64_t index_bytes = group->vertex_index->size * index_type_size(retval->index_type);
   glGenBuffers(1, &retval->element_buffer_object);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, retval->element_buffer_object);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_of_indices(group), group->vertex_index->element, GL_STATIC_DRAW);
-  setup_vertex_attribute_pointers(retval, group->stride);
-  retval->material = group->material;
-  if (group->material) {
-    if (group->material->diffuse_texture) add_texture(retval, group->material->diffuse_texture);
-    if (group->material->specular_texture) add_texture(retval, group->material->specular_texture);
-  };
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, NULL, GL_STATIC_DRAW);
+  upload_indices(0, group, retval->index_type);
+  retval->buffer_bytes = vertex_bytes + index_bytes;
+  account_allocation(MEMORY_GL_BUFFER, retval->buffer_bytes);
+  setup_group(retval, group);
+  apply_upload_mode(group);
   return retval;
 }
 
+static list_t *groups_using_pool(object_t *object, vertex_pool_t *pool)
+{
+  list_t *result = make_list();
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (group->pool == pool)
+      append_pointer(result, group);
+  };
+  return result;
+}
+
 list_t *make_vertex_array_object_list(program_t *program, object_t *object)
 {
   list_t *result = make_list();
+  list_t *shared = make_list();
+  GLintptr *offset = GC_MALLOC_ATOMIC(object->pool->size * sizeof(GLintptr));
   int i;
-  for (i=0; i<object->group->size; i++)
-    append_pointer(result, make_vertex_array_object(program, get_pointer(object->group)[i]));
+  for (i=0; i<object->pool->size; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    list_t *groups = groups_using_pool(object, pool);
+    append_pointer(shared, make_shared_buffers(pool, groups));
+    destroy_list(groups);
+    offset[i] = 0;
+  };
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    int j = 0;
+    while (j < object->pool->size && get_pointer(object->pool)[j] != group->pool)
+      j++;
+    if (group->pool && j < object->pool->size) {
+      shared_buffers_t *buffers = get_pointer(shared)[j];
+      append_pointer(result, make_shared_vertex_array_object(program, group, buffers, offset[j]));
+      offset[j] += group->vertex_index->size * index_type_size(buffers->index_type);
+    } else
+      append_pointer(result, make_vertex_array_object(program, group));
+  };
+  for (i=0; i<shared->size; i++)
+    release_shared_buffers(get_pointer(shared)[i]);
+  destroy_list(shared);
+  GC_FREE(offset);
+  if (upload_mode == UPLOAD_COMPACT)
+    compact_object(object);
+  else if (upload_mode == UPLOAD_RELEASE)
+    release_object_data(object);
   return result;
 }
 
+void destroy_vertex_array_object(vertex_array_object_t *vertex_array_object)
+{
+  GC_register_finalizer(vertex_array_object, 0, 0, 0, 0);
+  delete_vertex_array_object(vertex_array_object);
+  if (vertex_array_object->shared)
+    release_shared_buffers(vertex_array_object->shared);
+  destroy_list(vertex_array_object->texture);
+  GC_FREE(vertex_array_object);
+}
+
+void destroy_vertex_array_object_list(list_t *list)
+{
+  int i;
+  for (i=0; i<list->size; i++)
+    destroy_vertex_array_object(get_pointer(list)[i]);
+  destroy_list(list);
+}
+
 void setup_vertex_attribute_pointer(vertex_array_object_t *vertex_array_object, const char *attribute, int size, int stride)
+{
+  setup_vertex_attribute_format(vertex_array_object, attribute, size, GL_FLOAT, GL_FALSE, sizeof(float) * size,
+                                stride * sizeof(float));
+}
+
+void setup_vertex_attribute_format(vertex_array_object_t *vertex_array_object, const char *attribute, int size,
+                                   GLenum type, GLboolean normalized, int attribute_bytes, int vertex_bytes)
 {
   glBindVertexArray(vertex_array_object->vertex_array_object);
   program_t *program = vertex_array_object->program;
   GLuint index = glGetAttribLocation(program->program, attribute);
-  glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void *)vertex_array_object->attribute_pointer);
+  glVertexAttribPointer(index, size, type, normalized, vertex_bytes, (void *)vertex_array_object->attribute_pointer);
   glEnableVertexAttribArray(vertex_array_object->n_attributes);
   vertex_array_object->n_attributes += 1;
-  vertex_array_object->attribute_pointer += sizeof(float) * size;
+  vertex_array_object->attribute_pointer += attribute_bytes;
 }
 
 void add_texture(vertex_array_object_t *vertex_array_object, texture_t *texture)
@@ -104,7 +393,10 @@ void draw_elements(vertex_array_object_t *vertex_array_object)
     glUniform3fv(glGetUniformLocation(program->program, "specular"), 1, &material->specular[0]);
     glUniform1f(glGetUniformLocation(program->program, "specular_exponent"), material->specular_exponent);
   };
-  glDrawElements(GL_TRIANGLES, vertex_array_object->n_indices, GL_UNSIGNED_INT, (void *)0);
+  glUniform3fv(glGetUniformLocation(program->program, "point_offset"), 1, vertex_array_object->point_offset);
+  glUniform3fv(glGetUniformLocation(program->program, "point_scale"), 1, vertex_array_object->point_scale);
+  glDrawElements(GL_TRIANGLES, vertex_array_object->n_indices, vertex_array_object->index_type,
+                 (void *)vertex_array_object->index_offset);
 }
 
 void render(list_t *vertex_array_object)
@@ -7,8 +7,22 @@
 #include "material.h"
 #include "image.h"
 #include "list.h"
+#include "vertex_format.h"
 
 
+// Vertex and element buffer shared by the vertex array objects of the groups using the same vertex pool. The buffers
+// are deleted when the last reference is released.
+typedef struct {
+  GLuint vertex_buffer_object;
+  GLuint element_buffer_object;
+  GLenum index_type;
+  vertex_format_t vertex_format;
+  GLfloat point_offset[3];
+  GLfloat point_scale[3];
+  int references;
+  int64_t bytes;
+} shared_buffers_t;
+
 typedef struct {
   program_t *program;
   int n_attributes;
@@ -16,16 +30,58 @@ typedef struct {
   GLuint vertex_array_object;
   GLuint vertex_buffer_object;
   GLuint element_buffer_object;
+  int64_t buffer_bytes;
+  shared_buffers_t *shared;
+  GLintptr index_offset;
   int n_indices;
+  GLenum index_type;
+  vertex_format_t vertex_format;
+  GLfloat point_offset[3];
+  GLfloat point_scale[3];
   material_t *material;
   list_t *texture;
 } vertex_array_object_t;
 
+// What happens to the vertex data of a group once it has been uploaded. UPLOAD_COMPACT keeps the vertex positions and
+// the indices for picking and UPLOAD_RELEASE only keeps the bounding boxes (see compact_group and release_group_data).
+// The textures never keep a copy of the image data.
+typedef enum {UPLOAD_KEEP, UPLOAD_COMPACT, UPLOAD_RELEASE} upload_mode_t;
+
+void set_upload_mode(upload_mode_t mode);
+
+upload_mode_t get_upload_mode(void);
+
+// The vertex buffers use the vertex format selected with set_vertex_format at the time of the upload. Shaders
+// receive the uniforms point_offset and point_scale to decode the positions (see vertex_format.h).
+//
+// Element buffers use the smallest index type which can address all vertices of the group or of the vertex pool:
+// GL_UNSIGNED_BYTE for up to 256 vertices, GL_UNSIGNED_SHORT for up to 65536 vertices and GL_UNSIGNED_INT otherwise.
+GLenum smallest_index_type(int64_t n_vertices);
+
+int index_type_size(GLenum index_type);
+
+// A group using a vertex pool gets a buffer with the complete pool. Use make_vertex_array_object_list to share the
+// buffers between the groups of an object. The vertex array object owns its buffers but not the program, the material
+// or the textures. The upload mode is applied to the group. It is not applied to the vertex pool here because other
+// groups may still need it. A pooled group therefore only releases its indices (UPLOAD_RELEASE).
 vertex_array_object_t *make_vertex_array_object(program_t *program, group_t *group);
 
+// Groups using the same vertex pool share one vertex buffer and one element buffer. Each vertex array object draws
+// its range of the element buffer. The upload mode is applied to all groups and vertex pools of the object.
 list_t *make_vertex_array_object_list(program_t *program, object_t *object);
 
-void setup_vertex_attribute_pointer(vertex_array_object_t *vertex_array_object, const char *attribute, int size, int stride);
+// Delete the vertex array object and its buffers. This requires the OpenGL context to be current.
+void destroy_vertex_array_object(vertex_array_object_t *vertex_array_object);
+
+// Destroy all vertex array objects of a list and the list itself.
+void destroy_vertex_array_object_list(list_t *list);
+
+void setup_vertex_attribute_pointer(vertex_array_object_t *vertex_array_object, const char *attribute, int size,
+                                    int stride);
+
+// Set up an attribute of the given component type. The attribute takes the given number of bytes of each vertex.
+void setup_vertex_attribute_format(vertex_array_object_t *vertex_array_object, const char *attribute, int size,
+                                   GLenum type, GLboolean normalized, int attribute_bytes, int vertex_bytes);
 
 void add_texture(vertex_array_object_t *vertex_array_object, texture_t *texture);
 
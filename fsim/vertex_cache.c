@@ -0,0 +1,241 @@
+#include <string.h>
+#include "memory.h"
+#include "vertex_cache.h"
+
+
+static int vertex_cache_optimization = 0;
+
+void set_vertex_cache_optimization(int enabled)
+{
+  vertex_cache_optimization = enabled;
+}
+
+int get_vertex_cache_optimization(void)
+{
+  return vertex_cache_optimization;
+}
+
+// The vertex indices of a group are mapped to the range from the smallest to the largest index so that groups of
+// a large vertex pool do not need tables for the whole pool.
+static void index_range(const GLuint *index, int64_t n_indices, GLuint *first, int64_t *n_vertices)
+{
+  GLuint lowest = n_indices ? index[0] : 0;
+  GLuint highest = lowest;
+  int64_t i;
+  for (i=1; i<n_indices; i++) {
+    if (index[i] < lowest) lowest = index[i];
+    if (index[i] > highest) highest = index[i];
+  };
+  *first = lowest;
+  *n_vertices = n_indices ? (int64_t)highest - lowest + 1 : 0;
+}
+
+// Count the transformed vertices using a FIFO cache. A vertex is in the cache if less than cache_size vertices were
+// transformed since it was transformed itself.
+static int64_t count_transforms(const GLuint *index, int64_t n_indices, GLuint first, int64_t *stamp, int cache_size)
+{
+  int64_t result = 0;
+  int64_t i;
+  for (i=0; i<n_indices; i++) {
+    int64_t *vertex_stamp = &stamp[index[i] - first];
+    if (*vertex_stamp < 0 || result - *vertex_stamp >= cache_size) {
+      *vertex_stamp = result;
+      result++;
+    };
+  };
+  return result;
+}
+
+vertex_cache_statistics_t vertex_cache_statistics(const GLuint *index, int64_t n_indices, int cache_size)
+{
+  vertex_cache_statistics_t result = {0, 0};
+  GLuint first;
+  int64_t n_vertices;
+  index_range(index, n_indices, &first, &n_vertices);
+  if (n_indices < 3)
+    return result;
+  int64_t *stamp = GC_MALLOC_ATOMIC(n_vertices * sizeof(int64_t));
+  memset(stamp, 0xff, n_vertices * sizeof(int64_t));
+  int64_t distinct = 0;
+  int64_t i;
+  for (i=0; i<n_indices; i++)
+    if (stamp[index[i] - first] < 0) {
+      stamp[index[i] - first] = 0;
+      distinct++;
+    };
+  memset(stamp, 0xff, n_vertices * sizeof(int64_t));
+  int64_t transforms = count_transforms(index, n_indices, first, stamp, cache_size);
+  GC_FREE(stamp);
+  result.acmr = (double)transforms / (n_indices / 3);
+  result.atvr = (double)transforms / distinct;
+  return result;
+}
+
+typedef struct {
+  int64_t *offset;      // triangles of vertex v are triangle[offset[v]] to triangle[offset[v + 1] - 1]
+  int64_t *triangle;
+  int *live;            // number of triangles of the vertex which were not emitted yet
+  int64_t *time;        // time stamp of the vertex in the simulated cache
+  char *emitted;
+  int64_t *dead_end;    // stack of recently used vertices
+  int64_t n_dead_end;
+  int64_t n_vertices;
+  int64_t cursor;       // vertices before the cursor have no live triangles
+} tipsify_t;
+
+static void build_adjacency(tipsify_t *state, const GLuint *index, int64_t n_indices, GLuint first)
+{
+  int64_t n_triangles = n_indices / 3;
+  int64_t v;
+  int64_t i;
+  for (i=0; i<n_triangles * 3; i++)
+    state->live[index[i] - first]++;
+  state->offset[0] = 0;
+  for (v=0; v<state->n_vertices; v++)
+    state->offset[v + 1] = state->offset[v] + state->live[v];
+  int64_t *fill = GC_MALLOC_ATOMIC(state->n_vertices * sizeof(int64_t));
+  memcpy(fill, state->offset, state->n_vertices * sizeof(int64_t));
+  for (i=0; i<n_triangles * 3; i++)
+    state->triangle[fill[index[i] - first]++] = i / 3;
+  GC_FREE(fill);
+}
+
+static int64_t skip_dead_end(tipsify_t *state)
+{
+  while (state->n_dead_end) {
+    int64_t v = state->dead_end[--state->n_dead_end];
+    if (state->live[v] > 0)
+      return v;
+  };
+  while (state->cursor < state->n_vertices) {
+    if (state->live[state->cursor] > 0)
+      return state->cursor;
+    state->cursor++;
+  };
+  return -1;
+}
+
+// Prefer the candidate which stays in the cache the longest when its remaining triangles are emitted.
+static int64_t next_vertex(tipsify_t *state, const int64_t *candidate, int n_candidates, int64_t time, int cache_size)
+{
+  int64_t result = -1;
+  int64_t best = -1;
+  int i;
+  for (i=0; i<n_candidates; i++) {
+    int64_t v = candidate[i];
+    if (state->live[v] > 0) {
+      int64_t priority = 0;
+      if (time - state->time[v] + 2 * state->live[v] <= cache_size)
+        priority = time - state->time[v];
+      if (priority > best) {
+        best = priority;
+        result = v;
+      };
+    };
+  };
+  return result >= 0 ? result : skip_dead_end(state);
+}
+
+void optimize_vertex_cache(GLuint *index, int64_t n_indices, int cache_size)
+{
+  int64_t n_triangles = n_indices / 3;
+  if (n_triangles < 2)
+    return;
+  tipsify_t state;
+  GLuint first;
+  index_range(index, n_triangles * 3, &first, &state.n_vertices);
+  state.offset = GC_MALLOC_ATOMIC((state.n_vertices + 1) * sizeof(int64_t));
+  state.triangle = GC_MALLOC_ATOMIC(n_triangles * 3 * sizeof(int64_t));
+  state.live = GC_MALLOC_ATOMIC(state.n_vertices * sizeof(int));
+  state.time = GC_MALLOC_ATOMIC(state.n_vertices * sizeof(int64_t));
+  state.emitted = GC_MALLOC_ATOMIC(n_triangles);
+  state.dead_end = GC_MALLOC_ATOMIC(n_triangles * 3 * sizeof(int64_t));
+  memset(state.live, 0, state.n_vertices * sizeof(int));
+  memset(state.emitted, 0, n_triangles);
+  int64_t v;
+  for (v=0; v<state.n_vertices; v++)
+    state.time[v] = -(int64_t)cache_size - 1;
+  state.n_dead_end = 0;
+  state.cursor = 0;
+  build_adjacency(&state, index, n_indices, first);
+  GLuint *result = GC_MALLOC_ATOMIC(n_triangles * 3 * sizeof(GLuint));
+  int64_t n_result = 0;
+  int64_t *candidate = GC_MALLOC_ATOMIC(64 * sizeof(int64_t));
+  int max_candidates = 64;
+  int64_t time = 0;
+  int64_t fan = skip_dead_end(&state);
+  while (fan >= 0) {
+    int n_candidates = 0;
+    int64_t i;
+    for (i=state.offset[fan]; i<state.offset[fan + 1]; i++) {
+      int64_t t = state.triangle[i];
+      if (state.emitted[t])
+        continue;
+      state.emitted[t] = 1;
+      int j;
+      for (j=0; j<3; j++) {
+        GLuint vertex = index[3 * t + j];
+        int64_t w = vertex - first;
+        result[n_result++] = vertex;
+        state.dead_end[state.n_dead_end++] = w;
+        if (n_candidates == max_candidates) {
+          max_candidates *= 2;
+          candidate = GC_REALLOC(candidate, max_candidates * sizeof(int64_t));
+        };
+        candidate[n_candidates++] = w;
+        state.live[w]--;
+        if (time - state.time[w] > cache_size) {
+          state.time[w] = time;
+          time++;
+        };
+      };
+    };
+    fan = next_vertex(&state, candidate, n_candidates, time, cache_size);
+  };
+  memcpy(index, result, n_triangles * 3 * sizeof(GLuint));
+  GC_FREE(candidate);
+  GC_FREE(result);
+  GC_FREE(state.dead_end);
+  GC_FREE(state.emitted);
+  GC_FREE(state.time);
+  GC_FREE(state.live);
+  GC_FREE(state.triangle);
+  GC_FREE(state.offset);
+}
+
+void optimize_group_vertex_cache(group_t *group)
+{
+  optimize_vertex_cache(get_gluint(group->vertex_index), group->vertex_index->size, VERTEX_CACHE_SIZE);
+}
+
+void optimize_object_vertex_cache(object_t *object)
+{
+  int i;
+  for (i=0; i<object->group->size; i++)
+    optimize_group_vertex_cache(get_pointer(object->group)[i]);
+}
+
+vertex_cache_statistics_t object_vertex_cache_statistics(object_t *object, int cache_size)
+{
+  vertex_cache_statistics_t result = {0, 0};
+  double triangles = 0;
+  double vertices = 0;
+  double transforms = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    int64_t n_indices = group->vertex_index->size;
+    vertex_cache_statistics_t statistics = vertex_cache_statistics(get_gluint(group->vertex_index), n_indices,
+                                                                   cache_size);
+    if (statistics.atvr > 0) {
+      triangles += n_indices / 3;
+      transforms += statistics.acmr * (n_indices / 3);
+      vertices += statistics.acmr * (n_indices / 3) / statistics.atvr;
+    };
+  };
+  if (triangles > 0) {
+    result.acmr = transforms / triangles;
+    result.atvr = transforms / vertices;
+  };
+  return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <GL/gl.h>
+#include "group.h"
+#include "object.h"
+
+
+// Reordering the triangles of a group so that vertices are reused while they are still in the post-transform cache
+// of the GPU reduces the number of vertex shader invocations. The triangles are reordered with the Tipsify algorithm
+// (Sander, Nehab and Barczak: Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007) which
+// runs in linear time. The vertices of each triangle keep their order so that the winding does not change.
+#define VERTEX_CACHE_SIZE 16
+
+// Optimize the groups completed by the parser and the groups read from object caches written without optimization.
+void set_vertex_cache_optimization(int enabled);
+
+int get_vertex_cache_optimization(void);
+
+// Average cache miss ratio (transformed vertices per triangle, at best about 0.5) and average transform to vertex
+// ratio (transformed vertices per distinct vertex, at best 1) of a FIFO cache with the given number of entries.
+typedef struct {
+  double acmr;
+  double atvr;
+} vertex_cache_statistics_t;
+
+vertex_cache_statistics_t vertex_cache_statistics(const GLuint *index, int64_t n_indices, int cache_size);
+
+void optimize_vertex_cache(GLuint *index, int64_t n_indices, int cache_size);
+
+void optimize_group_vertex_cache(group_t *group);
+
+void optimize_object_vertex_cache(object_t *object);
+
+// Statistics of all groups of an object.
+vertex_cache_statistics_t object_vertex_cache_statistics(object_t *object, int cache_size);
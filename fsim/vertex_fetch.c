@@ -0,0 +1,165 @@
+#include <string.h>
+#include "memory.h"
+#include "vertex_cache.h"
+#include "vertex_fetch.h"
+
+
+static int vertex_fetch_optimization = 0;
+
+void set_vertex_fetch_optimization(int enabled)
+{
+  vertex_fetch_optimization = enabled;
+}
+
+int get_vertex_fetch_optimization(void)
+{
+  return vertex_fetch_optimization;
+}
+
+// Bytes loaded and bytes of distinct vertices referenced by the indices.
+static void count_fetches(const GLuint *index, int64_t n_indices, int stride, int64_t *fetched, int64_t *referenced)
+{
+  *fetched = 0;
+  *referenced = 0;
+  if (n_indices < 3)
+    return;
+  GLuint first = index[0];
+  GLuint last = index[0];
+  int64_t i;
+  for (i=1; i<n_indices; i++) {
+    if (index[i] < first) first = index[i];
+    if (index[i] > last) last = index[i];
+  };
+  int64_t vertex_size = stride * sizeof(GLfloat);
+  int64_t n_vertices = (int64_t)last - first + 1;
+  int64_t first_line = first * vertex_size / VERTEX_FETCH_LINE_SIZE;
+  int64_t n_lines = ((int64_t)last + 1) * vertex_size / VERTEX_FETCH_LINE_SIZE - first_line + 1;
+  int64_t *vertex_stamp = GC_MALLOC_ATOMIC(n_vertices * sizeof(int64_t));
+  int64_t *line_stamp = GC_MALLOC_ATOMIC(n_lines * sizeof(int64_t));
+  char *seen = GC_MALLOC_ATOMIC(n_vertices);
+  memset(vertex_stamp, 0xff, n_vertices * sizeof(int64_t));
+  memset(line_stamp, 0xff, n_lines * sizeof(int64_t));
+  memset(seen, 0, n_vertices);
+  int64_t transforms = 0;
+  int64_t loads = 0;
+  for (i=0; i<n_indices; i++) {
+    int64_t v = index[i] - first;
+    if (!seen[v]) {
+      seen[v] = 1;
+      *referenced += vertex_size;
+    };
+    if (vertex_stamp[v] >= 0 && transforms - vertex_stamp[v] < VERTEX_CACHE_SIZE)
+      continue;
+    vertex_stamp[v] = transforms++;
+    int64_t line;
+    for (line=(int64_t)index[i] * vertex_size / VERTEX_FETCH_LINE_SIZE;
+         line<=((int64_t)index[i] * vertex_size + vertex_size - 1) / VERTEX_FETCH_LINE_SIZE; line++) {
+      int64_t *stamp = &line_stamp[line - first_line];
+      if (*stamp < 0 || loads - *stamp >= VERTEX_FETCH_LINES)
+        *stamp = loads++;
+    };
+  };
+  *fetched = loads * VERTEX_FETCH_LINE_SIZE;
+  GC_FREE(seen);
+  GC_FREE(line_stamp);
+  GC_FREE(vertex_stamp);
+}
+
+double vertex_fetch_overhead(const GLuint *index, int64_t n_indices, int stride)
+{
+  int64_t fetched;
+  int64_t referenced;
+  count_fetches(index, n_indices, stride, &fetched, &referenced);
+  return referenced ? (double)fetched / referenced : 0.0;
+}
+
+// Assign new numbers in first-use order. The remapping table must be initialised with -1.
+static void renumber(GLuint *index, int64_t n_indices, int64_t *remap, int64_t *n_used)
+{
+  int64_t i;
+  for (i=0; i<n_indices; i++) {
+    if (remap[index[i]] < 0)
+      remap[index[i]] = (*n_used)++;
+    index[i] = remap[index[i]];
+  };
+}
+
+static void permute_vertices(GLfloat *array, int64_t n_vertices, int stride, const int64_t *remap, int64_t n_used)
+{
+  GLfloat *result = GC_MALLOC_ATOMIC(n_used * stride * sizeof(GLfloat));
+  int64_t v;
+  for (v=0; v<n_vertices; v++)
+    if (remap[v] >= 0)
+      memcpy(result + remap[v] * stride, array + v * stride, stride * sizeof(GLfloat));
+  memcpy(array, result, n_used * stride * sizeof(GLfloat));
+  GC_FREE(result);
+}
+
+static int64_t *make_remap(int64_t n_vertices)
+{
+  int64_t *result = GC_MALLOC_ATOMIC(n_vertices * sizeof(int64_t));
+  memset(result, 0xff, n_vertices * sizeof(int64_t));
+  return result;
+}
+
+int64_t optimize_vertex_fetch(GLuint *index, int64_t n_indices, GLfloat *array, int64_t n_vertices, int stride)
+{
+  int64_t *remap = make_remap(n_vertices);
+  int64_t result = 0;
+  renumber(index, n_indices, remap, &result);
+  permute_vertices(array, n_vertices, stride, remap, result);
+  GC_FREE(remap);
+  return result;
+}
+
+void optimize_group_vertex_fetch(group_t *group)
+{
+  if (group->pool || !group->stride)
+    return;
+  int64_t n_vertices = optimize_vertex_fetch(get_gluint(group->vertex_index), group->vertex_index->size,
+                                             get_glfloat(group->array), group->array->size / group->stride,
+                                             group->stride);
+  group->array->size = n_vertices * group->stride;
+}
+
+void optimize_pool_vertex_fetch(object_t *object, vertex_pool_t *pool)
+{
+  int64_t n_vertices = pool->array->size / pool->stride;
+  int64_t *remap = make_remap(n_vertices);
+  int64_t n_used = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    if (group->pool == pool)
+      renumber(get_gluint(group->vertex_index), group->vertex_index->size, remap, &n_used);
+  };
+  permute_vertices(get_glfloat(pool->array), n_vertices, pool->stride, remap, n_used);
+  pool->array->size = n_used * pool->stride;
+  GC_FREE(remap);
+}
+
+void optimize_object_vertex_fetch(object_t *object)
+{
+  int i;
+  for (i=0; i<object->group->size; i++)
+    optimize_group_vertex_fetch(get_pointer(object->group)[i]);
+  for (i=0; i<object->pool->size; i++)
+    optimize_pool_vertex_fetch(object, get_pointer(object->pool)[i]);
+}
+
+double object_vertex_fetch_overhead(object_t *object)
+{
+  int64_t fetched = 0;
+  int64_t referenced = 0;
+  int i;
+  for (i=0; i<object->group->size; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    int64_t group_fetched;
+    int64_t group_referenced;
+    count_fetches(get_gluint(group->vertex_index), group->vertex_index->size, group->stride, &group_fetched,
+                  &group_referenced);
+    fetched += group_fetched;
+    referenced += group_referenced;
+  };
+  return referenced ? (double)fetched / referenced : 0.0;
+}
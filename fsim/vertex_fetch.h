@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <GL/gl.h>
+#include "group.h"
+#include "object.h"
+
+
+// Renumbering the vertices in the order in which the index buffer first uses them makes the vertex fetches of the GPU
+// (and CPU traversals such as computing bounds) walk through memory mostly sequentially. Vertices which are not
+// referenced by any index are dropped. Run this after the vertex cache optimization because it depends on the order
+// of the indices.
+#define VERTEX_FETCH_LINE_SIZE 64
+#define VERTEX_FETCH_LINES 64
+
+// Optimize the groups completed by the parser and the vertex pools of parsed objects. Also applied to objects read
+// from caches written without this optimization.
+void set_vertex_fetch_optimization(int enabled);
+
+int get_vertex_fetch_optimization(void);
+
+// Ratio of the bytes loaded from memory to the size of the referenced vertices. Each vertex missing the post-transform
+// cache (a FIFO with VERTEX_CACHE_SIZE entries) is fetched through a FIFO cache of VERTEX_FETCH_LINES lines of
+// VERTEX_FETCH_LINE_SIZE bytes. The result is at least about 1 and 0 if there are no triangles.
+double vertex_fetch_overhead(const GLuint *index, int64_t n_indices, int stride);
+
+// Renumber the vertices of an interleaved array with the given number of floats per vertex in first-use order of the
+// indices. Returns the number of remaining vertices.
+int64_t optimize_vertex_fetch(GLuint *index, int64_t n_indices, GLfloat *array, int64_t n_vertices, int stride);
+
+// Groups using a vertex pool are skipped because the pool is renumbered for all its groups at once.
+void optimize_group_vertex_fetch(group_t *group);
+
+// Renumber the vertices of a pool in first-use order of the groups of the object using it.
+void optimize_pool_vertex_fetch(object_t *object, vertex_pool_t *pool);
+
+void optimize_object_vertex_fetch(object_t *object);
+
+// Overhead of all groups of an object weighted by the size of the referenced vertices.
+double object_vertex_fetch_overhead(object_t *object);
@@ -0,0 +1,226 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "memory.h"
+#include "vertex_format.h"
+
+
+static vertex_format_t vertex_format = VERTEX_FORMAT_FLOAT;
+
+void set_vertex_format(vertex_format_t format)
+{
+  vertex_format = format;
+}
+
+vertex_format_t get_vertex_format(void)
+{
+  return vertex_format;
+}
+
+static int has_texcoord(int stride)
+{
+  return stride == 5 || stride == 8;
+}
+
+static int has_normal(int stride)
+{
+  return stride == 6 || stride == 8;
+}
+
+int vertex_format_size(vertex_format_t format, int stride)
+{
+  if (format == VERTEX_FORMAT_FLOAT)
+    return stride * sizeof(GLfloat);
+  return 4 * sizeof(uint16_t) + (has_texcoord(stride) ? 2 * sizeof(uint16_t) : 0) +
+         (has_normal(stride) ? sizeof(uint32_t) : 0);
+}
+
+// Round to nearest even. Values too large for a half float become infinite.
+uint16_t float_to_half(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+  if (((bits >> 23) & 0xff) == 0xff)
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  if (exponent >= 31)
+    return sign | 0x7c00;
+  if (exponent <= 0) {
+    if (exponent < -10)
+      return sign;
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    uint32_t result = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (result & 1)))
+      result++;
+    return sign | result;
+  };
+  uint32_t result = sign | (exponent << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+  // A carry out of the mantissa correctly increments the exponent.
+  if (rest > 0x1000 || (rest == 0x1000 && (result & 1)))
+    result++;
+  return result;
+}
+
+float half_to_float(uint16_t value)
+{
+  float sign = value & 0x8000 ? -1.0f : 1.0f;
+  int exponent = (value >> 10) & 0x1f;
+  int mantissa = value & 0x3ff;
+  if (exponent == 0)
+    return sign * ldexpf(mantissa, -24);
+  if (exponent == 31)
+    return mantissa ? NAN : sign * INFINITY;
+  return sign * ldexpf(mantissa + 1024, exponent - 25);
+}
+
+static uint32_t pack_snorm10(float value)
+{
+  float clamped = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+  return (uint32_t)(int32_t)lrintf(clamped * 511.0f) & 0x3ff;
+}
+
+static float unpack_snorm10(uint32_t bits)
+{
+  int32_t value = (int32_t)(bits << 22) >> 22;
+  float result = value / 511.0f;
+  return result < -1.0f ? -1.0f : result;
+}
+
+uint32_t pack_normal(const GLfloat *normal)
+{
+  return pack_snorm10(normal[0]) | pack_snorm10(normal[1]) << 10 | pack_snorm10(normal[2]) << 20;
+}
+
+void unpack_normal(uint32_t value, GLfloat *normal)
+{
+  normal[0] = unpack_snorm10(value);
+  normal[1] = unpack_snorm10(value >> 10);
+  normal[2] = unpack_snorm10(value >> 20);
+}
+
+void vertex_format_bounds(const GLfloat *array, int64_t n_vertices, int stride, GLfloat *offset, GLfloat *scale)
+{
+  GLfloat upper[3];
+  int k;
+  for (k=0; k<3; k++) {
+    offset[k] = n_vertices ? FLT_MAX : 0;
+    upper[k] = n_vertices ? -FLT_MAX : 0;
+  };
+  int64_t i;
+  for (i=0; i<n_vertices; i++)
+    for (k=0; k<3; k++) {
+      GLfloat value = array[i * stride + k];
+      if (value < offset[k]) offset[k] = value;
+      if (value > upper[k]) upper[k] = value;
+    };
+  for (k=0; k<3; k++)
+    scale[k] = upper[k] - offset[k];
+}
+
+static uint16_t quantize(GLfloat value, GLfloat offset, GLfloat scale)
+{
+  if (scale <= 0)
+    return 0;
+  double unit = (value - offset) / scale;
+  return lrint((unit < 0 ? 0 : unit > 1 ? 1 : unit) * 65535);
+}
+
+void *pack_vertices(const GLfloat *array, int64_t n_vertices, int stride, const GLfloat *offset, const GLfloat *scale)
+{
+  int size = vertex_format_size(VERTEX_FORMAT_COMPACT, stride);
+  unsigned char *result = GC_MALLOC_ATOMIC(n_vertices * size);
+  int64_t i;
+  for (i=0; i<n_vertices; i++) {
+    const GLfloat *source = array + i * stride;
+    unsigned char *target = result + i * size;
+    uint16_t point[4] = {quantize(source[0], offset[0], scale[0]), quantize(source[1], offset[1], scale[1]),
+                         quantize(source[2], offset[2], scale[2]), 0};
+    memcpy(target, point, sizeof(point));
+    target += sizeof(point);
+    source += 3;
+    if (has_texcoord(stride)) {
+      uint16_t texcoord[2] = {float_to_half(source[0]), float_to_half(source[1])};
+      memcpy(target, texcoord, sizeof(texcoord));
+      target += sizeof(texcoord);
+      source += 2;
+    };
+    if (has_normal(stride)) {
+      uint32_t normal = pack_normal(source);
+      memcpy(target, &normal, sizeof(normal));
+    };
+  };
+  return result;
+}
+
+GLfloat *unpack_vertices(const void *data, int64_t n_vertices, int stride, const GLfloat *offset,
+                         const GLfloat *scale)
+{
+  int size = vertex_format_size(VERTEX_FORMAT_COMPACT, stride);
+  GLfloat *result = GC_MALLOC_ATOMIC(n_vertices * stride * sizeof(GLfloat));
+  int64_t i;
+  for (i=0; i<n_vertices; i++) {
+    const unsigned char *source = (const unsigned char *)data + i * size;
+    GLfloat *target = result + i * stride;
+    uint16_t point[4];
+    memcpy(point, source, sizeof(point));
+    int k;
+    for (k=0; k<3; k++)
+      target[k] = offset[k] + point[k] / 65535.0f * scale[k];
+    source += sizeof(point);
+    target += 3;
+    if (has_texcoord(stride)) {
+      uint16_t texcoord[2];
+      memcpy(texcoord, source, sizeof(texcoord));
+      target[0] = half_to_float(texcoord[0]);
+      target[1] = half_to_float(texcoord[1]);
+      source += sizeof(texcoord);
+      target += 2;
+    };
+    if (has_normal(stride)) {
+      uint32_t normal;
+      memcpy(&normal, source, sizeof(normal));
+      unpack_normal(normal, target);
+    };
+  };
+  return result;
+}
+
+static double normal_angle(const GLfloat *a, const GLfloat *b)
+{
+  double cross[3] = {(double)a[1] * b[2] - (double)a[2] * b[1], (double)a[2] * b[0] - (double)a[0] * b[2],
+                     (double)a[0] * b[1] - (double)a[1] * b[0]};
+  double dot = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+  return atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+}
+
+vertex_format_error_t vertex_format_error(const GLfloat *array, int64_t n_vertices, int stride)
+{
+  vertex_format_error_t result = {0, 0, 0};
+  GLfloat offset[3];
+  GLfloat scale[3];
+  vertex_format_bounds(array, n_vertices, stride, offset, scale);
+  void *data = pack_vertices(array, n_vertices, stride, offset, scale);
+  GLfloat *decoded = unpack_vertices(data, n_vertices, stride, offset, scale);
+  int64_t i;
+  for (i=0; i<n_vertices; i++) {
+    const GLfloat *original = array + i * stride;
+    const GLfloat *copy = decoded + i * stride;
+    int k;
+    for (k=0; k<3; k++)
+      result.position = fmax(result.position, fabs((double)copy[k] - original[k]));
+    if (has_texcoord(stride))
+      for (k=3; k<5; k++)
+        result.texcoord = fmax(result.texcoord, fabs((double)copy[k] - original[k]));
+    if (has_normal(stride))
+      result.normal = fmax(result.normal, normal_angle(original + stride - 3, copy + stride - 3));
+  };
+  GC_FREE(decoded);
+  GC_FREE(data);
+  return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <GL/gl.h>
+
+
+// Vertex buffers store the interleaved vertex data either as 32-bit floats or in a compact format:
+// - positions as three 16-bit unsigned normalized values (padded to 8 bytes) relative to the bounding box of the
+//   buffer. The vertex shader computes point_offset + point * point_scale.
+// - texture coordinates as two half floats, which also covers repeating textures outside the unit square.
+// - normals as GL_INT_2_10_10_10_REV with the w component set to zero. The signed normalized values are converted
+//   with the OpenGL 4.2 rule max(c / 511, -1).
+// A vertex with position, texture coordinates and normal takes 16 instead of 32 bytes.
+typedef enum {VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_COMPACT} vertex_format_t;
+
+// Format used for the vertex buffers of vertex array objects created afterwards.
+void set_vertex_format(vertex_format_t format);
+
+vertex_format_t get_vertex_format(void);
+
+// Number of bytes of a vertex with the given number of floats (3, 5, 6 or 8) in the given format.
+int vertex_format_size(vertex_format_t format, int stride);
+
+uint16_t float_to_half(float value);
+
+float half_to_float(uint16_t value);
+
+uint32_t pack_normal(const GLfloat *normal);
+
+void unpack_normal(uint32_t value, GLfloat *normal);
+
+// Bounding box of all vertices of an interleaved array. The offset is the lower corner and the scale is the size of
+// the box, so that point_offset + point * point_scale maps the unit cube onto the box.
+void vertex_format_bounds(const GLfloat *array, int64_t n_vertices, int stride, GLfloat *offset, GLfloat *scale);
+
+// Convert interleaved floats to the compact format. The caller releases the result with GC_FREE.
+void *pack_vertices(const GLfloat *array, int64_t n_vertices, int stride, const GLfloat *offset, const GLfloat *scale);
+
+// Convert compact vertex data back to interleaved floats. The caller releases the result with GC_FREE.
+GLfloat *unpack_vertices(const void *data, int64_t n_vertices, int stride, const GLfloat *offset,
+                         const GLfloat *scale);
+
+// Largest errors of the compact format for the given vertices: the absolute error of a position coordinate, the
+// absolute error of a texture coordinate and the angle between the original and the decoded normal in radians.
+typedef struct {
+  double position;
+  double texcoord;
+  double normal;
+} vertex_format_error_t;
+
+vertex_format_error_t vertex_format_error(const GLfloat *array, int64_t n_vertices, int stride);
@@ -1,14 +1,22 @@
 // Small example loading and drawing a WaveFront Object File using this library
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
-#include <gc.h>
+#include "fsim/memory.h"
 #include <GL/glew.h>
-#include <GL/glut.h>
+#include <GL/freeglut.h>
 #include "fsim/object.h"
 #include "fsim/program.h"
 #include "fsim/vertex_array_object.h"
 #include "fsim/projection.h"
 #include "fsim/parser.h"
+#include "fsim/deletion_queue.h"
+#include "fsim/accounting.h"
+#include "fsim/material_library.h"
+#include "fsim/texture_cache.h"
+#include "fsim/vertex_cache.h"
+#include "fsim/vertex_fetch.h"
+#include "fsim/overdraw.h"
 
 
 #ifndef M_PI
@@ -26,6 +34,8 @@ float level = 0;
 
 program_t *program;
 list_t *lists;
+list_t *loading = NULL;
+int last_frame = 0;
 
 void transform(void)
 {
@@ -63,7 +73,23 @@ void onDisplay(void)
   int i;
   for (i=0; i<lists->size; i++)
     render(get_pointer(lists)[i]);
+  if (loading)
+    render(loading);
   glutSwapBuffers();
+  // Delete OpenGL objects released by finalizers at the frame boundary without stalling a single frame for long.
+  delete_queued(64);
+}
+
+// Upload each group as soon as it has been parsed and show the progress every 100 milliseconds.
+void onGroup(group_t *group, void *data)
+{
+  append_pointer(loading, make_vertex_array_object(program, group));
+  int time = glutGet(GLUT_ELAPSED_TIME);
+  if (time - last_frame >= 100) {
+    glutMainLoopEvent();
+    onDisplay();
+    last_frame = time;
+  };
 }
 
 void onKey(int key, int x, int y)
@@ -101,8 +127,27 @@ void onKey(int key, int x, int y)
 
 int main(int argc, char **argv)
 {
-  if (argc < 3) {
-    fprintf(stderr, "Syntax: objviewer <object file> ... <scale>\n");
+  int show_memory = 0;
+  int object_cache = 0;
+  int library_cache = 0;
+  int texture_cache = 0;
+  int first = 1;
+  while (first < argc && !strncmp(argv[first], "--", 2)) {
+    if (!strcmp(argv[first], "--memory"))
+      show_memory = 1;
+    else if (!strcmp(argv[first], "--cache"))
+      object_cache = 1;
+    else if (!strcmp(argv[first], "--material-cache"))
+      library_cache = 1;
+    else if (!strcmp(argv[first], "--texture-cache"))
+      texture_cache = 1;
+    else
+      break;
+    first++;
+  };
+  if (argc < first + 2 || !strncmp(argv[first], "--", 2)) {
+    fprintf(stderr, "Syntax: objviewer [--memory] [--cache] [--material-cache] [--texture-cache] <object file> ... "
+                    "<scale>\n");
     return 1;
   };
 
@@ -119,22 +164,31 @@ int main(int argc, char **argv)
   glEnable(GL_MULTISAMPLE_ARB);
 
   program = make_program("vertex.glsl", "fragment.glsl");
+  set_parser_cache(object_cache);
+  set_material_library_cache(library_cache);
+  set_texture_cache(texture_cache);
+  set_vertex_cache_optimization(1);
+  set_overdraw_optimization(1);
+  set_vertex_fetch_optimization(1);
   lists = make_list();
 
-  int i;
-  for (i=1; i<argc-1; i++) {
-    object_t *object = parse_file(argv[i]);
-    if (!object)
-      fprintf(stderr, "Error reading object file %s\n", argv[1]);
-    else {
-      list_t *list = make_vertex_array_object_list(program, object);
-      append_pointer(lists, list);
-    };
-  };
-
   glutDisplayFunc(onDisplay);
   glutReshapeFunc(onResize);
   glutSpecialFunc(onKey);
+
+  int i;
+  for (i=first; i<argc-1; i++) {
+    loading = make_list();
+    if (!parse_file_stream(argv[i], onGroup, NULL))
+      fprintf(stderr, "Error reading object file %s\n", argv[i]);
+    else
+      append_pointer(lists, loading);
+    loading = NULL;
+  };
+  if (show_memory)
+    dump_memory_usage(stdout);
+  glutPostRedisplay();
+
   glutMainLoop();
 
   return 0;
@@ -1,4 +1,4 @@
-#include <gc.h>
+#include "fsim/memory.h"
 #include "munit.h"
 #include "test_helper.h"
 #include "test_group.h"
@@ -7,30 +7,56 @@
 #include "test_program.h"
 #include "test_vertex_array_object.h"
 #include "test_image.h"
+#include "test_image_pool.h"
 #include "test_texture.h"
 #include "test_projection.h"
 #include "test_list.h"
+#include "test_arena.h"
+#include "test_number.h"
 #include "test_hash.h"
 #include "test_parser.h"
+#include "test_scanner.h"
 #include "test_material.h"
 #include "test_integration.h"
+#include "test_cache.h"
+#include "test_decompress.h"
+#include "test_deletion_queue.h"
+#include "test_accounting.h"
+#include "test_texture_cache.h"
+#include "test_vertex_cache.h"
+#include "test_vertex_fetch.h"
+#include "test_overdraw.h"
+#include "test_vertex_format.h"
 
 
 static MunitSuite test_fsim[] = {
-  {"/group"      , test_group      , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/object"     , test_object     , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/shader"     , test_shader     , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/program"    , test_program    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/vao"        , test_vao        , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/image"      , test_image      , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/texture"    , test_texture    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/projection" , test_projection , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/list"       , test_list       , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/hash"       , test_hash       , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/parser"     , test_parser     , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/material"   , test_material   , NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {"/integration", test_integration, NULL, 1, MUNIT_SUITE_OPTION_NONE},
-  {NULL          , NULL            , NULL, 0, MUNIT_SUITE_OPTION_NONE}
+  {"/group"         , test_group         , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/object"        , test_object        , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/shader"        , test_shader        , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/program"       , test_program       , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/vao"           , test_vao           , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/image"         , test_image         , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/image_pool"    , test_image_pool    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/texture"       , test_texture       , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/projection"    , test_projection    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/list"          , test_list          , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/arena"         , test_arena         , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/hash"          , test_hash          , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/number"        , test_number        , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/parser"        , test_parser        , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/scanner"       , test_scanner       , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/material"      , test_material      , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/cache"         , test_cache         , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/decompress"    , test_decompress    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/deletion_queue", test_deletion_queue, NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/accounting"    , test_accounting    , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/texture_cache" , test_texture_cache , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/vertex_cache"  , test_vertex_cache  , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/vertex_fetch"  , test_vertex_fetch  , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/overdraw"      , test_overdraw      , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/vertex_format" , test_vertex_format , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {"/integration"   , test_integration   , NULL, 1, MUNIT_SUITE_OPTION_NONE},
+  {NULL             , NULL               , NULL, 0, MUNIT_SUITE_OPTION_NONE}
 };
 
 static const MunitSuite test_suite[] = {
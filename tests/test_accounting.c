@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include "fsim/memory.h"
+#include "fsim/accounting.h"
+#include "fsim/arena.h"
+#include "fsim/list.h"
+#include "fsim/hash.h"
+#include "fsim/group.h"
+#include "fsim/image.h"
+#include "fsim/material.h"
+#include "test_accounting.h"
+#include "test_helper.h"
+
+
+static MunitResult test_allocation(const MunitParameter params[], void *data)
+{
+  memory_usage_t before = memory_usage(MEMORY_IMAGE);
+  account_allocation(MEMORY_IMAGE, 100);
+  account_allocation(MEMORY_IMAGE, 50);
+  account_release(MEMORY_IMAGE, 100);
+  memory_usage_t after = memory_usage(MEMORY_IMAGE);
+  munit_assert_int(after.bytes - before.bytes, ==, 50);
+  munit_assert_int(after.allocated_bytes - before.allocated_bytes, ==, 150);
+  munit_assert_int(after.allocations - before.allocations, ==, 2);
+  munit_assert_int(after.releases - before.releases, ==, 1);
+  munit_assert_int(after.peak_bytes, >=, before.bytes + 150);
+  return MUNIT_OK;
+}
+
+static MunitResult test_resize(const MunitParameter params[], void *data)
+{
+  memory_usage_t before = memory_usage(MEMORY_IMAGE);
+  account_resize(MEMORY_IMAGE, 0, 64);
+  account_resize(MEMORY_IMAGE, 64, 128);
+  account_resize(MEMORY_IMAGE, 128, 32);
+  memory_usage_t after = memory_usage(MEMORY_IMAGE);
+  munit_assert_int(after.bytes - before.bytes, ==, 32);
+  munit_assert_int(after.allocated_bytes - before.allocated_bytes, ==, 128);
+  munit_assert_int(after.allocations - before.allocations, ==, 2);
+  account_resize(MEMORY_IMAGE, 32, 0);
+  munit_assert_int(memory_usage(MEMORY_IMAGE).bytes, ==, before.bytes);
+  munit_assert_int(memory_usage(MEMORY_IMAGE).releases - before.releases, ==, 1);
+  return MUNIT_OK;
+}
+
+static MunitResult test_reset(const MunitParameter params[], void *data)
+{
+  account_allocation(MEMORY_IMAGE, 1000);
+  account_release(MEMORY_IMAGE, 1000);
+  reset_memory_usage();
+  memory_usage_t usage = memory_usage(MEMORY_IMAGE);
+  munit_assert_int(usage.peak_bytes, ==, usage.bytes);
+  munit_assert_int(usage.allocated_bytes, ==, 0);
+  munit_assert_int(usage.allocations, ==, 0);
+  munit_assert_int(usage.releases, ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_list_growth(const MunitParameter params[], void *data)
+{
+  int64_t before = memory_usage(MEMORY_LIST).bytes;
+  list_t *list = make_list();
+  int i;
+  for (i=0; i<1000; i++)
+    append_gluint(list, i);
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes - before, ==, sizeof(list_t) + list->buffer_size);
+  shrink_gluint(list);
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes - before, ==, sizeof(list_t) + 1000 * sizeof(GLuint));
+  destroy_list(list);
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes, ==, before);
+  return MUNIT_OK;
+}
+
+static MunitResult test_list_category(const MunitParameter params[], void *data)
+{
+  int64_t list_bytes = memory_usage(MEMORY_LIST).bytes;
+  int64_t hash_bytes = memory_usage(MEMORY_HASH).bytes;
+  list_t *list = make_list();
+  append_glfloat(list, 1.0f);
+  set_list_category(list, MEMORY_HASH);
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes, ==, list_bytes);
+  munit_assert_int(memory_usage(MEMORY_HASH).bytes - hash_bytes, ==, sizeof(list_t) + list->buffer_size);
+  append_glfloat(list, 2.0f);
+  munit_assert_int(memory_usage(MEMORY_HASH).bytes - hash_bytes, ==, sizeof(list_t) + list->buffer_size);
+  destroy_list(list);
+  munit_assert_int(memory_usage(MEMORY_HASH).bytes, ==, hash_bytes);
+  return MUNIT_OK;
+}
+
+static MunitResult test_arena_list(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  int64_t list_bytes = memory_usage(MEMORY_LIST).bytes;
+  int64_t arena_bytes = memory_usage(MEMORY_ARENA).bytes;
+  list_t *list = make_arena_list(arena);
+  reserve_glfloat(list, 100000);
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes - list_bytes, ==, sizeof(list_t));
+  munit_assert_int(memory_usage(MEMORY_ARENA).bytes - arena_bytes, ==, 100000 * sizeof(GLfloat));
+  destroy_list(list);
+  destroy_arena(arena);
+  munit_assert_int(memory_usage(MEMORY_ARENA).bytes, ==, arena_bytes);
+  return MUNIT_OK;
+}
+
+static MunitResult test_hash(const MunitParameter params[], void *data)
+{
+  int64_t before = memory_usage(MEMORY_HASH).bytes;
+  index_hash_t *index = make_index_hash();
+  int i;
+  for (i=0; i<1000; i++)
+    hash_find_index(index, i, 0, 0, i);
+  hash_t *hash = make_hash();
+  hash_find_material(hash, "material", make_material());
+  munit_assert_int(memory_usage(MEMORY_HASH).bytes, >, before + 1000 * (int64_t)sizeof(index_entry_t));
+  destroy_index_hash(index);
+  destroy_hash(hash);
+  munit_assert_int(memory_usage(MEMORY_HASH).bytes, ==, before);
+  return MUNIT_OK;
+}
+
+static MunitResult test_group(const MunitParameter params[], void *data)
+{
+  int64_t before = memory_usage(MEMORY_GROUP).bytes;
+  int64_t list_bytes = memory_usage(MEMORY_LIST).bytes;
+  group_t *group = make_group("group", 3);
+  add_vertex_data(group, 3, 1.0f, 2.0f, 3.0f);
+  append_gluint(group->vertex_index, 0);
+  munit_assert_int(memory_usage(MEMORY_GROUP).bytes, >, before + 4 * (int64_t)sizeof(GLfloat));
+  munit_assert_int(memory_usage(MEMORY_LIST).bytes, ==, list_bytes);
+  destroy_group(group);
+  munit_assert_int(memory_usage(MEMORY_GROUP).bytes, ==, before);
+  return MUNIT_OK;
+}
+
+static MunitResult test_dump(const MunitParameter params[], void *data)
+{
+  char *text;
+  size_t size;
+  FILE *file = open_memstream(&text, &size);
+  dump_memory_usage(file);
+  fclose(file);
+  munit_assert_not_null(strstr(text, "gl texture"));
+  munit_assert_not_null(strstr(text, "total"));
+  free(text);
+  return MUNIT_OK;
+}
+
+static MunitResult test_texture(const MunitParameter params[], void *data)
+{
+  int64_t before = memory_usage(MEMORY_GL_TEXTURE).bytes;
+  material_t *material = make_material();
+  image_t *image = read_image("colors.png");
+  int64_t bytes = image->width * image->height * 3;
+  set_diffuse_texture(material, image);
+  destroy_image(image);
+  munit_assert_int(memory_usage(MEMORY_GL_TEXTURE).bytes - before, ==, bytes);
+  destroy_material(material);
+  munit_assert_int(memory_usage(MEMORY_GL_TEXTURE).bytes, ==, before);
+  return MUNIT_OK;
+}
+
+MunitTest test_accounting[] = {
+  {"/allocation"   , test_allocation   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/resize"       , test_resize       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/reset"        , test_reset        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/list_growth"  , test_list_growth  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/list_category", test_list_category, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/arena_list"   , test_arena_list   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/hash"         , test_hash         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/group"        , test_group        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/dump"         , test_dump         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/texture"      , test_texture      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL            , NULL              , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <string.h>
+#include "fsim/arena.h"
+#include "test_arena.h"
+#include "test_helper.h"
+
+
+static MunitResult test_empty(const MunitParameter params[], void *data)
+{
+  munit_assert_int(arena_bytes(make_arena()), ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_small(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *first = arena_alloc(arena, 5);
+  char *second = arena_alloc(arena, 5);
+  strcpy(first, "abcd");
+  strcpy(second, "efgh");
+  munit_assert_string_equal(first, "abcd");
+  munit_assert_ptr(second, ==, first + 16);
+  munit_assert_int(arena_bytes(arena), ==, 1 << 16);
+  return MUNIT_OK;
+}
+
+static MunitResult test_alignment(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  arena_alloc(arena, 3);
+  munit_assert_int((uintptr_t)arena_alloc(arena, 8) % 16, ==, 0);
+  munit_assert_int((uintptr_t)arena_alloc(arena, 100000) % 16, ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_large(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *large = arena_alloc(arena, 100000);
+  memset(large, 42, 100000);
+  munit_assert_int(arena_bytes(arena), ==, 100000);
+  arena_free(arena, large, 100000);
+  munit_assert_int(arena_bytes(arena), ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_grow_small(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *small = arena_alloc(arena, 4);
+  strcpy(small, "abc");
+  char *grown = arena_realloc(arena, small, 4, 200);
+  munit_assert_string_equal(grown, "abc");
+  munit_assert_ptr(arena_realloc(arena, grown, 200, 100), ==, grown);
+  return MUNIT_OK;
+}
+
+static MunitResult test_grow_large(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *small = arena_alloc(arena, 4);
+  strcpy(small, "abc");
+  char *large = arena_realloc(arena, small, 4, 100000);
+  munit_assert_string_equal(large, "abc");
+  large = arena_realloc(arena, large, 100000, 1000000);
+  munit_assert_string_equal(large, "abc");
+  munit_assert_int(arena_bytes(arena), ==, (1 << 16) + 1000000);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shrink_large(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *large = arena_alloc(arena, 100000);
+  strcpy(large, "abc");
+  char *small = arena_realloc(arena, large, 100000, 4);
+  munit_assert_string_equal(small, "abc");
+  munit_assert_int(arena_bytes(arena), ==, 1 << 16);
+  return MUNIT_OK;
+}
+
+static MunitResult test_free_middle(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  char *first = arena_alloc(arena, 100000);
+  char *second = arena_alloc(arena, 100000);
+  char *third = arena_alloc(arena, 100000);
+  arena_free(arena, second, 100000);
+  third = arena_realloc(arena, third, 100000, 200000);
+  arena_free(arena, first, 100000);
+  munit_assert_int(arena_bytes(arena), ==, 200000);
+  arena_free(arena, third, 200000);
+  munit_assert_int(arena_bytes(arena), ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_clear(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  int i;
+  for (i=0; i<10000; i++)
+    arena_alloc(arena, 100);
+  arena_alloc(arena, 100000);
+  clear_arena(arena);
+  munit_assert_int(arena_bytes(arena), ==, 0);
+  munit_assert_not_null(arena_alloc(arena, 100));
+  return MUNIT_OK;
+}
+
+MunitTest test_arena[] = {
+  {"/empty"       , test_empty       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/small"       , test_small       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/alignment"   , test_alignment   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/large"       , test_large       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/grow_small"  , test_grow_small  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/grow_large"  , test_grow_large  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shrink_large", test_shrink_large, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/free_middle" , test_free_middle , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/clear"       , test_clear       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL           , NULL             , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fsim/memory.h"
+#include "fsim/cache.h"
+#include "fsim/parser.h"
+#include "fsim/scanner.h"
+#include "fsim/vertex_array_object.h"
+#include "test_cache.h"
+#include "test_helper.h"
+
+
+static char *write_file(const char *text)
+{
+  char *result = GC_MALLOC_ATOMIC(32);
+  strcpy(result, "/tmp/fsim-cache-XXXXXX");
+  int fd = mkstemp(result);
+  munit_assert_int(fd, >=, 0);
+  munit_assert_int(write(fd, text, strlen(text)), ==, strlen(text));
+  close(fd);
+  return result;
+}
+
+static char *test_file(const char *text)
+{
+  char *result = write_file(text);
+  unlink(object_cache_file_name(result));
+  unlink(group_index_file_name(result));
+  return result;
+}
+
+static void remove_files(const char *file_name)
+{
+  unlink(object_cache_file_name(file_name));
+  unlink(group_index_file_name(file_name));
+  unlink(file_name);
+}
+
+static void assert_same_group(group_t *group, group_t *reference)
+{
+  munit_assert_string_equal(group->name, reference->name);
+  munit_assert_int(group->stride, ==, reference->stride);
+  munit_assert_ptr(group->material, ==, reference->material);
+  munit_assert_int(group->array->size, ==, reference->array->size);
+  munit_assert_int(group->vertex_index->size, ==, reference->vertex_index->size);
+  munit_assert_memory_equal(size_of_array(group), group->array->element, reference->array->element);
+  munit_assert_memory_equal(size_of_indices(group), group->vertex_index->element, reference->vertex_index->element);
+}
+
+static object_t *cached_object(const char *file_name)
+{
+  object_t *object = parse_file(file_name);
+  munit_assert_not_null(object);
+  munit_assert_int(write_object_cache(file_name, object, make_list()), ==, 0);
+  return object;
+}
+
+static void *test_setup_cache(const MunitParameter params[], void *user_data)
+{
+  set_parser_cache(0);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_cache(void *fixture)
+{
+  set_parser_cache(0);
+  test_teardown_gc(fixture);
+}
+
+static MunitResult test_file_name(const MunitParameter params[], void *data)
+{
+  munit_assert_string_equal(object_cache_file_name("test.obj"), "test.obj.cache");
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_cache(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\n");
+  munit_assert_null(read_object_cache(file_name));
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_object_name(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\n");
+  cached_object(file_name);
+  object_t *object = read_object_cache(file_name);
+  munit_assert_not_null(object);
+  munit_assert_string_equal(object->name, "test");
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_groups(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nv 5 7 11\nvn 0 0 1\ng first\nf 1//1 2//1 3//1\n"
+                              "g second\nf 2 3 4\nf 4 3 1\n");
+  object_t *expected = cached_object(file_name);
+  object_t *object = read_object_cache(file_name);
+  munit_assert_int(object->group->size, ==, 2);
+  int i;
+  for (i=0; i<2; i++) {
+    group_t *group = get_pointer(object->group)[i];
+    group_t *reference = get_pointer(expected->group)[i];
+    munit_assert_string_equal(group->name, reference->name);
+    munit_assert_int(group->stride, ==, reference->stride);
+    munit_assert_int(group->array->size, ==, reference->array->size);
+    munit_assert_int(group->vertex_index->size, ==, reference->vertex_index->size);
+    munit_assert_memory_equal(size_of_array(group), group->array->element, reference->array->element);
+    munit_assert_memory_equal(size_of_indices(group), group->vertex_index->element, reference->vertex_index->element);
+  };
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_vertex_pools(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nvt 0 1\ng first\nf 1 2 3\ng second\nf 1/1 2/1 3/1\n"
+                              "g third\nf 3 2 1\n");
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  object_t *expected = parse_file_core(context, file_name);
+  munit_assert_int(write_object_cache(file_name, expected, make_list()), ==, 0);
+  object_t *object = read_object_cache(file_name);
+  munit_assert_not_null(object);
+  munit_assert_int(object->pool->size, ==, 2);
+  int i;
+  for (i=0; i<2; i++) {
+    vertex_pool_t *pool = get_pointer(object->pool)[i];
+    vertex_pool_t *reference = get_pointer(expected->pool)[i];
+    munit_assert_int(pool->stride, ==, reference->stride);
+    munit_assert_int(pool->array->size, ==, reference->array->size);
+    munit_assert_memory_equal(pool->array->size * sizeof(GLfloat), pool->array->element, reference->array->element);
+  };
+  group_t *first = get_pointer(object->group)[0];
+  group_t *third = get_pointer(object->group)[2];
+  munit_assert_ptr(first->pool, ==, get_pointer(object->pool)[0]);
+  munit_assert_ptr(third->pool, ==, first->pool);
+  munit_assert_int(third->vertex_index->size, ==, 3);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static void count_group(group_t *group, void *data)
+{
+  (*(int *)data)++;
+}
+
+static MunitResult test_stream_vertex_pools(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\ng first\nf 1 2 3\ng second\nf 3 2 1\n");
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  munit_assert_int(write_object_cache(file_name, parse_file_core(context, file_name), make_list()), ==, 0);
+  set_parser_cache(1);
+  int n_groups = 0;
+  object_t *object = parse_file_stream(file_name, count_group, &n_groups);
+  munit_assert_int(n_groups, ==, 2);
+  munit_assert_int(object->pool->size, ==, 0);
+  munit_assert_int(((group_t *)get_pointer(object->group)[1])->array->size, ==, 9);
+  munit_assert_int(read_object_cache(file_name)->pool->size, ==, 0);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static void release_group(group_t *group, void *data)
+{
+  release_group_data(group);
+}
+
+static MunitResult test_stream_released_groups(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\ng first\nf 1 1 1\n");
+  int n_groups = 0;
+  set_parser_cache(1);
+  set_upload_mode(UPLOAD_RELEASE);
+  parse_file_stream(file_name, release_group, NULL);
+  set_upload_mode(UPLOAD_KEEP);
+  munit_assert_int(access(object_cache_file_name(file_name), R_OK), !=, 0);
+  parse_file_stream(file_name, count_group, &n_groups);
+  munit_assert_int(access(object_cache_file_name(file_name), R_OK), ==, 0);
+  group_t *group = get_pointer(read_object_cache(file_name)->group)[0];
+  munit_assert_int(group->vertex_index->size, ==, 3);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_append_after_load(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\ng first\nf 1 1 1\n");
+  cached_object(file_name);
+  group_t *group = get_pointer(read_object_cache(file_name)->group)[0];
+  add_triangle(group, 0, 0, 0);
+  munit_assert_int(group->vertex_index->size, ==, 6);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_materials(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("newmtl red\nKd 1 0 0\nNs 20\nillum 2\nnewmtl blue\nKd 0 0 1\no test\nv 1 2 3\n"
+                              "usemtl blue\ng first\nf 1 1 1\ng second\nf 1 1 1\nusemtl red\ng third\nf 1 1 1\n");
+  cached_object(file_name);
+  object_t *object = read_object_cache(file_name);
+  group_t *first = get_pointer(object->group)[0];
+  group_t *second = get_pointer(object->group)[1];
+  group_t *third = get_pointer(object->group)[2];
+  munit_assert_ptr(first->material, ==, second->material);
+  munit_assert_float(first->material->diffuse[2], ==, 1.0f);
+  munit_assert_float(third->material->diffuse[0], ==, 1.0f);
+  munit_assert_float(third->material->specular_exponent, ==, 20.0f);
+  munit_assert_int(third->material->illumination, ==, 2);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_modified_source(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\n");
+  cached_object(file_name);
+  FILE *f = fopen(file_name, "a");
+  fputs("v 1 2 3\n", f);
+  fclose(f);
+  munit_assert_null(read_object_cache(file_name));
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_modified_dependency(const MunitParameter params[], void *data)
+{
+  char *library = write_file("newmtl test\n");
+  char source[64];
+  snprintf(source, sizeof(source), "mtllib %s\no test\n", library);
+  char *file_name = test_file(source);
+  set_parser_cache(1);
+  munit_assert_not_null(parse_file(file_name));
+  munit_assert_not_null(read_object_cache(file_name));
+  FILE *f = fopen(library, "a");
+  fputs("Kd 1 1 1\n", f);
+  fclose(f);
+  munit_assert_null(read_object_cache(file_name));
+  remove_files(file_name);
+  unlink(library);
+  return MUNIT_OK;
+}
+
+static MunitResult test_truncated_cache(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\ng first\nf 1 1 1\n");
+  cached_object(file_name);
+  truncate(object_cache_file_name(file_name), 100);
+  munit_assert_null(read_object_cache(file_name));
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static void assert_rejected(const char *file_name, object_t *object)
+{
+  munit_assert_int(write_object_cache(file_name, object, make_list()), ==, 0);
+  munit_assert_null(read_object_cache(file_name));
+}
+
+static MunitResult test_invalid_index(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\ng first\nf 1 2 3\n");
+  object_t *object = parse_file(file_name);
+  group_t *group = get_pointer(object->group)[0];
+  get_gluint(group->vertex_index)[2] = 3;
+  assert_rejected(file_name, object);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_invalid_stride(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nv 5 7 11\ng first\nf 1 2 3\n");
+  object_t *object = parse_file(file_name);
+  group_t *group = get_pointer(object->group)[0];
+  group->stride = 4;
+  assert_rejected(file_name, object);
+  group->stride = 3;
+  append_glfloat(group->array, 0.0f);
+  assert_rejected(file_name, object);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_pool_stride_mismatch(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nv 5 7 11\ng first\nf 1 2 3\n");
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  object_t *object = parse_file_core(context, file_name);
+  group_t *group = get_pointer(object->group)[0];
+  group->stride = 6;
+  assert_rejected(file_name, object);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parse_file_writes_cache(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("o test\n");
+  set_parser_cache(1);
+  parse_file(file_name);
+  munit_assert_int(access(object_cache_file_name(file_name), R_OK), ==, 0);
+  munit_assert_string_equal(parse_file(file_name)->name, "test");
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static const char *groups_text =
+  "o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\ng first\nf 1 2 3\nv 5 7 11\nvt 0 1\nvt 1 0\nvn 0 0 1\ng second\n"
+  "f 2/1/1 3/2/1 4/2/1\ng third\nf -1 -2 -3\n";
+
+static MunitResult test_group_index_file_name(const MunitParameter params[], void *data)
+{
+  munit_assert_string_equal(group_index_file_name("test.obj"), "test.obj.index");
+  return MUNIT_OK;
+}
+
+static MunitResult test_index_groups(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file(groups_text);
+  group_index_t *index = index_groups(file_name);
+  munit_assert_not_null(index);
+  munit_assert_string_equal(index->object_name, "test");
+  munit_assert_int(index->entries->size, ==, 3);
+  group_entry_t *second = get_pointer(index->entries)[1];
+  munit_assert_string_equal(second->name, "second");
+  munit_assert_int(second->block.start, ==, strstr(groups_text, "g second") - groups_text);
+  munit_assert_int(second->block.end, ==, strstr(groups_text, "g third") - groups_text);
+  munit_assert_int(second->block.line, ==, 11);
+  munit_assert_int(second->vertex_start, ==, strstr(groups_text, "v 2 3 5") - groups_text);
+  munit_assert_int(second->n_vertex, ==, 1);
+  munit_assert_int(second->n_uv, ==, 0);
+  munit_assert_int(second->n_normal, ==, 0);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_read_group_index(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file(groups_text);
+  munit_assert_int(write_group_index(file_name, index_groups(file_name)), ==, 0);
+  group_index_t *index = read_group_index(file_name);
+  munit_assert_not_null(index);
+  munit_assert_string_equal(index->object_name, "test");
+  munit_assert_int(index->entries->size, ==, 3);
+  group_entry_t *third = get_pointer(index->entries)[2];
+  munit_assert_string_equal(third->name, "third");
+  munit_assert_null(third->material);
+  munit_assert_int(third->block.end, ==, strlen(groups_text));
+  munit_assert_int(third->n_vertex, ==, 1);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_stale_group_index(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file(groups_text);
+  write_group_index(file_name, index_groups(file_name));
+  FILE *f = fopen(file_name, "a");
+  fputs("v 1 2 3\n", f);
+  fclose(f);
+  munit_assert_null(read_group_index(file_name));
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_load_groups(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file(groups_text);
+  object_t *expected = parse_file(file_name);
+  const char *names[] = {"second", "third", NULL};
+  object_t *object = parse_file_groups(file_name, names);
+  munit_assert_not_null(object);
+  munit_assert_string_equal(object->name, "test");
+  munit_assert_int(object->group->size, ==, 2);
+  assert_same_group(get_pointer(object->group)[0], get_pointer(expected->group)[1]);
+  assert_same_group(get_pointer(object->group)[1], get_pointer(expected->group)[2]);
+  munit_assert_int(access(group_index_file_name(file_name), R_OK), ==, 0);
+  object = parse_file_groups(file_name, names);
+  assert_same_group(get_pointer(object->group)[0], get_pointer(expected->group)[1]);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_load_group_material(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file("newmtl red\nKd 1 0 0\nnewmtl blue\nKd 0 0 1\no test\nv 1 2 3\nusemtl blue\ng first\n"
+                              "f 1 1 1\nusemtl red\ng second\nf 1 1 1\n");
+  const char *names[] = {"first", "second", NULL};
+  object_t *object = parse_file_groups(file_name, names);
+  group_t *first = get_pointer(object->group)[0];
+  group_t *second = get_pointer(object->group)[1];
+  munit_assert_float(first->material->diffuse[2], ==, 1.0f);
+  munit_assert_float(second->material->diffuse[0], ==, 1.0f);
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_load_no_groups(const MunitParameter params[], void *data)
+{
+  char *file_name = test_file(groups_text);
+  const char *names[] = {"nosuchgroup", NULL};
+  object_t *object = parse_file_groups(file_name, names);
+  munit_assert_not_null(object);
+  munit_assert_int(object->group->size, ==, 0);
+  munit_assert_null(parse_file_groups("nosuchfile.obj", names));
+  remove_files(file_name);
+  return MUNIT_OK;
+}
+
+MunitTest test_cache[] = {
+  {"/file_name"               , test_file_name               , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_cache"                , test_no_cache                , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/object_name"             , test_object_name             , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/groups"                  , test_groups                  , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vertex_pools"            , test_vertex_pools            , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/stream_vertex_pools"     , test_stream_vertex_pools     , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/stream_released_groups"  , test_stream_released_groups  , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/append_after_load"       , test_append_after_load       , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/materials"               , test_materials               , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/modified_source"         , test_modified_source         , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/modified_dependency"     , test_modified_dependency     , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/truncated_cache"         , test_truncated_cache         , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/invalid_index"           , test_invalid_index           , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/invalid_stride"          , test_invalid_stride          , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/pool_stride_mismatch"    , test_pool_stride_mismatch    , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parse_file_writes_cache" , test_parse_file_writes_cache , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/group_index_file_name"   , test_group_index_file_name   , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/index_groups"            , test_index_groups            , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/read_group_index"        , test_read_group_index        , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/stale_group_index"       , test_stale_group_index       , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/load_groups"             , test_load_groups             , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/load_group_material"     , test_load_group_material     , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/load_no_groups"          , test_load_no_groups          , test_setup_cache, test_teardown_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                       , NULL                         , NULL            , NULL               , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <lzma.h>
+#include "fsim/memory.h"
+#include "fsim/decompress.h"
+#include "fsim/parser.h"
+#include "test_decompress.h"
+#include "test_helper.h"
+
+
+static char *backends[] = {"mmap", "flex", NULL};
+
+static MunitParameterEnum parser_params[] = {
+  {"backend", backends},
+  {NULL, NULL}
+};
+
+static void *test_setup_parser(const MunitParameter params[], void *user_data)
+{
+  const char *backend = munit_parameters_get(params, "backend");
+  set_parser_backend(backend && !strcmp(backend, "flex") ? PARSER_FLEX : PARSER_MMAP);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_parser(void *fixture)
+{
+  set_parser_backend(PARSER_MMAP);
+  test_teardown_gc(fixture);
+}
+
+static char *temporary_file(const char *suffix)
+{
+  char *result = GC_MALLOC_ATOMIC(32);
+  sprintf(result, "/tmp/fsim-input-XXXXXX%s", suffix);
+  int fd = mkstemps(result, strlen(suffix));
+  munit_assert_int(fd, >=, 0);
+  close(fd);
+  return result;
+}
+
+static char *write_data(const char *data, size_t size, const char *suffix)
+{
+  char *result = temporary_file(suffix);
+  FILE *f = fopen(result, "wb");
+  fwrite(data, 1, size, f);
+  fclose(f);
+  return result;
+}
+
+static char *write_plain(const char *text, const char *suffix)
+{
+  return write_data(text, strlen(text), suffix);
+}
+
+static char *write_gzip(const char *text, const char *suffix)
+{
+  char *result = temporary_file(suffix);
+  gzFile f = gzopen(result, "wb");
+  munit_assert_int(gzwrite(f, text, strlen(text)), ==, strlen(text));
+  gzclose(f);
+  return result;
+}
+
+static char *write_xz(const char *text, const char *suffix)
+{
+  size_t size = 0;
+  size_t buffer_size = lzma_stream_buffer_bound(strlen(text));
+  uint8_t *buffer = GC_MALLOC_ATOMIC(buffer_size);
+  munit_assert_int(lzma_easy_buffer_encode(1, LZMA_CHECK_CRC64, NULL, (const uint8_t *)text, strlen(text), buffer, &size,
+                                           buffer_size), ==, LZMA_OK);
+  return write_data((const char *)buffer, size, suffix);
+}
+
+static char *large_text(int n_lines)
+{
+  char *result = GC_MALLOC_ATOMIC(n_lines * 16 + 1);
+  char *p = result;
+  int i;
+  for (i=0; i<n_lines; i++)
+    p += sprintf(p, "v %d 2 3\n", i);
+  return result;
+}
+
+static char *read_all(decompressor_t *decompressor)
+{
+  size_t size = 0;
+  char *result = GC_MALLOC_ATOMIC(1);
+  const char *block;
+  size_t block_size;
+  while ((block = next_block(decompressor, &block_size))) {
+    char *grown = GC_MALLOC_ATOMIC(size + block_size + 1);
+    memcpy(grown, result, size);
+    memcpy(grown + size, block, block_size);
+    result = grown;
+    size += block_size;
+  };
+  result[size] = '\0';
+  return result;
+}
+
+static MunitResult test_detect_compression(const MunitParameter params[], void *data)
+{
+  char *plain = write_plain("o test\n", ".obj");
+  char *gzip = write_gzip("o test\n", ".obj.gz");
+  char *xz = write_xz("o test\n", ".obj.xz");
+  munit_assert_false(is_compressed(plain));
+  munit_assert_true(is_compressed(gzip));
+  munit_assert_true(is_compressed(xz));
+  munit_assert_false(is_compressed("nosuchfile.obj.gz"));
+  unlink(plain);
+  unlink(gzip);
+  unlink(xz);
+  return MUNIT_OK;
+}
+
+static MunitResult test_gzip_content(const MunitParameter params[], void *data)
+{
+  char *file_name = write_gzip("o test\nv 1 2 3", ".gz");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  munit_assert_not_null(decompressor);
+  munit_assert_string_equal(read_all(decompressor), "o test\nv 1 2 3");
+  munit_assert_false(decompressor_error(decompressor));
+  close_decompressor(decompressor);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_xz_content(const MunitParameter params[], void *data)
+{
+  char *file_name = write_xz("o test\nv 1 2 3", ".xz");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  munit_assert_not_null(decompressor);
+  munit_assert_string_equal(read_all(decompressor), "o test\nv 1 2 3");
+  munit_assert_false(decompressor_error(decompressor));
+  close_decompressor(decompressor);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_line_boundaries(const MunitParameter params[], void *data)
+{
+  char *text = large_text(500000);
+  char *file_name = write_gzip(text, ".gz");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  const char *block;
+  size_t size;
+  size_t total = 0;
+  int n_blocks = 0;
+  while ((block = next_block(decompressor, &size))) {
+    munit_assert_char(block[size - 1], ==, '\n');
+    munit_assert_memory_equal(size, block, text + total);
+    total += size;
+    n_blocks++;
+  };
+  munit_assert_size(total, ==, strlen(text));
+  munit_assert_int(n_blocks, >, 1);
+  close_decompressor(decompressor);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_close_early(const MunitParameter params[], void *data)
+{
+  char *file_name = write_gzip(large_text(500000), ".gz");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  size_t size;
+  munit_assert_not_null(next_block(decompressor, &size));
+  close_decompressor(decompressor);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_corrupt_data(const MunitParameter params[], void *data)
+{
+  static const char corrupt[] = "\xfd" "7zXZ" "\x00" "corrupt";
+  char *file_name = write_data(corrupt, sizeof(corrupt) - 1, ".xz");
+  decompressor_t *decompressor = open_decompressor(file_name);
+  munit_assert_not_null(decompressor);
+  read_all(decompressor);
+  munit_assert_true(decompressor_error(decompressor));
+  close_decompressor(decompressor);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_such_file(const MunitParameter params[], void *data)
+{
+  munit_assert_null(open_decompressor("nosuchfile.obj.gz"));
+  munit_assert_null(open_input("nosuchfile.obj.gz"));
+  return MUNIT_OK;
+}
+
+static MunitResult test_open_input(const MunitParameter params[], void *data)
+{
+  char *file_name = write_xz("o test\nv 1 2 3\n", ".xz");
+  FILE *f = open_input(file_name);
+  munit_assert_not_null(f);
+  char line[16];
+  munit_assert_not_null(fgets(line, sizeof(line), f));
+  munit_assert_string_equal(line, "o test\n");
+  munit_assert_not_null(fgets(line, sizeof(line), f));
+  munit_assert_string_equal(line, "v 1 2 3\n");
+  munit_assert_null(fgets(line, sizeof(line), f));
+  fclose(f);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parse_gzip(const MunitParameter params[], void *data)
+{
+  char *file_name = write_gzip("o test\nv 1 2 3\nv 4 5 6\nv 7 8 9\ng g\nf 1 2 3\n", ".obj.gz");
+  object_t *object = parse_file(file_name);
+  munit_assert_not_null(object);
+  munit_assert_string_equal(object->name, "test");
+  munit_assert_int(object->group->size, ==, 1);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parse_xz(const MunitParameter params[], void *data)
+{
+  char *file_name = write_xz("o test\nv 1 2 3\nv 4 5 6\nv 7 8 9\ng g\nf 1 2 3\n", ".obj.xz");
+  object_t *object = parse_file(file_name);
+  munit_assert_not_null(object);
+  munit_assert_string_equal(object->name, "test");
+  munit_assert_int(object->group->size, ==, 1);
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compressed_include(const MunitParameter params[], void *data)
+{
+  char *material = write_gzip("newmtl stone\nKd 0.5 0.25 0.125\n", ".mtl.gz");
+  char *text = GC_MALLOC_ATOMIC(128);
+  sprintf(text, "mtllib %s\no test\n", material);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, text);
+  munit_assert_ptr(hash_find_material(context->materials, "stone", NULL), !=, NULL);
+  unlink(material);
+  return MUNIT_OK;
+}
+
+MunitTest test_decompress[] = {
+  {"/detect_compression" , test_detect_compression , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/gzip_content"       , test_gzip_content       , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/xz_content"         , test_xz_content         , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/line_boundaries"    , test_line_boundaries    , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/close_early"        , test_close_early        , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/corrupt_data"       , test_corrupt_data       , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/no_such_file"       , test_no_such_file       , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/open_input"         , test_open_input         , test_setup_gc    , test_teardown_gc    , MUNIT_TEST_OPTION_NONE, NULL         },
+  {"/parse_gzip"         , test_parse_gzip         , test_setup_parser, test_teardown_parser, MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/parse_xz"           , test_parse_xz           , test_setup_parser, test_teardown_parser, MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/compressed_include" , test_compressed_include , test_setup_parser, test_teardown_parser, MUNIT_TEST_OPTION_NONE, parser_params},
+  {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,93 @@
+#include <pthread.h>
+#include <GL/glew.h>
+#include "fsim/deletion_queue.h"
+#include "test_deletion_queue.h"
+#include "test_helper.h"
+
+
+static MunitResult test_count_queued(const MunitParameter params[], void *data)
+{
+  int64_t queued = queued_deletions();
+  queue_deletion(DELETE_BUFFER, 1);
+  queue_deletion(DELETE_TEXTURE, 2);
+  munit_assert_int(queued_deletions(), ==, queued + 2);
+  return MUNIT_OK;
+}
+
+static MunitResult test_ignore_zero(const MunitParameter params[], void *data)
+{
+  int64_t queued = queued_deletions();
+  queue_deletion(DELETE_BUFFER, 0);
+  munit_assert_int(queued_deletions(), ==, queued);
+  return MUNIT_OK;
+}
+
+static void *queue_buffers(void *data)
+{
+  int i;
+  for (i=1; i<=10000; i++)
+    queue_deletion(DELETE_BUFFER, i);
+  return NULL;
+}
+
+static MunitResult test_concurrent_queue(const MunitParameter params[], void *data)
+{
+  int64_t queued = queued_deletions();
+  pthread_t thread[4];
+  int i;
+  for (i=0; i<4; i++)
+    pthread_create(&thread[i], NULL, queue_buffers, NULL);
+  for (i=0; i<4; i++)
+    pthread_join(thread[i], NULL);
+  munit_assert_int(queued_deletions(), ==, queued + 40000);
+  return MUNIT_OK;
+}
+
+static MunitResult test_delete_texture(const MunitParameter params[], void *data)
+{
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  queue_deletion(DELETE_TEXTURE, texture);
+  munit_assert_true(glIsTexture(texture));
+  munit_assert_int(delete_queued(0), ==, 1);
+  munit_assert_false(glIsTexture(texture));
+  munit_assert_int(completed_deletions(), ==, queued_deletions());
+  return MUNIT_OK;
+}
+
+static MunitResult test_delete_vertex_array(const MunitParameter params[], void *data)
+{
+  GLuint vertex_array;
+  glGenVertexArrays(1, &vertex_array);
+  glBindVertexArray(vertex_array);
+  glBindVertexArray(0);
+  queue_deletion(DELETE_VERTEX_ARRAY, vertex_array);
+  delete_queued(0);
+  munit_assert_false(glIsVertexArray(vertex_array));
+  return MUNIT_OK;
+}
+
+static MunitResult test_bounded_batch(const MunitParameter params[], void *data)
+{
+  GLuint buffer[3];
+  glGenBuffers(3, buffer);
+  int i;
+  for (i=0; i<3; i++)
+    queue_deletion(DELETE_BUFFER, buffer[i]);
+  munit_assert_int(delete_queued(2), ==, 2);
+  munit_assert_int(queued_deletions() - completed_deletions(), ==, 1);
+  munit_assert_int(delete_queued(2), ==, 1);
+  munit_assert_int(delete_queued(2), ==, 0);
+  return MUNIT_OK;
+}
+
+MunitTest test_deletion_queue[] = {
+  {"/count_queued"       , test_count_queued       , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/ignore_zero"        , test_ignore_zero        , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/concurrent_queue"   , test_concurrent_queue   , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/delete_texture"     , test_delete_texture     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/delete_vertex_array", test_delete_vertex_array, test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/bounded_batch"      , test_bounded_batch      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                  , NULL                    , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,5 @@
+#pragma once
+#include "munit.h"
+
+
+extern MunitTest test_deletion_queue[];
@@ -9,10 +9,19 @@ static MunitResult test_empty_group(const MunitParameter params[], void *data)
   munit_assert_int(group->array->size, ==, 0);
   munit_assert_int(group->stride, ==, 8);
   munit_assert_ptr(group->material, ==, NULL);
+  munit_assert_ptr(group->pool, ==, NULL);
   munit_assert_string_equal(group->name, "test");
   return MUNIT_OK;
 }
 
+static MunitResult test_vertex_pool(const MunitParameter params[], void *data)
+{
+  vertex_pool_t *pool = make_vertex_pool(5);
+  munit_assert_int(pool->stride, ==, 5);
+  munit_assert_int(pool->array->size, ==, 0);
+  return MUNIT_OK;
+}
+
 static MunitResult test_copy_name(const MunitParameter params[], void *data)
 {
   char test[2] = "x";
@@ -155,21 +164,88 @@ static MunitResult test_use_material(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_destroy_group(const MunitParameter params[], void *data)
+{
+  group_t *group = make_group("test", 3);
+  vertex_pool_t *pool = make_vertex_pool(3);
+  group->pool = pool;
+  add_vertex_data(group, 3, 1.0f, 2.0f, 3.0f);
+  add_triangle(group, 0, 0, 0);
+  destroy_group(group);
+  append_glfloat(pool->array, 1.0f);
+  munit_assert_int(pool->array->size, ==, 1);
+  destroy_vertex_pool(pool);
+  return MUNIT_OK;
+}
+
+static group_t *textured_triangle(void)
+{
+  group_t *group = make_group("test", 5);
+  add_vertex_data(group, 5, 1.0f, 2.0f, 3.0f, 0.0f, 0.0f);
+  add_vertex_data(group, 5, -1.0f, 5.0f, 3.0f, 1.0f, 0.0f);
+  add_vertex_data(group, 5, 0.0f, 4.0f, -2.0f, 0.0f, 1.0f);
+  add_vertex_data(group, 5, 9.0f, 9.0f, 9.0f, 1.0f, 1.0f);
+  add_triangle(group, 0, 1, 2);
+  return group;
+}
+
+static MunitResult test_update_bounds(const MunitParameter params[], void *data)
+{
+  group_t *group = textured_triangle();
+  update_bounds(group);
+  munit_assert_float(group->bounds[0], ==, -1.0f);
+  munit_assert_float(group->bounds[1], ==, 2.0f);
+  munit_assert_float(group->bounds[2], ==, -2.0f);
+  munit_assert_float(group->bounds[3], ==, 1.0f);
+  munit_assert_float(group->bounds[4], ==, 5.0f);
+  munit_assert_float(group->bounds[5], ==, 3.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compact_group(const MunitParameter params[], void *data)
+{
+  group_t *group = textured_triangle();
+  compact_group(group);
+  munit_assert_int(group->stride, ==, 3);
+  munit_assert_int(group->array->size, ==, 12);
+  munit_assert_float(get_glfloat(group->array)[3], ==, -1.0f);
+  munit_assert_float(get_glfloat(group->array)[8], ==, -2.0f);
+  munit_assert_int(group->vertex_index->size, ==, 3);
+  munit_assert_float(group->bounds[4], ==, 5.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_release_group_data(const MunitParameter params[], void *data)
+{
+  group_t *group = textured_triangle();
+  release_group_data(group);
+  munit_assert_int(group->array->size, ==, 0);
+  munit_assert_int(group->vertex_index->size, ==, 0);
+  munit_assert_int(group->array->buffer_size, ==, 0);
+  munit_assert_float(group->bounds[0], ==, -1.0f);
+  return MUNIT_OK;
+}
+
 MunitTest test_group[] = {
-  {"/empty_group"     , test_empty_group     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/copy_name"       , test_copy_name       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_coordinate"  , test_add_coordinate  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_pair"        , test_add_pair        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_three"       , test_add_three       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/empty_array"     , test_empty_array     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/size_of_array"   , test_size_of_array   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_indices"      , test_no_indices      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/empty_indices"   , test_empty_indices   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/size_of_indices" , test_size_of_indices , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_texcoord"    , test_add_texcoord    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_triangle"    , test_add_triangle    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_square"      , test_add_square      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_pentagon"    , test_add_pentagon    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/use_material"    , test_use_material    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL               , NULL                 , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL}
+  {"/empty_group"       , test_empty_group       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/copy_name"         , test_copy_name         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vertex_pool"       , test_vertex_pool       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_coordinate"    , test_add_coordinate    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_pair"          , test_add_pair          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_three"         , test_add_three         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/empty_array"       , test_empty_array       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/size_of_array"     , test_size_of_array     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_indices"        , test_no_indices        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/empty_indices"     , test_empty_indices     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/size_of_indices"   , test_size_of_indices   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_texcoord"      , test_add_texcoord      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_triangle"      , test_add_triangle      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_square"        , test_add_square        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_pentagon"      , test_add_pentagon      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/use_material"      , test_use_material      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_group"     , test_destroy_group     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/update_bounds"     , test_update_bounds     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_group"     , test_compact_group     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/release_group_data", test_release_group_data, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                 , NULL                   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL}
 };
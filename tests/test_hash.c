@@ -5,14 +5,14 @@
 
 static MunitResult test_no_index(const MunitParameter params[], void *data)
 {
-  hash_t *hash = make_hash();
+  index_hash_t *hash = make_index_hash();
   munit_assert_int(hash_find_index(hash, 2, 3, 5, 37), ==, 37);
   return MUNIT_OK;
 }
 
 static MunitResult test_add_index(const MunitParameter params[], void *data)
 {
-  hash_t *hash = make_hash();
+  index_hash_t *hash = make_index_hash();
   hash_find_index(hash, 2, 3, 5, 37);
   munit_assert_int(hash_find_index(hash, 2, 3, 5, 12), ==, 37);
   return MUNIT_OK;
@@ -20,7 +20,7 @@ static MunitResult test_add_index(const MunitParameter params[], void *data)
 
 static MunitResult test_add_two_indices(const MunitParameter params[], void *data)
 {
-  hash_t *hash = make_hash();
+  index_hash_t *hash = make_index_hash();
   hash_find_index(hash, 2, 3, 5, 37);
   hash_find_index(hash, 1, 2, 4,  2);
   munit_assert_int(hash_find_index(hash, 2, 3, 5, 14), ==, 37);
@@ -63,20 +63,39 @@ static MunitResult test_create_key_list(const MunitParameter params[], void *dat
   return MUNIT_OK;
 }
 
-static MunitResult test_protect_key_from_gc(const MunitParameter params[], void *data)
+static MunitResult test_count_indices(const MunitParameter params[], void *data)
 {
-  hash_t *hash = make_hash();
+  index_hash_t *hash = make_index_hash();
   hash_find_index(hash, 2, 3, 5, 37);
-  munit_assert_int(hash->items->size, ==, 1);
+  hash_find_index(hash, 2, 3, 5, 38);
+  hash_find_index(hash, 2, 3, 0, 39);
+  munit_assert_int(hash->size, ==, 2);
   return MUNIT_OK;
 }
 
-static MunitResult test_only_store_key_once(const MunitParameter params[], void *data)
+static MunitResult test_many_indices(const MunitParameter params[], void *data)
 {
-  hash_t *hash = make_hash();
-  hash_find_index(hash, 2, 3, 5, 37);
-  hash_find_index(hash, 2, 3, 5, 38);
-  munit_assert_int(hash->items->size, ==, 1);
+  index_hash_t *hash = make_index_hash();
+  int i;
+  for (i=0; i<200000; i++)
+    munit_assert_int(hash_find_index(hash, i + 1, i % 7, -i, i), ==, i);
+  for (i=0; i<200000; i++)
+    munit_assert_int(hash_find_index(hash, i + 1, i % 7, -i, -1), ==, i);
+  munit_assert_int(hash->size, ==, 200000);
+  munit_assert_int(hash->capacity, >=, 2 * hash->size);
+  return MUNIT_OK;
+}
+
+static MunitResult test_arena_indices(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  index_hash_t *hash = make_arena_index_hash(arena);
+  int i;
+  for (i=0; i<200000; i++)
+    munit_assert_int(hash_find_index(hash, i + 1, i % 7, -i, i), ==, i);
+  for (i=0; i<200000; i++)
+    munit_assert_int(hash_find_index(hash, i + 1, i % 7, -i, -1), ==, i);
+  munit_assert_int(arena_bytes(arena), <, 2 * hash->capacity * sizeof(index_entry_t));
   return MUNIT_OK;
 }
 
@@ -97,6 +116,19 @@ static MunitResult test_only_store_value_once(const MunitParameter params[], voi
   return MUNIT_OK;
 }
 
+static MunitResult test_destroy_hash(const MunitParameter params[], void *data)
+{
+  hash_t *hash = make_hash();
+  material_t *metal = make_material();
+  hash_find_material(hash, "metal", metal);
+  hash_find_material(hash, "metal", NULL);
+  destroy_hash(hash);
+  set_disolve(metal, 0.5f);
+  munit_assert_float(metal->disolve, ==, 0.5f);
+  destroy_material(metal);
+  return MUNIT_OK;
+}
+
 MunitTest test_hash[] = {
   {"/no_index"             , test_no_index             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/add_index"            , test_add_index            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
@@ -105,9 +137,11 @@ MunitTest test_hash[] = {
   {"/add_material"         , test_add_material         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/add_two_materials"    , test_add_two_materials    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/create_key_list"      , test_create_key_list      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/protect_key_from_gc"  , test_protect_key_from_gc  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/only_store_key_once"  , test_only_store_key_once  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/count_indices"        , test_count_indices        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/many_indices"         , test_many_indices         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/arena_indices"        , test_arena_indices        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/protect_value_from_gc", test_protect_value_from_gc, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/only_store_value_once", test_only_store_value_once, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_hash"         , test_destroy_hash         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {NULL                    , NULL                      , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
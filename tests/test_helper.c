@@ -2,7 +2,7 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <GL/gl.h>
-#include <gc.h>
+#include "fsim/memory.h"
 #include "test_helper.h"
 
 
@@ -26,9 +26,16 @@ static MunitResult test_image_not_found(const MunitParameter params[], void *dat
   return MUNIT_OK;
 }
 
+static MunitResult test_image_file_name(const MunitParameter params[], void *data)
+{
+  munit_assert_string_equal(read_image("colors.png")->file_name, "colors.png");
+  return MUNIT_OK;
+}
+
 MunitTest test_image[] = {
   {"/image_size"     , test_image_size     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/load_image_data", test_load_image_data, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/image_not_found", test_image_not_found, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/file_name"      , test_image_file_name, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {NULL              , NULL                , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
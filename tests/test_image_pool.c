@@ -0,0 +1,48 @@
+#include "fsim/image_pool.h"
+#include "test_image_pool.h"
+#include "test_helper.h"
+
+
+static MunitResult test_decode_image(const MunitParameter params[], void *data)
+{
+  image_t *image = wait_for_image(request_image("colors.png"));
+  munit_assert_not_null(image);
+  munit_assert_int(image->width, ==, 64);
+  return MUNIT_OK;
+}
+
+static MunitResult test_image_not_found(const MunitParameter params[], void *data)
+{
+  munit_assert_null(wait_for_image(request_image("nosuchfile.png")));
+  return MUNIT_OK;
+}
+
+static MunitResult test_many_images(const MunitParameter params[], void *data)
+{
+  image_request_t *request[16];
+  int i;
+  for (i=0; i<16; i++)
+    request[i] = request_image(i % 2 ? "colors.png" : "gray.png");
+  for (i=0; i<16; i++) {
+    image_t *image = wait_for_image(request[i]);
+    munit_assert_not_null(image);
+    munit_assert_string_equal(image->file_name, i % 2 ? "colors.png" : "gray.png");
+  };
+  return MUNIT_OK;
+}
+
+static MunitResult test_wait_twice(const MunitParameter params[], void *data)
+{
+  image_request_t *request = request_image("colors.png");
+  image_t *image = wait_for_image(request);
+  munit_assert_ptr(wait_for_image(request), ==, image);
+  return MUNIT_OK;
+}
+
+MunitTest test_image_pool[] = {
+  {"/decode_image"   , test_decode_image   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/image_not_found", test_image_not_found, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/many_images"    , test_many_images    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/wait_twice"     , test_wait_twice     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL              , NULL                , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -34,6 +34,38 @@ static MunitResult test_draw_triangle(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_draw_shared_vertices(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  object_t *object =
+    parse_string_core(context,
+                      "o draw square\n"
+                      "v  0.5  0.5 0\n"
+                      "v -0.5  0.5 0\n"
+                      "v -0.5 -0.5 0\n"
+                      "v  0.5 -0.5 0\n"
+                      "g upper\n"
+                      "f 1 2 3\n"
+                      "g lower\n"
+                      "f 1 3 4");
+  program_t *program = make_program("vertex-identity.glsl", "fragment-blue.glsl");
+  list_t *list = make_vertex_array_object_list(program, object);
+  glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+  glClearColor(0, 1, 0, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+  render(list);
+  glFinish();
+  unsigned char *pixels = read_pixels();
+  write_ppm("draw_shared_vertices.ppm", width, height, pixels);
+  munit_assert_int(pixels[0], ==,   0);
+  munit_assert_int(pixels[1], ==, 255);
+  munit_assert_int(pixels[(12 * 32 + 14 ) * 4 + 2], ==, 255);
+  munit_assert_int(pixels[(20 * 32 + 18 ) * 4 + 1], ==,   0);
+  munit_assert_int(pixels[(20 * 32 + 18 ) * 4 + 2], ==, 255);
+  return MUNIT_OK;
+}
+
 static MunitResult test_use_normal(const MunitParameter params[], void *data)
 {
   object_t *object =
@@ -61,6 +93,36 @@ static MunitResult test_use_normal(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_compact_normal(const MunitParameter params[], void *data)
+{
+  object_t *object =
+    parse_string("o use normals\n"
+                 "v  0.5  0.5 0\n"
+                 "v -0.5  0.5 0\n"
+                 "v -0.5 -0.5 0\n"
+                 "vn 0 0 1\n"
+                 "vn 0 1 0\n"
+                 "vn 1 0 0\n"
+                 "g triangle with normals\n"
+                 "f 1//1 2//2 3//3");
+  program_t *program = make_program("vertex-compact.glsl", "fragment-normal.glsl");
+  set_vertex_format(VERTEX_FORMAT_COMPACT);
+  list_t *list = make_vertex_array_object_list(program, object);
+  set_vertex_format(VERTEX_FORMAT_FLOAT);
+  glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+  glClearColor(0, 0, 0, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+  render(list);
+  glFinish();
+  unsigned char *pixels = read_pixels();
+  write_ppm("compact_normal.ppm", width, height, pixels);
+  munit_assert_int(pixels[( 5 * 32 + 8 ) * 4 + 0], >=, 192);
+  munit_assert_int(pixels[(14 * 32 + 8 ) * 4 + 0], < ,  64);
+  munit_assert_int(pixels[(14 * 32 + 8 ) * 4 + 1], >=, 192);
+  munit_assert_int(pixels[( 2 * 32 + 28) * 4 + 0], ==,   0);
+  return MUNIT_OK;
+}
+
 static MunitResult test_draw_texturized_square(const MunitParameter params[], void *data)
 {
   object_t *object =
@@ -320,7 +382,9 @@ static MunitResult test_overlay_textures(const MunitParameter params[], void *da
 
 MunitTest test_integration[] = {
   {"/draw_triangle"          , test_draw_triangle          , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/draw_shared_vertices"   , test_draw_shared_vertices   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/use_normal"             , test_use_normal             , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_normal"         , test_compact_normal         , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/draw_texturized_square" , test_draw_texturized_square , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/perspective_triangle"   , test_perspective_triangle   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/draw_two_textures"      , test_draw_two_textures      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
@@ -111,6 +111,166 @@ static MunitResult test_get_pointer(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_reserve(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  append_gluint(list, 42);
+  reserve_gluint(list, 5);
+  munit_assert_int(list->buffer_size, ==, 5 * sizeof(GLuint));
+  munit_assert_int(get_gluint(list)[0], ==, 42);
+  return MUNIT_OK;
+}
+
+static MunitResult test_keep_buffer(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  reserve_glfloat(list, 3);
+  void *element = list->element;
+  append_glfloat(list, 1.0f);
+  append_glfloat(list, 2.0f);
+  append_glfloat(list, 3.0f);
+  munit_assert_ptr(list->element, ==, element);
+  return MUNIT_OK;
+}
+
+static MunitResult test_reserve_less(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  reserve_gluint(list, 4);
+  reserve_gluint(list, 2);
+  munit_assert_int(list->buffer_size, ==, 4 * sizeof(GLuint));
+  return MUNIT_OK;
+}
+
+static MunitResult test_append_gluint3(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  append_gluint(list, 2);
+  append_gluint3(list, 3, 5, 7);
+  munit_assert_int(list->size, ==, 4);
+  munit_assert_int(list->buffer_size, ==, 4 * sizeof(GLuint));
+  munit_assert_int(get_gluint(list)[3], ==, 7);
+  return MUNIT_OK;
+}
+
+static MunitResult test_append_glfloat3(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  append_glfloat3(list, 1.5f, 2.5f, 3.5f);
+  munit_assert_int(list->size, ==, 3);
+  munit_assert_float(get_glfloat(list)[0], ==, 1.5f);
+  munit_assert_float(get_glfloat(list)[2], ==, 3.5f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_append_many(const MunitParameter params[], void *data)
+{
+  GLfloat values[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+  list_t *list = make_list();
+  append_glfloat(list, 0.5f);
+  append_glfloats(list, values, 5);
+  munit_assert_int(list->size, ==, 6);
+  munit_assert_int(list->buffer_size, ==, 6 * sizeof(GLfloat));
+  munit_assert_float(get_glfloat(list)[0], ==, 0.5f);
+  munit_assert_float(get_glfloat(list)[5], ==, 5.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_append_gluints(const MunitParameter params[], void *data)
+{
+  GLuint values[] = {3, 5, 7};
+  list_t *list = make_list();
+  append_gluints(list, values, 3);
+  append_gluints(list, values, 2);
+  munit_assert_int(list->size, ==, 5);
+  munit_assert_int(get_gluint(list)[4], ==, 5);
+  return MUNIT_OK;
+}
+
+static MunitResult test_keep_content(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  int i;
+  for (i=0; i<100000; i++)
+    append_gluint(list, i);
+  for (i=0; i<100000; i++)
+    munit_assert_int(get_gluint(list)[i], ==, i);
+  return MUNIT_OK;
+}
+
+static MunitResult test_reserve_pointer(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  reserve_pointer(list, 3);
+  munit_assert_int(list->buffer_size, ==, 3 * sizeof(void *));
+  munit_assert_int(list->size, ==, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shrink(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  reserve_glfloat(list, 100);
+  append_glfloat(list, 2.0f);
+  append_glfloat(list, 3.0f);
+  shrink_glfloat(list);
+  munit_assert_int(list->buffer_size, ==, 2 * sizeof(GLfloat));
+  munit_assert_float(get_glfloat(list)[1], ==, 3.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shrink_empty(const MunitParameter params[], void *data)
+{
+  list_t *list = make_list();
+  reserve_gluint(list, 10);
+  shrink_gluint(list);
+  munit_assert_int(list->buffer_size, ==, 0);
+  munit_assert_null(list->element);
+  append_gluint(list, 42);
+  munit_assert_int(get_gluint(list)[0], ==, 42);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shrink_pointer(const MunitParameter params[], void *data)
+{
+  char test = 42;
+  list_t *list = make_list();
+  append_pointer(list, &test);
+  append_pointer(list, &test);
+  append_pointer(list, &test);
+  shrink_pointer(list);
+  munit_assert_int(list->buffer_size, ==, 3 * sizeof(void *));
+  munit_assert_ptr(get_pointer(list)[2], ==, &test);
+  return MUNIT_OK;
+}
+
+static MunitResult test_arena_list(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  list_t *list = make_arena_list(arena);
+  int i;
+  for (i=0; i<100000; i++)
+    append_gluint(list, i);
+  munit_assert_int(get_gluint(list)[99999], ==, 99999);
+  munit_assert_int(arena_bytes(arena), >=, list->buffer_size);
+  list->size = 0;
+  shrink_gluint(list);
+  munit_assert_int(arena_bytes(arena), <, 1 << 17);
+  return MUNIT_OK;
+}
+
+static MunitResult test_destroy_list(const MunitParameter params[], void *data)
+{
+  arena_t *arena = make_arena();
+  list_t *list = make_arena_list(arena);
+  reserve_gluint(list, 100000);
+  destroy_list(list);
+  munit_assert_int(arena_bytes(arena), <, 1 << 17);
+  destroy_list(make_list());
+  destroy_arena(arena);
+  return MUNIT_OK;
+}
+
 MunitTest test_list[] = {
   {"/zero_size"      , test_zero_size      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/append_gluint"  , test_append_gluint  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
@@ -125,5 +285,19 @@ MunitTest test_list[] = {
   {"/get_glfloat"    , test_get_glfloat    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/append_pointer" , test_append_pointer , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {"/get_pointer"    , test_get_pointer    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/reserve"        , test_reserve        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/keep_buffer"    , test_keep_buffer    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/reserve_less"   , test_reserve_less   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/append_gluint3" , test_append_gluint3 , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/append_glfloat3", test_append_glfloat3, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/append_many"    , test_append_many    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/append_gluints" , test_append_gluints , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/keep_content"   , test_keep_content   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/reserve_pointer", test_reserve_pointer, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shrink"         , test_shrink         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shrink_empty"   , test_shrink_empty   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shrink_pointer" , test_shrink_pointer , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/arena_list"     , test_arena_list     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_list"   , test_destroy_list   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
   {NULL              , NULL                , NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}
 };
@@ -51,6 +51,35 @@ static MunitResult test_diffuse_texture_name(const MunitParameter params[], void
   return MUNIT_OK;
 }
 
+static MunitResult test_request_diffuse_texture(const MunitParameter params[], void *data)
+{
+  material_t *material = make_material();
+  upload_texture(request_diffuse_texture(material, "colors.png"));
+  munit_assert_ptr(material->diffuse_texture, !=, NULL);
+  munit_assert_string_equal(material->diffuse_texture->file_name, "colors.png");
+  return MUNIT_OK;
+}
+
+static MunitResult test_request_specular_texture(const MunitParameter params[], void *data)
+{
+  material_t *material = make_material();
+  upload_texture(request_specular_texture(material, "colors.png"));
+  munit_assert_ptr(material->specular_texture, !=, NULL);
+  munit_assert_ptr(material->diffuse_texture, ==, NULL);
+  return MUNIT_OK;
+}
+
+static MunitResult test_upload_once(const MunitParameter params[], void *data)
+{
+  material_t *material = make_material();
+  pending_texture_t *texture = request_diffuse_texture(material, "colors.png");
+  upload_texture(texture);
+  texture_t *uploaded = material->diffuse_texture;
+  upload_texture(texture);
+  munit_assert_ptr(material->diffuse_texture, ==, uploaded);
+  return MUNIT_OK;
+}
+
 static MunitResult test_set_specular_texture(const MunitParameter params[], void *data)
 {
   material_t *material = make_material();
@@ -131,19 +160,43 @@ static MunitResult test_set_disolve(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_destroy_material(const MunitParameter params[], void *data)
+{
+  material_t *material = make_material();
+  destroy_pending_texture(request_diffuse_texture(material, "colors.png"));
+  munit_assert_ptr(material->diffuse_texture, ==, NULL);
+  destroy_material(material);
+  return MUNIT_OK;
+}
+
+static MunitResult test_replace_texture(const MunitParameter params[], void *data)
+{
+  material_t *material = make_material();
+  upload_texture(request_diffuse_texture(material, "colors.png"));
+  upload_texture(request_diffuse_texture(material, "gray.png"));
+  munit_assert_string_equal(material->diffuse_texture->file_name, "gray.png");
+  destroy_material(material);
+  return MUNIT_OK;
+}
+
 MunitTest test_material[] = {
-  {"/default"               , test_default               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_diffuse_texture"   , test_set_diffuse_texture   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/texture_not_found"     , test_texture_not_found     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/diffuse_texture_name"  , test_diffuse_texture_name  , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_specular_texture"  , test_set_specular_texture  , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/specular_texture_name" , test_specular_texture_name , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_illumination_model", test_set_illumination_model, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_ambient"           , test_set_ambient           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_diffuse"           , test_set_diffuse           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_specular"          , test_set_specular          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_specular_exponent" , test_set_specular_exponent , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_optical_density"   , test_set_optical_density   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/set_disolve"           , test_set_disolve           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL                     , NULL                       , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+  {"/default"                 , test_default                 , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_diffuse_texture"     , test_set_diffuse_texture     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/texture_not_found"       , test_texture_not_found       , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/diffuse_texture_name"    , test_diffuse_texture_name    , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/request_diffuse_texture" , test_request_diffuse_texture , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/request_specular_texture", test_request_specular_texture, test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/upload_once"             , test_upload_once             , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_specular_texture"    , test_set_specular_texture    , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/specular_texture_name"   , test_specular_texture_name   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_illumination_model"  , test_set_illumination_model  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_ambient"             , test_set_ambient             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_diffuse"             , test_set_diffuse             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_specular"            , test_set_specular            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_specular_exponent"   , test_set_specular_exponent   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_optical_density"     , test_set_optical_density     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/set_disolve"             , test_set_disolve             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_material"        , test_destroy_material        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/replace_texture"         , test_replace_texture         , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                       , NULL                         , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fsim/number.h"
+#include "test_number.h"
+#include "test_helper.h"
+
+
+static void assert_same_as_strtod(const char *text)
+{
+  float value;
+  char *rest;
+  float expected = strtod(text, &rest);
+  const char *end = parse_float(text, text + strlen(text), &value);
+  if (rest == text) {
+    munit_assert_ptr(end, ==, NULL);
+    return;
+  };
+  munit_assert_ptr(end, ==, rest);
+  if (memcmp(&value, &expected, sizeof(float)))
+    munit_errorf("parsing \"%s\" returned %.9g instead of %.9g", text, value, expected);
+}
+
+static MunitResult test_integer(const MunitParameter params[], void *data)
+{
+  float value;
+  munit_assert_not_null(parse_float("42", "42" + 2, &value));
+  munit_assert_float(value, ==, 42.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_fraction(const MunitParameter params[], void *data)
+{
+  float value;
+  munit_assert_not_null(parse_float("-2.5", "-2.5" + 4, &value));
+  munit_assert_float(value, ==, -2.5f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_exponent(const MunitParameter params[], void *data)
+{
+  float value;
+  munit_assert_not_null(parse_float("1.5e+3", "1.5e+3" + 6, &value));
+  munit_assert_float(value, ==, 1500.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_end_of_number(const MunitParameter params[], void *data)
+{
+  const char *text = "3.25 7";
+  float value;
+  munit_assert_ptr(parse_float(text, text + 6, &value), ==, text + 4);
+  return MUNIT_OK;
+}
+
+static MunitResult test_respect_end(const MunitParameter params[], void *data)
+{
+  const char *text = "1234";
+  float value;
+  munit_assert_ptr(parse_float(text, text + 2, &value), ==, text + 2);
+  munit_assert_float(value, ==, 12.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_number(const MunitParameter params[], void *data)
+{
+  float value;
+  munit_assert_null(parse_float("-x", "-x" + 2, &value));
+  return MUNIT_OK;
+}
+
+static MunitResult test_special_cases(const MunitParameter params[], void *data)
+{
+  const char *cases[] = {"0", "-0", "+0.0", ".5", "5.", "-.25e-1", "1e", "1e+", "1e39", "1e-46", "3.4028235e38",
+                         "1.17549435e-38", "0.000000000000000000000000001", "9007199254740993",
+                         "123456789012345678901234567890", "0.30000000000000004", "1.00000005960464477539062",
+                         "0.0000000000000000000000000000000000000000000000000000000000000000000000000000012345", NULL};
+  int i;
+  for (i=0; cases[i]; i++)
+    assert_same_as_strtod(cases[i]);
+  return MUNIT_OK;
+}
+
+static MunitResult test_decimal_only(const MunitParameter params[], void *data)
+{
+  float value;
+  munit_assert_null(parse_float("inf", "inf" + 3, &value));
+  munit_assert_null(parse_float("-nan", "-nan" + 4, &value));
+  munit_assert_null(parse_float(".", "." + 1, &value));
+  munit_assert_null(parse_float("+", "+" + 1, &value));
+  munit_assert_ptr(parse_float("0x1p3", "0x1p3" + 5, &value), ==, "0x1p3" + 1);
+  munit_assert_float(value, ==, 0.0f);
+  munit_assert_ptr(parse_float("2E3", "2E3" + 3, &value), ==, "2E3" + 1);
+  munit_assert_float(value, ==, 2.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compare_with_strtod(const MunitParameter params[], void *data)
+{
+  const char *formats[] = {"%.*f", "%.*e", "%.*g", "%+.*e"};
+  char text[64];
+  int i;
+  for (i=0; i<100000; i++) {
+    double value = munit_rand_double() * pow(10.0, munit_rand_int_range(-12, 12));
+    if (munit_rand_uint32() & 1) value = -value;
+    snprintf(text, sizeof(text), formats[i % 4], munit_rand_int_range(0, 12), value);
+    assert_same_as_strtod(text);
+  };
+  return MUNIT_OK;
+}
+
+static MunitResult test_parse_int(const MunitParameter params[], void *data)
+{
+  int value;
+  munit_assert_ptr(parse_int("-123/", "-123/" + 5, &value), ==, "-123/" + 4);
+  munit_assert_int(value, ==, -123);
+  munit_assert_null(parse_int("/", "/" + 1, &value));
+  munit_assert_null(parse_int("-", "-" + 1, &value));
+  return MUNIT_OK;
+}
+
+static MunitResult test_int_range(const MunitParameter params[], void *data)
+{
+  int value;
+  munit_assert_not_null(parse_int("2147483647", "2147483647" + 10, &value));
+  munit_assert_int(value, ==, 2147483647);
+  munit_assert_not_null(parse_int("-2147483648", "-2147483648" + 11, &value));
+  munit_assert_int(value, ==, -2147483647 - 1);
+  munit_assert_null(parse_int("2147483648", "2147483648" + 10, &value));
+  munit_assert_null(parse_int("-2147483649", "-2147483649" + 11, &value));
+  munit_assert_null(parse_int("99999999999999999999999", "99999999999999999999999" + 23, &value));
+  return MUNIT_OK;
+}
+
+static MunitResult test_atof(const MunitParameter params[], void *data)
+{
+  munit_assert_float(fast_atof("-1.25"), ==, -1.25f);
+  munit_assert_float(fast_atof("."), ==, 0.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_atoi(const MunitParameter params[], void *data)
+{
+  munit_assert_int(fast_atoi("-17"), ==, -17);
+  munit_assert_int(fast_atoi(""), ==, 0);
+  return MUNIT_OK;
+}
+
+MunitTest test_number[] = {
+  {"/integer"            , test_integer            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/fraction"           , test_fraction           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/exponent"           , test_exponent           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/end_of_number"      , test_end_of_number      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/respect_end"        , test_respect_end        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_number"          , test_no_number          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/special_cases"      , test_special_cases      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/decimal_only"       , test_decimal_only       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compare_with_strtod", test_compare_with_strtod, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parse_int"          , test_parse_int          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/int_range"          , test_int_range          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/atof"               , test_atof               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/atoi"               , test_atoi               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                  , NULL                    , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -40,10 +40,97 @@ static MunitResult test_add_group(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_object_pool(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  munit_assert_int(object->pool->size, ==, 0);
+  vertex_pool_t *pool = object_pool(object, 5);
+  munit_assert_int(pool->stride, ==, 5);
+  munit_assert_ptr(object_pool(object, 5), ==, pool);
+  munit_assert_ptr(object_pool(object, 3), !=, pool);
+  munit_assert_int(object->pool->size, ==, 2);
+  return MUNIT_OK;
+}
+
+static MunitResult test_object_materials(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  material_t *material = make_material();
+  group_t *first = make_group("first", 3);
+  group_t *second = make_group("second", 3);
+  use_material(first, material);
+  use_material(second, material);
+  add_group(object, first);
+  add_group(object, second);
+  add_group(object, make_group("plain", 3));
+  list_t *materials = object_materials(object);
+  munit_assert_int(materials->size, ==, 1);
+  munit_assert_ptr(get_pointer(materials)[0], ==, material);
+  return MUNIT_OK;
+}
+
+static MunitResult test_destroy_object(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  material_t *material = make_material();
+  int i;
+  for (i=0; i<2; i++) {
+    group_t *group = make_group("group", 3);
+    use_material(group, material);
+    group->pool = object_pool(object, 3);
+    add_group(object, group);
+  };
+  destroy_object(object);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compact_object(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  vertex_pool_t *pool = object_pool(object, 6);
+  int i;
+  for (i=0; i<18; i++)
+    append_glfloat(pool->array, i);
+  group_t *group = make_group("test", 6);
+  group->pool = pool;
+  add_triangle(group, 2, 1, 0);
+  add_group(object, group);
+  compact_object(object);
+  munit_assert_int(pool->stride, ==, 3);
+  munit_assert_int(group->stride, ==, 3);
+  munit_assert_int(pool->array->size, ==, 9);
+  munit_assert_float(get_glfloat(pool->array)[3], ==, 6.0f);
+  munit_assert_float(group->bounds[5], ==, 14.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_release_object_data(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  vertex_pool_t *pool = object_pool(object, 3);
+  int i;
+  for (i=0; i<9; i++)
+    append_glfloat(pool->array, i);
+  group_t *group = make_group("test", 3);
+  group->pool = pool;
+  add_triangle(group, 0, 1, 2);
+  add_group(object, group);
+  release_object_data(object);
+  munit_assert_int(pool->array->size, ==, 0);
+  munit_assert_int(group->vertex_index->size, ==, 0);
+  munit_assert_float(group->bounds[3], ==, 6.0f);
+  return MUNIT_OK;
+}
+
 MunitTest test_object[] = {
-  {"/empty_object", test_empty_object, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/object_name" , test_object_name , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/copy_name"   , test_copy_name   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_group"   , test_add_group   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL           , NULL             , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+  {"/empty_object"       , test_empty_object       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/object_name"        , test_object_name        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/copy_name"          , test_copy_name          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/add_group"          , test_add_group          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/object_pool"        , test_object_pool        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/object_materials"   , test_object_materials   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_object"     , test_destroy_object     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_object"     , test_compact_object     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/release_object_data", test_release_object_data, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                  , NULL                    , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
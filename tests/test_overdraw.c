@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include "fsim/memory.h"
+#include "fsim/overdraw.h"
+#include "fsim/vertex_cache.h"
+#include "fsim/parser.h"
+#include "fsim/program.h"
+#include "fsim/vertex_array_object.h"
+#include "test_overdraw.h"
+#include "test_helper.h"
+
+
+#define SLICES 16
+#define STACKS 12
+#define SHELLS 3
+
+// Concentric spheres in one group with the innermost sphere first, which is the worst order for overdraw.
+static char *shells_text(void)
+{
+  char *result = GC_MALLOC_ATOMIC(SHELLS * ((SLICES + 1) * (STACKS + 1) * 48 + SLICES * STACKS * 48) + 16);
+  char *p = result;
+  p += sprintf(p, "g shells\n");
+  int shell;
+  for (shell=0; shell<SHELLS; shell++) {
+    float radius = 0.3f + 0.2f * shell;
+    int i;
+    int j;
+    for (j=0; j<=STACKS; j++)
+      for (i=0; i<=SLICES; i++) {
+        double theta = M_PI * j / STACKS;
+        double phi = 2 * M_PI * i / SLICES;
+        p += sprintf(p, "v %f %f %f\n", radius * sin(theta) * cos(phi), radius * cos(theta),
+                     radius * sin(theta) * sin(phi));
+      };
+    int base = shell * (SLICES + 1) * (STACKS + 1) + 1;
+    for (j=0; j<STACKS; j++)
+      for (i=0; i<SLICES; i++) {
+        int c = base + j * (SLICES + 1) + i;
+        p += sprintf(p, "f %d %d %d %d\n", c, c + 1, c + SLICES + 2, c + SLICES + 1);
+      };
+  };
+  return result;
+}
+
+static int compare_triangles(const void *a, const void *b)
+{
+  return memcmp(a, b, 3 * sizeof(GLuint));
+}
+
+// Rotate each triangle so that its smallest index comes first (which keeps the winding) and sort the triangles.
+static GLuint *canonical_triangles(const GLuint *index, int64_t n_indices)
+{
+  GLuint *result = GC_MALLOC_ATOMIC(n_indices * sizeof(GLuint));
+  int64_t i;
+  for (i=0; i<n_indices; i+=3) {
+    int first = 0;
+    int j;
+    for (j=1; j<3; j++)
+      if (index[i + j] < index[i + first])
+        first = j;
+    for (j=0; j<3; j++)
+      result[i + j] = index[i + (first + j) % 3];
+  };
+  qsort(result, n_indices / 3, 3 * sizeof(GLuint), compare_triangles);
+  return result;
+}
+
+static void *test_setup_overdraw(const MunitParameter params[], void *user_data)
+{
+  set_vertex_cache_optimization(0);
+  set_overdraw_optimization(0);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_overdraw(void *fixture)
+{
+  set_vertex_cache_optimization(0);
+  set_overdraw_optimization(0);
+  test_teardown_gc(fixture);
+}
+
+static void *test_setup_overdraw_gl(const MunitParameter params[], void *user_data)
+{
+  set_vertex_cache_optimization(0);
+  set_overdraw_optimization(0);
+  return test_setup_gl(params, user_data);
+}
+
+static void test_teardown_overdraw_gl(void *fixture)
+{
+  set_vertex_cache_optimization(0);
+  set_overdraw_optimization(0);
+  test_teardown_gl(fixture);
+}
+
+static MunitResult test_single_square(const MunitParameter params[], void *data)
+{
+  GLfloat array[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+  GLuint index[] = {0, 1, 2, 0, 2, 3};
+  overdraw_statistics_t statistics = overdraw_statistics(index, 6, array, 3);
+  munit_assert_int(statistics.covered, >, 0);
+  munit_assert_int(statistics.shaded, ==, statistics.covered);
+  munit_assert_double(statistics.overdraw, ==, 1.0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_layers(const MunitParameter params[], void *data)
+{
+  GLfloat array[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1, 0, 1, 1};
+  GLuint index[] = {0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7};
+  munit_assert_double(overdraw_statistics(index, 12, array, 3).overdraw, ==, 1.5);
+  return MUNIT_OK;
+}
+
+static MunitResult test_empty(const MunitParameter params[], void *data)
+{
+  overdraw_statistics_t statistics = overdraw_statistics(NULL, 0, NULL, 3);
+  munit_assert_int(statistics.covered, ==, 0);
+  munit_assert_double(statistics.overdraw, ==, 0.0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_same_triangles(const MunitParameter params[], void *data)
+{
+  set_vertex_cache_optimization(1);
+  group_t *group = get_pointer(parse_string(shells_text())->group)[0];
+  GLuint *index = get_gluint(group->vertex_index);
+  int64_t n_indices = group->vertex_index->size;
+  GLuint *expected = canonical_triangles(index, n_indices);
+  optimize_group_overdraw(group);
+  munit_assert_int(group->vertex_index->size, ==, n_indices);
+  munit_assert_memory_equal(n_indices * sizeof(GLuint), canonical_triangles(index, n_indices), expected);
+  return MUNIT_OK;
+}
+
+static MunitResult test_reduce_overdraw(const MunitParameter params[], void *data)
+{
+  set_vertex_cache_optimization(1);
+  object_t *object = parse_string(shells_text());
+  double before = object_overdraw_statistics(object).overdraw;
+  optimize_object_overdraw(object);
+  double after = object_overdraw_statistics(object).overdraw;
+  munit_assert_double(before, >, 2.0);
+  munit_assert_double(after, <, before - 0.5);
+  return MUNIT_OK;
+}
+
+static MunitResult test_cache_locality(const MunitParameter params[], void *data)
+{
+  set_vertex_cache_optimization(1);
+  group_t *group = get_pointer(parse_string(shells_text())->group)[0];
+  GLuint *index = get_gluint(group->vertex_index);
+  int64_t n_indices = group->vertex_index->size;
+  double before = vertex_cache_statistics(index, n_indices, VERTEX_CACHE_SIZE).acmr;
+  optimize_group_overdraw(group);
+  munit_assert_double(vertex_cache_statistics(index, n_indices, VERTEX_CACHE_SIZE).acmr, <=,
+                      before * OVERDRAW_THRESHOLD + 0.05);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parser(const MunitParameter params[], void *data)
+{
+  char *text = shells_text();
+  set_vertex_cache_optimization(1);
+  double before = object_overdraw_statistics(parse_string(text)).overdraw;
+  set_overdraw_optimization(1);
+  munit_assert_double(object_overdraw_statistics(parse_string(text)).overdraw, <, before);
+  return MUNIT_OK;
+}
+
+// Render into a framebuffer with depth buffer and count the fragments passing the depth test.
+static GLuint render_samples(const char *text, unsigned char *pixels)
+{
+  GLuint framebuffer;
+  GLuint renderbuffer[2];
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glGenRenderbuffers(2, renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 64, 64);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer[0]);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 64, 64);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer[1]);
+  munit_assert_int(glCheckFramebufferStatus(GL_FRAMEBUFFER), ==, GL_FRAMEBUFFER_COMPLETE);
+  program_t *program = make_program("vertex-identity.glsl", "fragment-blue.glsl");
+  list_t *list = make_vertex_array_object_list(program, parse_string(text));
+  glViewport(0, 0, 64, 64);
+  glEnable(GL_DEPTH_TEST);
+  glClearColor(0, 1, 0, 1);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  GLuint query;
+  glGenQueries(1, &query);
+  glBeginQuery(GL_SAMPLES_PASSED, query);
+  render(list);
+  glEndQuery(GL_SAMPLES_PASSED);
+  GLuint result;
+  glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+  glReadPixels(0, 0, 64, 64, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glDeleteQueries(1, &query);
+  destroy_vertex_array_object_list(list);
+  glDisable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteRenderbuffers(2, renderbuffer);
+  glDeleteFramebuffers(1, &framebuffer);
+  return result;
+}
+
+static MunitResult test_render(const MunitParameter params[], void *data)
+{
+  char *text = shells_text();
+  unsigned char *expected = GC_MALLOC_ATOMIC(64 * 64 * 4);
+  unsigned char *pixels = GC_MALLOC_ATOMIC(64 * 64 * 4);
+  set_vertex_cache_optimization(1);
+  GLuint before = render_samples(text, expected);
+  set_overdraw_optimization(1);
+  GLuint after = render_samples(text, pixels);
+  munit_assert_int(after, <, before);
+  munit_assert_memory_equal(64 * 64 * 4, pixels, expected);
+  return MUNIT_OK;
+}
+
+MunitTest test_overdraw[] = {
+  {"/single_square"  , test_single_square  , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/layers"         , test_layers         , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/empty"          , test_empty          , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/same_triangles" , test_same_triangles , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/reduce_overdraw", test_reduce_overdraw, test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/cache_locality" , test_cache_locality , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parser"         , test_parser         , test_setup_overdraw   , test_teardown_overdraw   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/render"         , test_render         , test_setup_overdraw_gl, test_teardown_overdraw_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL              , NULL                , NULL                  , NULL                     , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -1,16 +1,52 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define GC_THREADS
+#include "fsim/memory.h"
+#include <pthread.h>
 #include "fsim/parser.h"
 #include "fsim/list.h"
 #include "fsim/hash.h"
+#include "fsim/material_library.h"
 #include "test_helper.h"
 
 
-extern object_t *parse_string_core(const char *text);
-extern object_t *parse_result;
-extern hash_t *parse_materials;
-extern list_t *parse_vertex;
-extern list_t *parse_uv;
-extern list_t *parse_normal;
+static char *backends[] = {"mmap", "parallel", "flex", NULL};
 
+static MunitParameterEnum parser_params[] = {
+  {"backend", backends},
+  {NULL     , NULL    }
+};
+
+static void *test_setup_parser(const MunitParameter params[], void *user_data)
+{
+  const char *backend = munit_parameters_get(params, "backend");
+  set_parser_backend(backend && !strcmp(backend, "flex") ? PARSER_FLEX : PARSER_MMAP);
+  set_parser_threads(backend && !strcmp(backend, "parallel") ? 4 : 1);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_parser(void *fixture)
+{
+  set_parser_backend(PARSER_MMAP);
+  set_parser_threads(1);
+  test_teardown_gc(fixture);
+}
+
+static void *test_setup_parser_gl(const MunitParameter params[], void *user_data)
+{
+  test_setup_parser(params, user_data);
+  return test_setup_gl(params, user_data);
+}
+
+static void test_teardown_parser_gl(void *fixture)
+{
+  set_parser_backend(PARSER_MMAP);
+  set_parser_threads(1);
+  test_teardown_gl(fixture);
+}
 
 static MunitResult test_empty(const MunitParameter params[], void *data)
 {
@@ -55,6 +91,21 @@ static MunitResult test_error(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_non_decimal_number(const MunitParameter params[], void *data)
+{
+  munit_assert_ptr(parse_string("o test\nv inf 0 0"), ==, NULL);
+  munit_assert_ptr(parse_string("o test\nv 0x1p3 0 0"), ==, NULL);
+  munit_assert_ptr(parse_string("o test\nv 1E3 0 0"), ==, NULL);
+  munit_assert_ptr(parse_string("o test\nv . 0 0"), ==, NULL);
+  return MUNIT_OK;
+}
+
+static MunitResult test_index_out_of_range(const MunitParameter params[], void *data)
+{
+  munit_assert_ptr(parse_string("o test\nv 0 0 0\ng a\nf 1 1 4294967297"), ==, NULL);
+  return MUNIT_OK;
+}
+
 static MunitResult test_read_file(const MunitParameter params[], void *data)
 {
   munit_assert_string_equal(parse_file("name.obj")->name, "inafile");
@@ -87,45 +138,51 @@ static MunitResult test_no_newline_in_name(const MunitParameter params[], void *
 
 static MunitResult test_no_vertices(const MunitParameter params[], void *data)
 {
-  parse_string_core("");
-  munit_assert_int(parse_vertex->size, ==, 0);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "");
+  munit_assert_int(context->vertex->size, ==, 0);
   return MUNIT_OK;
 }
 
 static MunitResult test_read_vertex(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 10 2.5 -3.25");
-  munit_assert_int(parse_vertex->size, ==, 3);
-  munit_assert_float(get_glfloat(parse_vertex)[0], ==, 10.0f);
-  munit_assert_float(get_glfloat(parse_vertex)[1], ==,  2.5f);
-  munit_assert_float(get_glfloat(parse_vertex)[2], ==, -3.25f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 10 2.5 -3.25");
+  munit_assert_int(context->vertex->size, ==, 3);
+  munit_assert_float(get_glfloat(context->vertex)[0], ==, 10.0f);
+  munit_assert_float(get_glfloat(context->vertex)[1], ==,  2.5f);
+  munit_assert_float(get_glfloat(context->vertex)[2], ==, -3.25f);
   return MUNIT_OK;
 }
 
 static MunitResult test_two_vertices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 10 2.5 -3.25\nv .5 +1 -.25");
-  munit_assert_int(parse_vertex->size, ==, 6);
-  munit_assert_float(get_glfloat(parse_vertex)[3], ==,  0.5f);
-  munit_assert_float(get_glfloat(parse_vertex)[4], ==,  1.0f);
-  munit_assert_float(get_glfloat(parse_vertex)[5], ==, -0.25f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 10 2.5 -3.25\nv .5 +1 -.25");
+  munit_assert_int(context->vertex->size, ==, 6);
+  munit_assert_float(get_glfloat(context->vertex)[3], ==,  0.5f);
+  munit_assert_float(get_glfloat(context->vertex)[4], ==,  1.0f);
+  munit_assert_float(get_glfloat(context->vertex)[5], ==, -0.25f);
   return MUNIT_OK;
 }
 
 static MunitResult test_exponent(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 1e+1 2.5e-1 -3.0e2");
-  munit_assert_int(parse_vertex->size, ==, 3);
-  munit_assert_float(get_glfloat(parse_vertex)[0], ==,  10.0f);
-  munit_assert_float(get_glfloat(parse_vertex)[1], ==,   0.25f);
-  munit_assert_float(get_glfloat(parse_vertex)[2], ==, -300.0f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 1e+1 2.5e-1 -3.0e2");
+  munit_assert_int(context->vertex->size, ==, 3);
+  munit_assert_float(get_glfloat(context->vertex)[0], ==,  10.0f);
+  munit_assert_float(get_glfloat(context->vertex)[1], ==,   0.25f);
+  munit_assert_float(get_glfloat(context->vertex)[2], ==, -300.0f);
   return MUNIT_OK;
 }
 
 static MunitResult test_cleanup_vertices(const MunitParameter params[], void *data)
 {
-  parse_string("o test\nv 10 2.5 3.25");
-  munit_assert_ptr(parse_vertex, ==, NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 10 2.5 3.25");
+  parser_cleanup(context);
+  munit_assert_ptr(context->vertex, ==, NULL);
   return MUNIT_OK;
 }
 
@@ -150,8 +207,9 @@ static MunitResult test_group_name(const MunitParameter params[], void *data)
 
 static MunitResult test_two_groups(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\ng group\ng group");
-  munit_assert_int(parse_result->group->size, ==, 2);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\ng group\ng group");
+  munit_assert_int(context->result->group->size, ==, 2);
   return MUNIT_OK;
 }
 
@@ -163,24 +221,27 @@ static MunitResult test_default_object(const MunitParameter params[], void *data
 
 static MunitResult test_facet(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->vertex_index->size, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_vertex_stride(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->stride, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -189,16 +250,18 @@ static MunitResult test_indices(const MunitParameter params[], void *data)
 
 static MunitResult test_coord_count(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 9);
   return MUNIT_OK;
 }
 
 static MunitResult test_copy_coords(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 2 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 3.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==, 5.0f);
@@ -213,8 +276,9 @@ static MunitResult test_copy_coords(const MunitParameter params[], void *data)
 
 static MunitResult test_shuffle_coords(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 3.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==, 5.0f);
@@ -229,8 +293,9 @@ static MunitResult test_shuffle_coords(const MunitParameter params[], void *data
 
 static MunitResult test_relative_index(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf -3 -2 -1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf -3 -2 -1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 3.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==, 5.0f);
@@ -245,8 +310,9 @@ static MunitResult test_relative_index(const MunitParameter params[], void *data
 
 static MunitResult test_generate_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -255,24 +321,27 @@ static MunitResult test_generate_indices(const MunitParameter params[], void *da
 
 static MunitResult test_reset_vertex_cache(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2\ng group\nf 3 2 1");
-  group_t *group = get_pointer(parse_result->group)[1];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\ng group\nf 1 3 2\ng group\nf 3 2 1");
+  group_t *group = get_pointer(context->result->group)[1];
   munit_assert_int(group->array->size, ==, 9);
   return MUNIT_OK;
 }
 
 static MunitResult test_two_facets(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3\nf 1 4 3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3\nf 1 4 3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->vertex_index->size, ==, 6);
   return MUNIT_OK;
 }
 
 static MunitResult test_reuse_vertices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3\nf 4 3 1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3\nf 4 3 1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -284,8 +353,9 @@ static MunitResult test_reuse_vertices(const MunitParameter params[], void *data
 
 static MunitResult test_square_facet(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3 4");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 3 5\nv 3 5 7\nv 7 5 3\nv 9 7 5\ng group\nf 1 2 3 4");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -311,56 +381,64 @@ static MunitResult test_add_group(const MunitParameter params[], void *data)
 
 static MunitResult test_no_texcoord(const MunitParameter params[], void *data)
 {
-  parse_string_core("");
-  munit_assert_int(parse_uv->size, ==, 0);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "");
+  munit_assert_int(context->uv->size, ==, 0);
   return MUNIT_OK;
 }
 
 static MunitResult test_cleanup_texcoords(const MunitParameter params[], void *data)
 {
-  parse_string("o test");
-  munit_assert_ptr(parse_uv, ==, NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test");
+  parser_cleanup(context);
+  munit_assert_ptr(context->uv, ==, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_read_texcoord(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nvt 0.5 0.25");
-  munit_assert_int(parse_uv->size, ==, 2);
-  munit_assert_float(get_glfloat(parse_uv)[0], ==, 0.50f);
-  munit_assert_float(get_glfloat(parse_uv)[1], ==, 0.25f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nvt 0.5 0.25");
+  munit_assert_int(context->uv->size, ==, 2);
+  munit_assert_float(get_glfloat(context->uv)[0], ==, 0.50f);
+  munit_assert_float(get_glfloat(context->uv)[1], ==, 0.25f);
   return MUNIT_OK;
 }
 
 static MunitResult test_two_texcoords(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nvt 0.5 0.25\nvt 0.75 1.0");
-  munit_assert_int(parse_uv->size, ==, 4);
-  munit_assert_float(get_glfloat(parse_uv)[2], ==, 0.75f);
-  munit_assert_float(get_glfloat(parse_uv)[3], ==, 1.00f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nvt 0.5 0.25\nvt 0.75 1.0");
+  munit_assert_int(context->uv->size, ==, 4);
+  munit_assert_float(get_glfloat(context->uv)[2], ==, 0.75f);
+  munit_assert_float(get_glfloat(context->uv)[3], ==, 1.00f);
   return MUNIT_OK;
 }
 
 static MunitResult test_uv_facet(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->vertex_index->size, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_vertex_and_uv_stride(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->stride, ==, 5);
   return MUNIT_OK;
 }
 
 static MunitResult test_uv_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -369,16 +447,18 @@ static MunitResult test_uv_indices(const MunitParameter params[], void *data)
 
 static MunitResult test_uv_added(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 15);
   return MUNIT_OK;
 }
 
 static MunitResult test_copy_uv(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/2 3/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==,-1.0f);
@@ -394,8 +474,9 @@ static MunitResult test_copy_uv(const MunitParameter params[], void *data)
 
 static MunitResult test_relative_uv_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf -3/-3 -2/-2 -1/-1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf -3/-3 -2/-2 -1/-1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[3], ==, 0.0f);
   munit_assert_float(get_glfloat(group->array)[4], ==, 0.0f);
   munit_assert_float(get_glfloat(group->array)[8], ==, 0.0f);
@@ -405,8 +486,9 @@ static MunitResult test_relative_uv_indices(const MunitParameter params[], void
 
 static MunitResult test_different_uv_index(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/2 2/3 3/1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/2 2/3 3/1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==,-1.0f);
@@ -417,64 +499,73 @@ static MunitResult test_different_uv_index(const MunitParameter params[], void *
 
 static MunitResult test_reuse_uv(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 1/1 2/2");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 1/1 2/2");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 10);
   return MUNIT_OK;
 }
 
 static MunitResult test_uv_in_hash_key(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 1/2 1/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 1/2 1/3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 15);
   return MUNIT_OK;
 }
 
 static MunitResult test_vertex_and_uv_key(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/1 3/1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvt 0 0\nvt 0 1\nvt 1 0\ng group\nf 1/1 2/1 3/1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 15);
   return MUNIT_OK;
 }
 
 static MunitResult test_no_normal(const MunitParameter params[], void *data)
 {
-  parse_string_core("");
-  munit_assert_int(parse_normal->size, ==, 0);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "");
+  munit_assert_int(context->normal->size, ==, 0);
   return MUNIT_OK;
 }
 
 static MunitResult test_cleanup_normals(const MunitParameter params[], void *data)
 {
-  parse_string("");
-  munit_assert_ptr(parse_normal, ==, NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "");
+  parser_cleanup(context);
+  munit_assert_ptr(context->normal, ==, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_read_normal(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nvn 0.36 0.48 0.8");
-  munit_assert_int(parse_normal->size, ==, 3);
-  munit_assert_float(get_glfloat(parse_normal)[0], ==, 0.36f);
-  munit_assert_float(get_glfloat(parse_normal)[1], ==, 0.48f);
-  munit_assert_float(get_glfloat(parse_normal)[2], ==, 0.80f);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nvn 0.36 0.48 0.8");
+  munit_assert_int(context->normal->size, ==, 3);
+  munit_assert_float(get_glfloat(context->normal)[0], ==, 0.36f);
+  munit_assert_float(get_glfloat(context->normal)[1], ==, 0.48f);
+  munit_assert_float(get_glfloat(context->normal)[2], ==, 0.80f);
   return MUNIT_OK;
 }
 
 static MunitResult test_normal_facet(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->vertex_index->size, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_normal_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -483,16 +574,18 @@ static MunitResult test_normal_indices(const MunitParameter params[], void *data
 
 static MunitResult test_normals_added(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 18);
   return MUNIT_OK;
 }
 
 static MunitResult test_copy_normal(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//2 3//3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[ 0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[ 1], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[ 2], ==,-1.0f);
@@ -510,8 +603,9 @@ static MunitResult test_copy_normal(const MunitParameter params[], void *data)
 
 static MunitResult test_relative_normal_index(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf -3//-3 -2//-2 -1//-1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf -3//-3 -2//-2 -1//-1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[ 3], ==, 1.0f);
   munit_assert_float(get_glfloat(group->array)[ 4], ==, 0.0f);
   munit_assert_float(get_glfloat(group->array)[ 5], ==, 0.0f);
@@ -523,8 +617,9 @@ static MunitResult test_relative_normal_index(const MunitParameter params[], voi
 
 static MunitResult test_different_normal_index(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//2 2//3 3//1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//2 2//3 3//1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==,-1.0f);
@@ -536,44 +631,49 @@ static MunitResult test_different_normal_index(const MunitParameter params[], vo
 
 static MunitResult test_reuse_normal(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 1//1 2//2");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 1//1 2//2");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 12);
   return MUNIT_OK;
 }
 
 static MunitResult test_normal_in_hash_key(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 1//2 1//3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 1//2 1//3");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 18);
   return MUNIT_OK;
 }
 
 static MunitResult test_vertex_and_normal_key(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//1 3//1");
-  group_t *group = get_pointer(parse_result->group)[0];
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nv 2 2 -1\nv 2 3 -1\nv 3 2 -1\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\ng group\nf 1//1 2//1 3//1");
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 18);
   return MUNIT_OK;
 }
 
 static MunitResult test_full_facet(const MunitParameter params[], void *data)
 {
-  parse_string_core(
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context,
       "o test\nv 2 2 0\nv 2 3 0\nv 3 2 0\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\nvt 0 0\nvt 0 1\nvt 1 0\n"
       "g group\nf 1/1/1 2/2/2 3/3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->vertex_index->size, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_full_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core(
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context,
       "o test\nv 2 2 0\nv 2 3 0\nv 3 2 0\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\nvt 0 0\nvt 0 1\nvt 1 0\n"
       "g group\nf 1/1/1 2/2/2 3/3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(get_gluint(group->vertex_index)[0], ==, 0);
   munit_assert_int(get_gluint(group->vertex_index)[1], ==, 1);
   munit_assert_int(get_gluint(group->vertex_index)[2], ==, 2);
@@ -582,20 +682,22 @@ static MunitResult test_full_indices(const MunitParameter params[], void *data)
 
 static MunitResult test_all_added(const MunitParameter params[], void *data)
 {
-  parse_string_core(
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context,
       "o test\nv 2 2 0\nv 2 3 0\nv 3 2 0\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\nvt 0 0\nvt 0 1\nvt 1 0\n"
       "g group\nf 1/1/1 2/2/2 3/3/3");
-  group_t *group = get_pointer(parse_result->group)[0];
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_int(group->array->size, ==, 24);
   return MUNIT_OK;
 }
 
 static MunitResult test_different_indices(const MunitParameter params[], void *data)
 {
-  parse_string_core(
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context,
       "o test\nv 2 2 0\nv 2 3 0\nv 3 2 0\nvn 1 0 0\nvn 0 1 0\nvn 0 0 1\nvt 0 0\nvt 0 1\nvt 1 0\n"
       "g group\nf 1/2/3 2/3/1 3/1/2");
-  group_t *group = get_pointer(parse_result->group)[0];
+  group_t *group = get_pointer(context->result->group)[0];
   munit_assert_float(get_glfloat(group->array)[0], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[1], ==, 2.0f);
   munit_assert_float(get_glfloat(group->array)[2], ==, 0.0f);
@@ -615,8 +717,9 @@ static MunitResult test_material_filename(const MunitParameter params[], void *d
 
 static MunitResult test_material_name(const MunitParameter params[], void *data)
 {
-  parse_string_core("mtllib test.mtl\no test");
-  munit_assert_ptr(hash_find_material(parse_materials, "testmaterial", NULL), !=, NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "mtllib test.mtl\no test");
+  munit_assert_ptr(hash_find_material(context->materials, "testmaterial", NULL), !=, NULL);
   return MUNIT_OK;
 }
 
@@ -628,32 +731,36 @@ static MunitResult test_file_not_found(const MunitParameter params[], void *data
 
 static MunitResult test_continue_after_include(const MunitParameter params[], void *data)
 {
-  parse_string_core("mtllib test.mtl\no test\nv 1 2 3");
-  munit_assert_int(parse_vertex->size, ==, 3);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "mtllib test.mtl\no test\nv 1 2 3");
+  munit_assert_int(context->vertex->size, ==, 3);
   return MUNIT_OK;
 }
 
 static MunitResult test_material(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl stone\no test");
-  material_t *stone = hash_find_material(parse_materials, "stone", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl stone\no test");
+  material_t *stone = hash_find_material(context->materials, "stone", NULL);
   munit_assert_ptr(stone, !=, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_late_material(const MunitParameter params[], void *data)
 {
-  parse_string_core("o test\nnewmtl stone");
-  material_t *stone = hash_find_material(parse_materials, "stone", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "o test\nnewmtl stone");
+  material_t *stone = hash_find_material(context->materials, "stone", NULL);
   munit_assert_ptr(stone, !=, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_two_materials(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl stone\nnewmtl water\no test");
-  material_t *stone = hash_find_material(parse_materials, "stone", NULL);
-  material_t *water = hash_find_material(parse_materials, "water", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl stone\nnewmtl water\no test");
+  material_t *stone = hash_find_material(context->materials, "stone", NULL);
+  material_t *water = hash_find_material(context->materials, "water", NULL);
   munit_assert_ptr(stone, !=, NULL);
   munit_assert_ptr(water, !=, NULL);
   return MUNIT_OK;
@@ -661,16 +768,18 @@ static MunitResult test_two_materials(const MunitParameter params[], void *data)
 
 static MunitResult test_illumination_model(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nillum 6\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nillum 6\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_int(material->illumination, ==, 6);
   return MUNIT_OK;
 }
 
 static MunitResult test_ambient(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nKa 0.25 0.5 0.75\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nKa 0.25 0.5 0.75\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->ambient[0], ==, 0.25f);
   munit_assert_float(material->ambient[1], ==, 0.5f);
   munit_assert_float(material->ambient[2], ==, 0.75f);
@@ -695,32 +804,36 @@ static MunitResult test_reuse_material(const MunitParameter params[], void *data
 
 static MunitResult test_read_texture(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nmap_Kd colors.png\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nmap_Kd colors.png\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_ptr(material->diffuse_texture, !=, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_texture_not_found(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nmap_Kd nosuchfile.png\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nmap_Kd nosuchfile.png\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_ptr(material->diffuse_texture, ==, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_specular_texture(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nmap_Ks colors.png\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nmap_Ks colors.png\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_ptr(material->specular_texture, !=, NULL);
   return MUNIT_OK;
 }
 
 static MunitResult test_diffuse(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nKd 0.25 0.5 0.75\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nKd 0.25 0.5 0.75\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->diffuse[0], ==, 0.25f);
   munit_assert_float(material->diffuse[1], ==, 0.5f);
   munit_assert_float(material->diffuse[2], ==, 0.75f);
@@ -729,8 +842,9 @@ static MunitResult test_diffuse(const MunitParameter params[], void *data)
 
 static MunitResult test_specular(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nKs 0.25 0.5 0.75\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nKs 0.25 0.5 0.75\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->specular[0], ==, 0.25f);
   munit_assert_float(material->specular[1], ==, 0.5f);
   munit_assert_float(material->specular[2], ==, 0.75f);
@@ -739,24 +853,27 @@ static MunitResult test_specular(const MunitParameter params[], void *data)
 
 static MunitResult test_specular_exponent(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nNs 6.5\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nNs 6.5\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->specular_exponent, ==, 6.5f);
   return MUNIT_OK;
 }
 
 static MunitResult test_optical_density(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nNi 1.5\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nNi 1.5\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->optical_density, ==, 1.5f);
   return MUNIT_OK;
 }
 
 static MunitResult test_disolve(const MunitParameter params[], void *data)
 {
-  parse_string_core("newmtl test\nd 0.5\no test");
-  material_t *material = hash_find_material(parse_materials, "test", NULL);
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "newmtl test\nd 0.5\no test");
+  material_t *material = hash_find_material(context->materials, "test", NULL);
   munit_assert_float(material->disolve, ==, 0.5f);
   return MUNIT_OK;
 }
@@ -775,93 +892,382 @@ static MunitResult test_reset_parser(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+typedef struct {
+  list_t *name;
+  list_t *n_indices;
+} collected_t;
+
+static void collect_group(group_t *group, void *data)
+{
+  collected_t *collected = data;
+  append_pointer(collected->name, group->name);
+  append_gluint(collected->n_indices, group->vertex_index->size);
+}
+
+static collected_t *group_callback(parser_context_t *context)
+{
+  collected_t *result = GC_MALLOC(sizeof(collected_t));
+  result->name = make_list();
+  result->n_indices = make_list();
+  context->group_callback = collect_group;
+  context->callback_data = result;
+  return result;
+}
+
+static MunitResult test_group_callback(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  collected_t *collected = group_callback(context);
+  parse_string_core(context, "o test\nv 1 2 3\ng first\nf 1 1 1\nf 1 1 1\ng second\nf 1 1 1\n");
+  munit_assert_int(collected->name->size, ==, 2);
+  munit_assert_string_equal(get_pointer(collected->name)[0], "first");
+  munit_assert_string_equal(get_pointer(collected->name)[1], "second");
+  munit_assert_int(get_gluint(collected->n_indices)[0], ==, 6);
+  munit_assert_int(get_gluint(collected->n_indices)[1], ==, 3);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_group_callback(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  collected_t *collected = group_callback(context);
+  parse_string_core(context, "o test\nv 1 2 3\n");
+  munit_assert_int(collected->name->size, ==, 0);
+  return MUNIT_OK;
+}
+
+#define N_CONCURRENT 4
+
+static char *concurrent_source(int k)
+{
+  char *result = GC_MALLOC_ATOMIC(256);
+  snprintf(result, 256, "o test\nv %d 2 3\nv 4 %d 6\nv 7 8 %d\nv 1 1 1\ng group\nf 1 2 3 4\nf 4 3 2\n", k, k + 1, k + 2);
+  return result;
+}
+
+static void *parse_concurrent(void *source)
+{
+  parser_context_t *context = make_parser_context();
+  object_t *result = parse_string_core(context, source);
+  parser_cleanup(context);
+  return result;
+}
+
+static MunitResult test_concurrent_parsers(const MunitParameter params[], void *data)
+{
+  pthread_t thread[N_CONCURRENT];
+  char *source[N_CONCURRENT];
+  int i;
+  for (i=0; i<N_CONCURRENT; i++) {
+    source[i] = concurrent_source(i);
+    pthread_create(&thread[i], NULL, parse_concurrent, source[i]);
+  };
+  for (i=0; i<N_CONCURRENT; i++) {
+    object_t *object;
+    pthread_join(thread[i], (void **)&object);
+    munit_assert_ptr(object, !=, NULL);
+    object_t *expected = parse_string(source[i]);
+    group_t *group = get_pointer(object->group)[0];
+    group_t *reference = get_pointer(expected->group)[0];
+    munit_assert_int(group->array->size, ==, reference->array->size);
+    munit_assert_int(group->vertex_index->size, ==, reference->vertex_index->size);
+    munit_assert_memory_equal(group->array->size * sizeof(GLfloat), group->array->element, reference->array->element);
+    munit_assert_memory_equal(group->vertex_index->size * sizeof(GLuint), group->vertex_index->element,
+                              reference->vertex_index->element);
+  };
+  return MUNIT_OK;
+}
+
+static MunitResult test_release_temporaries(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  object_t *object = parse_string_core(context, "o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\ng first\nf 1 2 3\n");
+  munit_assert_int(arena_bytes(context->arena), >, 0);
+  parser_cleanup(context);
+  munit_assert_int(arena_bytes(context->arena), ==, 0);
+  group_t *group = get_pointer(object->group)[0];
+  munit_assert_int(group->array->size, ==, 9);
+  munit_assert_float(get_glfloat(group->array)[8], ==, 7.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shared_vertices(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  object_t *object = parse_string_core(context, "o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nv 5 7 11\n"
+                                                "g first\nf 1 2 3\ng second\nf 3 2 4\n");
+  munit_assert_int(object->pool->size, ==, 1);
+  vertex_pool_t *pool = get_pointer(object->pool)[0];
+  munit_assert_int(pool->stride, ==, 3);
+  munit_assert_int(pool->array->size, ==, 12);
+  group_t *first = get_pointer(object->group)[0];
+  group_t *second = get_pointer(object->group)[1];
+  munit_assert_ptr(first->pool, ==, pool);
+  munit_assert_ptr(second->pool, ==, pool);
+  munit_assert_int(first->array->size, ==, 0);
+  munit_assert_int(second->vertex_index->size, ==, 3);
+  munit_assert_int(get_gluint(second->vertex_index)[0], ==, 2);
+  munit_assert_int(get_gluint(second->vertex_index)[1], ==, 1);
+  munit_assert_int(get_gluint(second->vertex_index)[2], ==, 3);
+  munit_assert_float(get_glfloat(pool->array)[9], ==, 5.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_pool_per_stride(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  object_t *object = parse_string_core(context, "o test\nv 1 2 3\nvt 0 1\nvn 0 0 1\n"
+                                                "g first\nf 1 1 1\ng second\nf 1/1 1/1 1/1\ng third\nf 1 1 1\n");
+  munit_assert_int(object->pool->size, ==, 2);
+  group_t *first = get_pointer(object->group)[0];
+  group_t *second = get_pointer(object->group)[1];
+  group_t *third = get_pointer(object->group)[2];
+  munit_assert_int(first->pool->stride, ==, 3);
+  munit_assert_int(second->pool->stride, ==, 5);
+  munit_assert_ptr(third->pool, ==, first->pool);
+  munit_assert_int(first->pool->array->size, ==, 3);
+  return MUNIT_OK;
+}
+
+static MunitResult test_stream_shared_vertices(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  context->shared_vertices = 1;
+  collected_t *collected = group_callback(context);
+  object_t *object = parse_string_core(context, "o test\nv 1 2 3\nv 2 3 5\nv 3 5 7\nv 5 7 11\n"
+                                                "g first\nf 1 2 3\ng second\nf 3 2 4\n");
+  munit_assert_int(collected->name->size, ==, 2);
+  munit_assert_int(object->pool->size, ==, 0);
+  group_t *first = get_pointer(object->group)[0];
+  group_t *second = get_pointer(object->group)[1];
+  munit_assert_null(first->pool);
+  munit_assert_null(second->pool);
+  munit_assert_int(second->array->size, ==, 9);
+  munit_assert_float(get_glfloat(second->array)[get_gluint(second->vertex_index)[2] * 3], ==, 5.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_shared_vertices(const MunitParameter params[], void *data)
+{
+  object_t *object = parse_string("o test\nv 1 2 3\ng first\nf 1 1 1\n");
+  munit_assert_int(object->pool->size, ==, 0);
+  munit_assert_null(((group_t *)get_pointer(object->group)[0])->pool);
+  return MUNIT_OK;
+}
+
+static MunitResult test_replace_object(const MunitParameter params[], void *data)
+{
+  object_t *object = parse_string("o first\nv 1 2 3\ng lost\nf 1 1 1\no second\ng kept\nf 1 1 1\n");
+  munit_assert_string_equal(object->name, "second");
+  munit_assert_int(object->group->size, ==, 1);
+  munit_assert_string_equal(((group_t *)get_pointer(object->group)[0])->name, "kept");
+  destroy_object(object);
+  return MUNIT_OK;
+}
+
+static MunitResult test_destroy_parser_context(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  object_t *object = parse_string_core(context, "o test\nv 1 2 3\ng first\nf 1 1 1\n");
+  parser_cleanup(context);
+  destroy_parser_context(context);
+  munit_assert_int(object->group->size, ==, 1);
+  destroy_object(object);
+  return MUNIT_OK;
+}
+
+static material_t *library_material(parser_context_t *context, const char *text, const char *name)
+{
+  parse_string_core(context, text);
+  material_t *result = hash_find_material(context->materials, name, NULL);
+  parser_cleanup(context);
+  return result;
+}
+
+static MunitResult test_cached_library(const MunitParameter params[], void *data)
+{
+  clear_material_library_cache();
+  set_material_library_cache(1);
+  parser_context_t *context = make_parser_context();
+  material_t *first = library_material(context, "mtllib test.mtl\no test", "testmaterial");
+  material_t *second = library_material(context, "mtllib test.mtl\no test", "testmaterial");
+  munit_assert_ptr(first, !=, NULL);
+  munit_assert_ptr(second, ==, first);
+  munit_assert_int(first->cached, ==, 1);
+  munit_assert_int(material_library_misses(), ==, 1);
+  munit_assert_int(material_library_hits(), ==, 1);
+  destroy_parser_context(context);
+  clear_material_library_cache();
+  set_material_library_cache(0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_uncached_library(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = make_parser_context();
+  parse_string_core(context, "mtllib test.mtl\no test");
+  material_t *first = hash_find_material(context->materials, "testmaterial", NULL);
+  parse_string_core(context, "mtllib test.mtl\no test");
+  munit_assert_ptr(hash_find_material(context->materials, "testmaterial", NULL), !=, first);
+  munit_assert_int(first->cached, ==, 0);
+  return MUNIT_OK;
+}
+
+static void write_library(const char *file_name, const char *text, time_t mtime)
+{
+  FILE *f = fopen(file_name, "w");
+  fputs(text, f);
+  fclose(f);
+  struct timespec times[2] = {{mtime, 0}, {mtime, 0}};
+  utimensat(AT_FDCWD, file_name, times, 0);
+}
+
+static MunitResult test_changed_library(const MunitParameter params[], void *data)
+{
+  clear_material_library_cache();
+  set_material_library_cache(1);
+  char file_name[] = "/tmp/fsim-library-XXXXXX";
+  close(mkstemp(file_name));
+  char text[64];
+  snprintf(text, sizeof(text), "mtllib %s\no test", file_name);
+  parser_context_t *context = make_parser_context();
+  write_library(file_name, "newmtl stone\nillum 1\n", 1000000);
+  material_t *first = library_material(context, text, "stone");
+  write_library(file_name, "newmtl stone\nillum 2\n", 2000000);
+  material_t *second = library_material(context, text, "stone");
+  munit_assert_ptr(second, !=, first);
+  munit_assert_int(first->illumination, ==, 1);
+  munit_assert_int(second->illumination, ==, 2);
+  munit_assert_int(material_library_misses(), ==, 2);
+  destroy_parser_context(context);
+  unlink(file_name);
+  clear_material_library_cache();
+  set_material_library_cache(0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_keep_cached_material(const MunitParameter params[], void *data)
+{
+  clear_material_library_cache();
+  set_material_library_cache(1);
+  const char *text = "mtllib test.mtl\no test\nusemtl testmaterial\ng g\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3";
+  object_t *first = parse_string(text);
+  material_t *material = ((group_t *)get_pointer(first->group)[0])->material;
+  destroy_object(first);
+  object_t *second = parse_string(text);
+  munit_assert_ptr(((group_t *)get_pointer(second->group)[0])->material, ==, material);
+  munit_assert_int(material->cached, ==, 1);
+  destroy_object(second);
+  clear_material_library_cache();
+  set_material_library_cache(0);
+  return MUNIT_OK;
+}
+
 MunitTest test_parser[] = {
-  {"/empty"                  , test_empty                  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/object"                 , test_object                 , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/object_name"            , test_object_name            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/ignore_whitespace"      , test_ignore_whitespace      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/whitespace_in_name"     , test_whitespace_in_name     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/handle_ctrl_lf"         , test_handle_ctrl_lf         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/error"                  , test_error                  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/read_file"              , test_read_file              , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_such_file"           , test_no_such_file           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/ignore_comments"        , test_ignore_comments        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/ignore_trailing_comment", test_ignore_trailing_comment, test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_newline_in_name"     , test_no_newline_in_name     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_vertices"            , test_no_vertices            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/read_vertex"            , test_read_vertex            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_vertices"           , test_two_vertices           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/exponent"               , test_exponent               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/cleanup_vertices"       , test_cleanup_vertices       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_groups"              , test_no_groups              , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/start_group"            , test_start_group            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/group_name"             , test_group_name             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_groups"             , test_two_groups             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/default_object"         , test_default_object         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/facet"                  , test_facet                  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_stride"          , test_vertex_stride          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/indices"                , test_indices                , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/coord_count"            , test_coord_count            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/copy_coords"            , test_copy_coords            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/shuffle_coords"         , test_shuffle_coords         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/relative_index"         , test_relative_index         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/generate_indices"       , test_generate_indices       , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reset_vertex_cache"     , test_reset_vertex_cache     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_facets"             , test_two_facets             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reuse_vertices"         , test_reuse_vertices         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/square_facet"           , test_square_facet           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_group"               , test_no_group               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/add_group"              , test_add_group              , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_texcoord"            , test_no_texcoord            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/cleanup_texcoords"      , test_cleanup_texcoords      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/read_texcoord"          , test_read_texcoord          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_texcoords"          , test_two_texcoords          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/uv_facet"               , test_uv_facet               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_and_uv_stride"   , test_vertex_and_uv_stride   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reuse_uv"               , test_reuse_uv               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/uv_indices"             , test_uv_indices             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/uv_added"               , test_uv_added               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/copy_uv"                , test_copy_uv                , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/relative_uv_indices"    , test_relative_uv_indices    , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/different_uv_index"     , test_different_uv_index     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/uv_in_hash_key"         , test_uv_in_hash_key         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_and_uv_key"      , test_vertex_and_uv_key      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_normal"              , test_no_normal              , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/cleanup_normals"        , test_cleanup_normals        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/read_normal"            , test_read_normal            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/normal_facet"           , test_normal_facet           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/normal_indices"         , test_normal_indices         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/normals_added"          , test_normals_added          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/copy_normal"            , test_copy_normal            , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/relative_normal_index"  , test_relative_normal_index  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/different_normal_index" , test_different_normal_index , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reuse_normal"           , test_reuse_normal           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/normal_in_hash_key"     , test_normal_in_hash_key     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_and_normal_key"  , test_vertex_and_normal_key  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/full_facet"             , test_full_facet             , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/full_indices"           , test_full_indices           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/all_added"              , test_all_added              , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/different_indices"      , test_different_indices      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/material_filename"      , test_material_filename      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/material_name"          , test_material_name          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/file_not_found"         , test_file_not_found         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/continue_after_include" , test_continue_after_include , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/material"               , test_material               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/late_material"          , test_late_material          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_materials"          , test_two_materials          , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/illumination_model"     , test_illumination_model     , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/ambient"                , test_ambient                , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/use_material"           , test_use_material           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reuse_material"         , test_reuse_material         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/read_texture"           , test_read_texture           , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/texture_not_found"      , test_texture_not_found      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/specular_texture"       , test_specular_texture       , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/diffuse"                , test_diffuse                , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/specular"               , test_specular               , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/specular_exponent"      , test_specular_exponent      , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/optical_density"        , test_optical_density        , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/disolve"                , test_disolve                , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/mix_statements"         , test_mix_statements         , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/reset_parser"           , test_reset_parser           , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL                      , NULL                        , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+  {"/empty"                  , test_empty                  , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/object"                 , test_object                 , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/object_name"            , test_object_name            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/ignore_whitespace"      , test_ignore_whitespace      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/whitespace_in_name"     , test_whitespace_in_name     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/handle_ctrl_lf"         , test_handle_ctrl_lf         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/error"                  , test_error                  , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/non_decimal_number"     , test_non_decimal_number     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/index_out_of_range"     , test_index_out_of_range     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/read_file"              , test_read_file              , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_such_file"           , test_no_such_file           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/ignore_comments"        , test_ignore_comments        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/ignore_trailing_comment", test_ignore_trailing_comment, test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_newline_in_name"     , test_no_newline_in_name     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_vertices"            , test_no_vertices            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/read_vertex"            , test_read_vertex            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/two_vertices"           , test_two_vertices           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/exponent"               , test_exponent               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/cleanup_vertices"       , test_cleanup_vertices       , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_groups"              , test_no_groups              , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/start_group"            , test_start_group            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/group_name"             , test_group_name             , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/two_groups"             , test_two_groups             , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/default_object"         , test_default_object         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/facet"                  , test_facet                  , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/vertex_stride"          , test_vertex_stride          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/indices"                , test_indices                , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/coord_count"            , test_coord_count            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/copy_coords"            , test_copy_coords            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/shuffle_coords"         , test_shuffle_coords         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/relative_index"         , test_relative_index         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/generate_indices"       , test_generate_indices       , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reset_vertex_cache"     , test_reset_vertex_cache     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/two_facets"             , test_two_facets             , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reuse_vertices"         , test_reuse_vertices         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/square_facet"           , test_square_facet           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_group"               , test_no_group               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/add_group"              , test_add_group              , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_texcoord"            , test_no_texcoord            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/cleanup_texcoords"      , test_cleanup_texcoords      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/read_texcoord"          , test_read_texcoord          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/two_texcoords"          , test_two_texcoords          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/uv_facet"               , test_uv_facet               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/vertex_and_uv_stride"   , test_vertex_and_uv_stride   , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reuse_uv"               , test_reuse_uv               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/uv_indices"             , test_uv_indices             , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/uv_added"               , test_uv_added               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/copy_uv"                , test_copy_uv                , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/relative_uv_indices"    , test_relative_uv_indices    , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/different_uv_index"     , test_different_uv_index     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/uv_in_hash_key"         , test_uv_in_hash_key         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/vertex_and_uv_key"      , test_vertex_and_uv_key      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_normal"              , test_no_normal              , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/cleanup_normals"        , test_cleanup_normals        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/read_normal"            , test_read_normal            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/normal_facet"           , test_normal_facet           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/normal_indices"         , test_normal_indices         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/normals_added"          , test_normals_added          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/copy_normal"            , test_copy_normal            , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/relative_normal_index"  , test_relative_normal_index  , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/different_normal_index" , test_different_normal_index , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reuse_normal"           , test_reuse_normal           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/normal_in_hash_key"     , test_normal_in_hash_key     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/vertex_and_normal_key"  , test_vertex_and_normal_key  , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/full_facet"             , test_full_facet             , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/full_indices"           , test_full_indices           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/all_added"              , test_all_added              , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/different_indices"      , test_different_indices      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/material_filename"      , test_material_filename      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/material_name"          , test_material_name          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/file_not_found"         , test_file_not_found         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/continue_after_include" , test_continue_after_include , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/material"               , test_material               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/late_material"          , test_late_material          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/two_materials"          , test_two_materials          , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/illumination_model"     , test_illumination_model     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/ambient"                , test_ambient                , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/use_material"           , test_use_material           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reuse_material"         , test_reuse_material         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/read_texture"           , test_read_texture           , test_setup_parser_gl, test_teardown_parser_gl, MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/texture_not_found"      , test_texture_not_found      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/specular_texture"       , test_specular_texture       , test_setup_parser_gl, test_teardown_parser_gl, MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/diffuse"                , test_diffuse                , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/specular"               , test_specular               , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/specular_exponent"      , test_specular_exponent      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/optical_density"        , test_optical_density        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/disolve"                , test_disolve                , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/mix_statements"         , test_mix_statements         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/reset_parser"           , test_reset_parser           , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/group_callback"         , test_group_callback         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_group_callback"      , test_no_group_callback      , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/concurrent_parsers"     , test_concurrent_parsers     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/release_temporaries"    , test_release_temporaries    , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/shared_vertices"        , test_shared_vertices        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/pool_per_stride"        , test_pool_per_stride        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/stream_shared_vertices" , test_stream_shared_vertices , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/no_shared_vertices"     , test_no_shared_vertices     , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/replace_object"         , test_replace_object         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/destroy_parser_context" , test_destroy_parser_context , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/cached_library"         , test_cached_library         , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/uncached_library"       , test_uncached_library       , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/changed_library"        , test_changed_library        , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {"/keep_cached_material"   , test_keep_cached_material   , test_setup_parser   , test_teardown_parser   , MUNIT_TEST_OPTION_NONE, parser_params},
+  {NULL                      , NULL                        , NULL                , NULL                   , MUNIT_TEST_OPTION_NONE, NULL}
 };
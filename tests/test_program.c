@@ -21,9 +21,19 @@ static MunitResult test_compile_program(const MunitParameter params[], void *dat
   return MUNIT_OK;
 }
 
+static MunitResult test_destroy_program(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-identity.glsl", "fragment-blue.glsl");
+  GLuint name = program->program;
+  destroy_program(program);
+  munit_assert_false(glIsProgram(name));
+  return MUNIT_OK;
+}
+
 MunitTest test_program[] = {
   {"/no_vertex_shader"     , test_no_vertex_shader     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/no_fragment_shader"   , test_no_fragment_shader   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {"/compile_program"      , test_compile_program      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_program"      , test_destroy_program      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
   {NULL                    , NULL                      , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <pthread.h>
+#include "fsim/scanner.h"
+#include "fsim/parser.h"
+#include "fsim/object.h"
+#include "fsim/list.h"
+#include "fsim/hash.h"
+#include "test_scanner.h"
+#include "test_helper.h"
+
+
+static void *test_setup_scanner(const MunitParameter params[], void *user_data)
+{
+  test_setup_gc(params, user_data);
+  parser_context_t *context = make_parser_context();
+  context->materials = make_hash();
+  context->vertex = make_list();
+  context->uv = make_list();
+  context->normal = make_list();
+  return context;
+}
+
+static MunitResult test_partial_buffer(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_buffer(context, "v 1 2 3\nv 4 5 6", 7), ==, 0);
+  munit_assert_int(context->vertex->size, ==, 3);
+  munit_assert_float(get_glfloat(context->vertex)[2], ==, 3.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_unexpected_character(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_buffer(context, "o test\n?", 8), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_extra_coordinate(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_buffer(context, "v 1 2 3 4", 9), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_property_outside_material(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_buffer(context, "Kd 1 2 3", 8), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_facet_outside_group(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_buffer(context, "v 1 2 3\nf 1 1 1", 15), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_map_file(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_file(context, "name.obj"), ==, 0);
+  munit_assert_string_equal(context->result->name, "inafile");
+  return MUNIT_OK;
+}
+
+static MunitResult test_map_empty_file(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_file(context, "empty.mtl"), ==, 0);
+  munit_assert_ptr(context->result, ==, NULL);
+  return MUNIT_OK;
+}
+
+static MunitResult test_missing_file(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  munit_assert_int(scan_file(context, "nosuchfile.obj"), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parallel_vertices(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  const char *text = "v 1 2 3\nv 4 5 6\nv 7 8 9\nv 10 11 12\nv 13 14 15\n";
+  munit_assert_int(scan_buffer_parallel(context, text, strlen(text), 3), ==, 0);
+  munit_assert_int(context->vertex->size, ==, 15);
+  int i;
+  for (i=0; i<15; i++)
+    munit_assert_float(get_glfloat(context->vertex)[i], ==, i + 1);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parallel_relative_index(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  const char *text = "v 1 0 0\nv 2 0 0\ng a\nv 3 0 0\nf -3 -2 -1\nv 4 0 0\nv 5 0 0\ng b\nf -1 -2 -5\n";
+  munit_assert_int(scan_buffer_parallel(context, text, strlen(text), 4), ==, 0);
+  munit_assert_int(context->result->group->size, ==, 2);
+  group_t *group = get_pointer(context->result->group)[1];
+  munit_assert_int(group->array->size, ==, 9);
+  munit_assert_float(get_glfloat(group->array)[0], ==, 5.0f);
+  munit_assert_float(get_glfloat(group->array)[3], ==, 4.0f);
+  munit_assert_float(get_glfloat(group->array)[6], ==, 1.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parallel_error(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  const char *text = "v 1 2 3\nv 1 2\nv 1 2 3\nv 4 5 6\n";
+  munit_assert_int(scan_buffer_parallel(context, text, strlen(text), 2), !=, 0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_more_chunks_than_threads(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  const char *text = "v 1 0 0\nv 2 0 0\ng a\nv 3 0 0\nf -3 -2 -1\nv 4 0 0\nv 5 0 0\ng b\nf -1 -2 -5\n";
+  munit_assert_int(scan_buffer_chunks(context, text, strlen(text), 2, 10), ==, 0);
+  munit_assert_int(context->vertex->size, ==, 15);
+  munit_assert_int(context->result->group->size, ==, 2);
+  group_t *group = get_pointer(context->result->group)[1];
+  munit_assert_int(group->array->size, ==, 9);
+  munit_assert_float(get_glfloat(group->array)[0], ==, 5.0f);
+  munit_assert_float(get_glfloat(group->array)[3], ==, 4.0f);
+  munit_assert_float(get_glfloat(group->array)[6], ==, 1.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_threads(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  const char *text = "v 1 0 0\nv 2 0 0\ng a\nv 3 0 0\nf -3 -2 -1\nv 4 0 0\nv 5 0 0\ng b\nf -1 -2 -5\n";
+  pthread_attr_t previous;
+  pthread_attr_t huge_stack;
+  pthread_getattr_default_np(&previous);
+  pthread_attr_init(&huge_stack);
+  pthread_attr_setstacksize(&huge_stack, (size_t)1 << 50);
+  pthread_setattr_default_np(&huge_stack);
+  int result = scan_buffer_chunks(context, text, strlen(text), 2, 10);
+  pthread_setattr_default_np(&previous);
+  pthread_attr_destroy(&huge_stack);
+  pthread_attr_destroy(&previous);
+  munit_assert_int(result, ==, 0);
+  munit_assert_int(context->vertex->size, ==, 15);
+  munit_assert_int(context->result->group->size, ==, 2);
+  group_t *group = get_pointer(context->result->group)[1];
+  munit_assert_int(group->array->size, ==, 9);
+  munit_assert_float(get_glfloat(group->array)[0], ==, 5.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_prescan_coordinates(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  context->prescan = 1;
+  const char *text = "v 1 2 3\nv 4 5 6\nvt 0 1\nvn 0 0 1\n";
+  munit_assert_int(scan_buffer(context, text, strlen(text)), ==, 0);
+  munit_assert_int(context->vertex->buffer_size, ==, 6 * sizeof(GLfloat));
+  munit_assert_int(context->uv->buffer_size, ==, 2 * sizeof(GLfloat));
+  munit_assert_int(context->normal->buffer_size, ==, 3 * sizeof(GLfloat));
+  return MUNIT_OK;
+}
+
+static MunitResult test_prescan_indices(const MunitParameter params[], void *data)
+{
+  parser_context_t *context = data;
+  context->prescan = 1;
+  const char *text = "o test\nv 1 2 3\ng first\nf 1 1 1 1\nf 1 1 1\ng second\nf 1 1 1\n";
+  munit_assert_int(scan_buffer_parallel(context, text, strlen(text), 2), ==, 0);
+  group_t *first = get_pointer(context->result->group)[0];
+  group_t *second = get_pointer(context->result->group)[1];
+  munit_assert_int(first->vertex_index->buffer_size, ==, 9 * sizeof(GLuint));
+  munit_assert_int(second->vertex_index->buffer_size, ==, 3 * sizeof(GLuint));
+  return MUNIT_OK;
+}
+
+MunitTest test_scanner[] = {
+  {"/partial_buffer"            , test_partial_buffer            , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/unexpected_character"      , test_unexpected_character      , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/extra_coordinate"          , test_extra_coordinate          , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/property_outside_material" , test_property_outside_material , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/facet_outside_group"       , test_facet_outside_group       , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/map_file"                  , test_map_file                  , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/map_empty_file"            , test_map_empty_file            , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/missing_file"              , test_missing_file              , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parallel_vertices"         , test_parallel_vertices         , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parallel_relative_index"   , test_parallel_relative_index   , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parallel_error"            , test_parallel_error            , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/more_chunks_than_threads"  , test_more_chunks_than_threads  , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_threads"                , test_no_threads                , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/prescan_coordinates"       , test_prescan_coordinates       , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/prescan_indices"           , test_prescan_indices           , test_setup_scanner, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                         , NULL                           , NULL              , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -1,5 +1,6 @@
 #include "fsim/texture.h"
 #include "test_texture.h"
+#include "test_helper.h"
 
 
 static MunitResult test_make_texture(const MunitParameter params[], void *data)
@@ -10,7 +11,18 @@ static MunitResult test_make_texture(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static MunitResult test_destroy_texture(const MunitParameter params[], void *data)
+{
+  texture_t *texture = make_texture("tex");
+  GLuint name = texture->texture;
+  glBindTexture(GL_TEXTURE_2D, name);
+  destroy_texture(texture);
+  munit_assert_false(glIsTexture(name));
+  return MUNIT_OK;
+}
+
 MunitTest test_texture[] = {
-  {"/make_texture", test_make_texture, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL           , NULL             , NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}
+  {"/make_texture"   , test_make_texture   , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_texture", test_destroy_texture, test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL              , NULL                , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
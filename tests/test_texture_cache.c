@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#define GC_THREADS
+#include "fsim/memory.h"
+#include <pthread.h>
+#include "fsim/texture_cache.h"
+#include "fsim/material.h"
+#include "fsim/accounting.h"
+#include "test_texture_cache.h"
+#include "test_helper.h"
+
+
+static void *test_setup_cache(const MunitParameter params[], void *user_data)
+{
+  clear_texture_cache();
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_cache(void *fixture)
+{
+  clear_texture_cache();
+  set_texture_cache(0);
+  set_texture_content_hash(0);
+  test_teardown_gc(fixture);
+}
+
+static void *test_setup_cache_gl(const MunitParameter params[], void *user_data)
+{
+  clear_texture_cache();
+  set_texture_cache(1);
+  return test_setup_gl(params, user_data);
+}
+
+static void test_teardown_cache_gl(void *fixture)
+{
+  clear_texture_cache();
+  set_texture_cache(0);
+  test_teardown_gl(fixture);
+}
+
+static struct pending_texture_t *loader(int i)
+{
+  return (struct pending_texture_t *)(intptr_t)i;
+}
+
+static MunitResult test_same_file(const MunitParameter params[], void *data)
+{
+  texture_entry_t *first = request_texture_entry("map_Kd", "colors.png", loader(1));
+  texture_entry_t *second = request_texture_entry("map_Kd", "./colors.png", loader(2));
+  munit_assert_ptr(first, !=, NULL);
+  munit_assert_ptr(first->loading, ==, loader(1));
+  munit_assert_ptr(second, ==, first);
+  munit_assert_int(texture_cache_misses(), ==, 1);
+  munit_assert_int(texture_cache_hits(), ==, 1);
+  return MUNIT_OK;
+}
+
+static MunitResult test_sampler_name(const MunitParameter params[], void *data)
+{
+  texture_entry_t *diffuse = request_texture_entry("map_Kd", "colors.png", loader(1));
+  texture_entry_t *specular = request_texture_entry("map_Ks", "colors.png", loader(2));
+  munit_assert_ptr(specular, !=, diffuse);
+  munit_assert_int(texture_cache_misses(), ==, 2);
+  return MUNIT_OK;
+}
+
+static MunitResult test_missing_file(const MunitParameter params[], void *data)
+{
+  munit_assert_ptr(request_texture_entry("map_Kd", "nosuchfile.png", loader(1)), ==, NULL);
+  return MUNIT_OK;
+}
+
+static char *copy_image(const char *file_name)
+{
+  char *result = malloc(32);
+  strcpy(result, "/tmp/fsim-texture-XXXXXX");
+  FILE *target = fdopen(mkstemp(result), "w");
+  FILE *source = fopen(file_name, "r");
+  int c;
+  while ((c = fgetc(source)) != EOF)
+    fputc(c, target);
+  fclose(source);
+  fclose(target);
+  return result;
+}
+
+static MunitResult test_content_hash(const MunitParameter params[], void *data)
+{
+  char *copy = copy_image("colors.png");
+  set_texture_content_hash(1);
+  texture_entry_t *original = request_texture_entry("map_Kd", "colors.png", loader(1));
+  munit_assert_ptr(request_texture_entry("map_Kd", copy, loader(2)), ==, original);
+  munit_assert_ptr(request_texture_entry("map_Kd", "gray.png", loader(3)), !=, original);
+  unlink(copy);
+  free(copy);
+  return MUNIT_OK;
+}
+
+static MunitResult test_no_content_hash(const MunitParameter params[], void *data)
+{
+  char *copy = copy_image("colors.png");
+  texture_entry_t *original = request_texture_entry("map_Kd", "colors.png", loader(1));
+  munit_assert_ptr(request_texture_entry("map_Kd", copy, loader(2)), !=, original);
+  unlink(copy);
+  free(copy);
+  return MUNIT_OK;
+}
+
+static MunitResult test_failed_entry(const MunitParameter params[], void *data)
+{
+  texture_entry_t *first = request_texture_entry("map_Kd", "colors.png", loader(1));
+  complete_texture_entry(first, NULL);
+  munit_assert_ptr(share_texture(first), ==, NULL);
+  texture_entry_t *second = request_texture_entry("map_Kd", "colors.png", loader(2));
+  munit_assert_ptr(second, !=, first);
+  munit_assert_ptr(second->loading, ==, loader(2));
+  return MUNIT_OK;
+}
+
+static MunitResult test_share_texture(const MunitParameter params[], void *data)
+{
+  texture_t texture = {"map_Kd", 0, NULL, 1000, 1};
+  texture_entry_t *entry = request_texture_entry("map_Kd", "colors.png", loader(1));
+  complete_texture_entry(entry, &texture);
+  munit_assert_ptr(entry->loading, ==, NULL);
+  munit_assert_ptr(share_texture(request_texture_entry("map_Kd", "colors.png", loader(2))), ==, &texture);
+  munit_assert_int(texture.references, ==, 2);
+  munit_assert_int(texture_bytes_saved(), ==, 1000);
+  munit_assert_int(release_texture_reference(&texture), ==, 1);
+  munit_assert_ptr(request_texture_entry("map_Kd", "colors.png", loader(3)), ==, entry);
+  munit_assert_int(release_texture_reference(&texture), ==, 0);
+  munit_assert_ptr(request_texture_entry("map_Kd", "colors.png", loader(4)), !=, entry);
+  return MUNIT_OK;
+}
+
+static MunitResult test_collected_entry(const MunitParameter params[], void *data)
+{
+  texture_t texture = {"map_Kd", 0, NULL, 1000, 1};
+  texture_entry_t *entry = request_texture_entry("map_Kd", "colors.png", loader(1));
+  complete_texture_entry(entry, &texture);
+  // The collector clears the hidden pointer when the texture becomes unreachable.
+  entry->texture = 0;
+  munit_assert_ptr(share_texture(entry), ==, NULL);
+  munit_assert_ptr(request_texture_entry("map_Kd", "colors.png", loader(2)), !=, entry);
+  munit_assert_int(texture.references, ==, 1);
+  return MUNIT_OK;
+}
+
+typedef struct {
+  texture_entry_t *entry;
+  texture_t *texture;
+  volatile int done;
+} waiter_t;
+
+// Second parser context on another thread requesting the same image.
+static void *wait_for_entry(void *data)
+{
+  waiter_t *waiter = data;
+  texture_entry_t *entry = request_texture_entry("map_Kd", "colors.png", loader(2));
+  munit_assert_ptr(entry, ==, waiter->entry);
+  munit_assert_ptr(wait_for_texture_entry(entry), ==, NULL);
+  waiter->texture = share_texture(entry);
+  waiter->done = 1;
+  return NULL;
+}
+
+static MunitResult test_concurrent_request(const MunitParameter params[], void *data)
+{
+  texture_t texture = {"map_Kd", 0, NULL, 1000, 1};
+  waiter_t waiter = {request_texture_entry("map_Kd", "colors.png", loader(1)), NULL, 0};
+  pthread_t thread;
+  pthread_create(&thread, NULL, wait_for_entry, &waiter);
+  usleep(20000);
+  munit_assert_false(waiter.done);
+  complete_texture_entry(waiter.entry, &texture);
+  pthread_join(thread, NULL);
+  munit_assert_ptr(waiter.texture, ==, &texture);
+  munit_assert_int(texture.references, ==, 2);
+  return MUNIT_OK;
+}
+
+static MunitResult test_own_loader_first(const MunitParameter params[], void *data)
+{
+  texture_entry_t *first = request_texture_entry("map_Kd", "colors.png", loader(1));
+  texture_entry_t *second = request_texture_entry("map_Kd", "gray.png", loader(2));
+  munit_assert_true(loads_texture_entry(first, loader(1)));
+  munit_assert_false(loads_texture_entry(first, loader(2)));
+  munit_assert_ptr(wait_for_texture_entry(first), !=, NULL);
+  complete_texture_entry(first, NULL);
+  munit_assert_ptr(wait_for_texture_entry(first), ==, NULL);
+  munit_assert_ptr(wait_for_texture_entry(second), ==, loader(2));
+  complete_texture_entry(second, NULL);
+  return MUNIT_OK;
+}
+
+static MunitResult test_shared_upload(const MunitParameter params[], void *data)
+{
+  int64_t uploaded = memory_usage(MEMORY_GL_TEXTURE).allocated_bytes;
+  material_t *first = make_material();
+  material_t *second = make_material();
+  pending_texture_t *first_request = request_diffuse_texture(first, "colors.png");
+  pending_texture_t *second_request = request_diffuse_texture(second, "colors.png");
+  upload_texture(second_request);
+  upload_texture(first_request);
+  munit_assert_ptr(first->diffuse_texture, !=, NULL);
+  munit_assert_ptr(second->diffuse_texture, ==, first->diffuse_texture);
+  munit_assert_int(first->diffuse_texture->references, ==, 2);
+  munit_assert_int(memory_usage(MEMORY_GL_TEXTURE).allocated_bytes - uploaded, ==, texture_bytes_saved());
+  destroy_pending_texture(first_request);
+  destroy_pending_texture(second_request);
+  GLuint name = first->diffuse_texture->texture;
+  destroy_material(first);
+  munit_assert_true(glIsTexture(name));
+  destroy_material(second);
+  munit_assert_false(glIsTexture(name));
+  return MUNIT_OK;
+}
+
+MunitTest test_texture_cache[] = {
+  {"/same_file"          , test_same_file         , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/sampler_name"       , test_sampler_name      , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/missing_file"       , test_missing_file      , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/content_hash"       , test_content_hash      , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_content_hash"    , test_no_content_hash   , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/failed_entry"       , test_failed_entry      , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/share_texture"      , test_share_texture     , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/collected_entry"    , test_collected_entry   , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/concurrent_request" , test_concurrent_request, test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/own_loader_first"   , test_own_loader_first  , test_setup_cache   , test_teardown_cache   , MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shared_upload"      , test_shared_upload     , test_setup_cache_gl, test_teardown_cache_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                  , NULL                   , NULL               , NULL                  , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -1,3 +1,4 @@
+#include <GL/glew.h>
 #include "fsim/vertex_array_object.h"
 #include "test_vertex_array_object.h"
 #include "test_helper.h"
@@ -116,17 +117,260 @@ static MunitResult test_material(const MunitParameter params[], void *data)
   return MUNIT_OK;
 }
 
+static object_t *shared_object(void)
+{
+  object_t *object = make_object("test");
+  vertex_pool_t *pool = object_pool(object, 3);
+  int i;
+  for (i=0; i<9; i++)
+    append_glfloat(pool->array, i);
+  for (i=0; i<2; i++) {
+    group_t *group = make_group("test", 3);
+    group->pool = pool;
+    add_triangle(group, 0, 1, 2);
+    add_group(object, group);
+  };
+  add_group(object, make_group("own", 3));
+  return object;
+}
+
+static MunitResult test_shared_buffers(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  list_t *list = make_vertex_array_object_list(program, shared_object());
+  vertex_array_object_t *first = get_pointer(list)[0];
+  vertex_array_object_t *second = get_pointer(list)[1];
+  vertex_array_object_t *own = get_pointer(list)[2];
+  munit_assert_not_null(first->shared);
+  munit_assert_ptr(first->shared, ==, second->shared);
+  munit_assert_null(own->shared);
+  munit_assert_int(first->index_offset, ==, 0);
+  munit_assert_int(first->index_type, ==, GL_UNSIGNED_BYTE);
+  munit_assert_int(second->index_offset, ==, 3 * sizeof(GLubyte));
+  munit_assert_int(second->n_indices, ==, 3);
+  return MUNIT_OK;
+}
+
+static MunitResult test_single_pool_group(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  group_t *group = get_pointer(shared_object()->group)[1];
+  vertex_array_object_t *vertex_array_object = make_vertex_array_object(program, group);
+  munit_assert_not_null(vertex_array_object->shared);
+  munit_assert_int(vertex_array_object->index_offset, ==, 0);
+  munit_assert_int(vertex_array_object->n_attributes, ==, 1);
+  return MUNIT_OK;
+}
+
+static MunitResult test_keep_element_buffer(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  vertex_array_object_t *first = make_vertex_array_object(program, get_pointer(shared_object()->group)[1]);
+  make_vertex_array_object_list(program, shared_object());
+  GLint buffer;
+  glBindVertexArray(first->vertex_array_object);
+  glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
+  munit_assert_int(buffer, ==, first->shared->element_buffer_object);
+  return MUNIT_OK;
+}
+
+static MunitResult test_destroy_shared_buffers(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  list_t *list = make_vertex_array_object_list(program, shared_object());
+  vertex_array_object_t *second = get_pointer(list)[1];
+  munit_assert_int(second->shared->references, ==, 2);
+  destroy_vertex_array_object(get_pointer(list)[0]);
+  munit_assert_int(second->shared->references, ==, 1);
+  munit_assert_true(glIsBuffer(second->shared->vertex_buffer_object));
+  destroy_vertex_array_object(second);
+  destroy_vertex_array_object(get_pointer(list)[2]);
+  destroy_list(list);
+  destroy_program(program);
+  return MUNIT_OK;
+}
+
+static MunitResult test_delete_vertex_array(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  vertex_array_object_t *vertex_array_object = make_vertex_array_object(program, get_pointer(shared_object()->group)[2]);
+  GLuint name = vertex_array_object->vertex_array_object;
+  GLuint buffer = vertex_array_object->vertex_buffer_object;
+  destroy_vertex_array_object(vertex_array_object);
+  munit_assert_false(glIsVertexArray(name));
+  munit_assert_false(glIsBuffer(buffer));
+  return MUNIT_OK;
+}
+
+static MunitResult test_compact_after_upload(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  object_t *object = shared_object();
+  set_upload_mode(UPLOAD_RELEASE);
+  list_t *list = make_vertex_array_object_list(program, object);
+  set_upload_mode(UPLOAD_KEEP);
+  munit_assert_int(((vertex_pool_t *)get_pointer(object->pool)[0])->array->size, ==, 0);
+  munit_assert_int(((group_t *)get_pointer(object->group)[0])->vertex_index->size, ==, 0);
+  munit_assert_float(((group_t *)get_pointer(object->group)[1])->bounds[5], ==, 8.0f);
+  munit_assert_int(((vertex_array_object_t *)get_pointer(list)[1])->n_indices, ==, 3);
+  return MUNIT_OK;
+}
+
+static MunitResult test_release_pool_group(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  object_t *object = shared_object();
+  group_t *group = get_pointer(object->group)[1];
+  set_upload_mode(UPLOAD_RELEASE);
+  vertex_array_object_t *vertex_array_object = make_vertex_array_object(program, group);
+  set_upload_mode(UPLOAD_KEEP);
+  munit_assert_int(vertex_array_object->n_indices, ==, 3);
+  munit_assert_int(group->vertex_index->size, ==, 0);
+  munit_assert_float(group->bounds[5], ==, 8.0f);
+  munit_assert_int(((vertex_pool_t *)get_pointer(object->pool)[0])->array->size, ==, 9);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smallest_index_type(const MunitParameter params[], void *data)
+{
+  munit_assert_int(smallest_index_type(0), ==, GL_UNSIGNED_BYTE);
+  munit_assert_int(smallest_index_type(256), ==, GL_UNSIGNED_BYTE);
+  munit_assert_int(smallest_index_type(257), ==, GL_UNSIGNED_SHORT);
+  munit_assert_int(smallest_index_type(65536), ==, GL_UNSIGNED_SHORT);
+  munit_assert_int(smallest_index_type(65537), ==, GL_UNSIGNED_INT);
+  munit_assert_int(index_type_size(GL_UNSIGNED_BYTE), ==, 1);
+  munit_assert_int(index_type_size(GL_UNSIGNED_SHORT), ==, 2);
+  munit_assert_int(index_type_size(GL_UNSIGNED_INT), ==, 4);
+  return MUNIT_OK;
+}
+
+// Group with the given number of vertices and one triangle using the last vertex.
+static group_t *sized_group(int n_vertices)
+{
+  group_t *group = make_group("test", 3);
+  int i;
+  for (i=0; i<3 * n_vertices; i++)
+    append_glfloat(group->array, i);
+  add_triangle(group, 0, n_vertices - 2, n_vertices - 1);
+  return group;
+}
+
+static void assert_index_type(int n_vertices, GLenum index_type, int index_size)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  vertex_array_object_t *vertex_array_object = make_vertex_array_object(program, sized_group(n_vertices));
+  munit_assert_int(vertex_array_object->index_type, ==, index_type);
+  GLint size;
+  glBindVertexArray(vertex_array_object->vertex_array_object);
+  glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+  munit_assert_int(size, ==, 3 * index_size);
+  munit_assert_int(vertex_array_object->buffer_bytes, ==, 3 * n_vertices * sizeof(GLfloat) + 3 * index_size);
+  destroy_vertex_array_object(vertex_array_object);
+}
+
+static MunitResult test_byte_indices(const MunitParameter params[], void *data)
+{
+  assert_index_type(256, GL_UNSIGNED_BYTE, sizeof(GLubyte));
+  return MUNIT_OK;
+}
+
+static MunitResult test_short_indices(const MunitParameter params[], void *data)
+{
+  assert_index_type(257, GL_UNSIGNED_SHORT, sizeof(GLushort));
+  assert_index_type(65536, GL_UNSIGNED_SHORT, sizeof(GLushort));
+  return MUNIT_OK;
+}
+
+static MunitResult test_int_indices(const MunitParameter params[], void *data)
+{
+  assert_index_type(65537, GL_UNSIGNED_INT, sizeof(GLuint));
+  return MUNIT_OK;
+}
+
+static MunitResult test_draw_short_indices(const MunitParameter params[], void *data)
+{
+  object_t *object = make_object("test");
+  group_t *group = make_group("triangle", 3);
+  int i;
+  for (i=0; i<300; i++)
+    add_vertex_data(group, 3, 10.0f, 10.0f, 0.0f);
+  add_vertex_data(group, 3, 0.5f, 0.5f, 0.0f);
+  add_vertex_data(group, 3, -0.5f, 0.5f, 0.0f);
+  add_vertex_data(group, 3, -0.5f, -0.5f, 0.0f);
+  add_triangle(group, 300, 301, 302);
+  add_group(object, group);
+  program_t *program = make_program("vertex-identity.glsl", "fragment-blue.glsl");
+  list_t *list = make_vertex_array_object_list(program, object);
+  munit_assert_int(((vertex_array_object_t *)get_pointer(list)[0])->index_type, ==, GL_UNSIGNED_SHORT);
+  glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+  glClearColor(0, 1, 0, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+  render(list);
+  glFinish();
+  unsigned char *pixels = read_pixels();
+  munit_assert_int(pixels[(12 * 32 + 14 ) * 4 + 1], ==,   0);
+  munit_assert_int(pixels[(12 * 32 + 14 ) * 4 + 2], ==, 255);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compact_format(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  group_t *group = make_group("test", 8);
+  add_vertex_data(group, 8, -1.0f, 2.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+  add_vertex_data(group, 8, 1.0f, 6.0f, 3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+  add_vertex_data(group, 8, 0.0f, 4.0f, 5.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f);
+  add_triangle(group, 0, 1, 2);
+  set_vertex_format(VERTEX_FORMAT_COMPACT);
+  vertex_array_object_t *vertex_array_object = make_vertex_array_object(program, group);
+  set_vertex_format(VERTEX_FORMAT_FLOAT);
+  munit_assert_int(vertex_array_object->vertex_format, ==, VERTEX_FORMAT_COMPACT);
+  munit_assert_int(vertex_array_object->n_attributes, ==, 3);
+  munit_assert_int(vertex_array_object->attribute_pointer, ==, 16);
+  munit_assert_int(vertex_array_object->buffer_bytes, ==, 3 * 16 + 3 * sizeof(GLubyte));
+  munit_assert_float(vertex_array_object->point_offset[1], ==, 2.0f);
+  munit_assert_float(vertex_array_object->point_scale[1], ==, 4.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_compact_shared_buffers(const MunitParameter params[], void *data)
+{
+  program_t *program = make_program("vertex-texcoord.glsl", "fragment-blue.glsl");
+  set_vertex_format(VERTEX_FORMAT_COMPACT);
+  list_t *list = make_vertex_array_object_list(program, shared_object());
+  set_vertex_format(VERTEX_FORMAT_FLOAT);
+  vertex_array_object_t *second = get_pointer(list)[1];
+  munit_assert_int(second->vertex_format, ==, VERTEX_FORMAT_COMPACT);
+  munit_assert_int(second->shared->bytes, ==, 3 * 8 + 6 * sizeof(GLubyte));
+  munit_assert_float(second->point_scale[2], ==, 6.0f);
+  return MUNIT_OK;
+}
+
 MunitTest test_vao[] = {
-  {"/vertex_attribute"     , test_vertex_attribute     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_and_uv"        , test_vertex_and_uv        , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_and_normal"    , test_vertex_and_normal    , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vertex_uv_and_normal" , test_vertex_uv_and_normal , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/no_textures"          , test_no_textures          , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/diffuse_texture"      , test_diffuse_texture      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/two_textures"         , test_two_textures         , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/make_empty_vao_list"  , test_make_empty_vao_list  , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vao_list_entry"       , test_vao_list_entry       , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/vao_list_program"     , test_vao_list_program     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {"/material"             , test_material             , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
-  {NULL                    , NULL                      , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
+  {"/vertex_attribute"      , test_vertex_attribute      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vertex_and_uv"         , test_vertex_and_uv         , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vertex_and_normal"     , test_vertex_and_normal     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vertex_uv_and_normal"  , test_vertex_uv_and_normal  , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/no_textures"           , test_no_textures           , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/diffuse_texture"       , test_diffuse_texture       , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/two_textures"          , test_two_textures          , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/make_empty_vao_list"   , test_make_empty_vao_list   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vao_list_entry"        , test_vao_list_entry        , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/vao_list_program"      , test_vao_list_program      , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/material"              , test_material              , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/shared_buffers"        , test_shared_buffers        , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/single_pool_group"     , test_single_pool_group     , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/keep_element_buffer"   , test_keep_element_buffer   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/destroy_shared_buffers", test_destroy_shared_buffers, test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/delete_vertex_array"   , test_delete_vertex_array   , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_after_upload"  , test_compact_after_upload  , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/release_pool_group"    , test_release_pool_group    , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/smallest_index_type"   , test_smallest_index_type   , test_setup_gc, test_teardown_gc, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/byte_indices"          , test_byte_indices          , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/short_indices"         , test_short_indices         , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/int_indices"           , test_int_indices           , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/draw_short_indices"    , test_draw_short_indices    , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_format"        , test_compact_format        , test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/compact_shared_buffers", test_compact_shared_buffers, test_setup_gl, test_teardown_gl, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                     , NULL                       , NULL         , NULL            , MUNIT_TEST_OPTION_NONE, NULL}
 };
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fsim/memory.h"
+#include "fsim/vertex_cache.h"
+#include "fsim/cache.h"
+#include "fsim/parser.h"
+#include "test_vertex_cache.h"
+#include "test_helper.h"
+
+
+#define GRID 32
+
+// Triangles of a grid of GRID x GRID quads in row order.
+static GLuint *grid_indices(int64_t *n_indices)
+{
+  GLuint *result = GC_MALLOC_ATOMIC(GRID * GRID * 6 * sizeof(GLuint));
+  int64_t n = 0;
+  int i;
+  int j;
+  for (j=0; j<GRID; j++)
+    for (i=0; i<GRID; i++) {
+      GLuint corner = j * (GRID + 1) + i;
+      result[n++] = corner; result[n++] = corner + 1; result[n++] = corner + GRID + 2;
+      result[n++] = corner; result[n++] = corner + GRID + 2; result[n++] = corner + GRID + 1;
+    };
+  *n_indices = n;
+  return result;
+}
+
+static char *grid_text(void)
+{
+  char *result = GC_MALLOC_ATOMIC((GRID + 1) * (GRID + 1) * 32 + GRID * GRID * 64 + 16);
+  char *p = result;
+  int i;
+  int j;
+  p += sprintf(p, "g grid\n");
+  for (j=0; j<=GRID; j++)
+    for (i=0; i<=GRID; i++)
+      p += sprintf(p, "v %d %d 0\n", i, j);
+  for (j=0; j<GRID; j++)
+    for (i=0; i<GRID; i++) {
+      int corner = j * (GRID + 1) + i + 1;
+      p += sprintf(p, "f %d %d %d %d\n", corner, corner + 1, corner + GRID + 2, corner + GRID + 1);
+    };
+  return result;
+}
+
+static int compare_triangles(const void *a, const void *b)
+{
+  return memcmp(a, b, 3 * sizeof(GLuint));
+}
+
+// Rotate each triangle so that its smallest index comes first (which keeps the winding) and sort the triangles.
+static GLuint *canonical_triangles(const GLuint *index, int64_t n_indices)
+{
+  GLuint *result = GC_MALLOC_ATOMIC(n_indices * sizeof(GLuint));
+  int64_t i;
+  for (i=0; i<n_indices; i+=3) {
+    int first = 0;
+    int j;
+    for (j=1; j<3; j++)
+      if (index[i + j] < index[i + first])
+        first = j;
+    for (j=0; j<3; j++)
+      result[i + j] = index[i + (first + j) % 3];
+  };
+  qsort(result, n_indices / 3, 3 * sizeof(GLuint), compare_triangles);
+  return result;
+}
+
+static void *test_setup_vertex_cache(const MunitParameter params[], void *user_data)
+{
+  set_vertex_cache_optimization(0);
+  set_parser_cache(0);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_vertex_cache(void *fixture)
+{
+  set_vertex_cache_optimization(0);
+  set_parser_cache(0);
+  test_teardown_gc(fixture);
+}
+
+static MunitResult test_statistics(const MunitParameter params[], void *data)
+{
+  GLuint index[] = {0, 1, 2, 2, 1, 3};
+  vertex_cache_statistics_t statistics = vertex_cache_statistics(index, 6, 16);
+  munit_assert_double(statistics.acmr, ==, 2.0);
+  munit_assert_double(statistics.atvr, ==, 1.0);
+  statistics = vertex_cache_statistics(index, 6, 2);
+  munit_assert_double(statistics.acmr, ==, 2.5);
+  munit_assert_double(statistics.atvr, ==, 1.25);
+  return MUNIT_OK;
+}
+
+static MunitResult test_empty_statistics(const MunitParameter params[], void *data)
+{
+  vertex_cache_statistics_t statistics = vertex_cache_statistics(NULL, 0, 16);
+  munit_assert_double(statistics.acmr, ==, 0.0);
+  munit_assert_double(statistics.atvr, ==, 0.0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_single_triangle(const MunitParameter params[], void *data)
+{
+  GLuint index[] = {5, 3, 4};
+  optimize_vertex_cache(index, 3, 16);
+  munit_assert_int(index[0], ==, 5);
+  munit_assert_int(index[1], ==, 3);
+  munit_assert_int(index[2], ==, 4);
+  return MUNIT_OK;
+}
+
+static MunitResult test_same_triangles(const MunitParameter params[], void *data)
+{
+  int64_t n_indices;
+  GLuint *index = grid_indices(&n_indices);
+  GLuint *expected = canonical_triangles(index, n_indices);
+  optimize_vertex_cache(index, n_indices, VERTEX_CACHE_SIZE);
+  munit_assert_memory_equal(n_indices * sizeof(GLuint), canonical_triangles(index, n_indices), expected);
+  return MUNIT_OK;
+}
+
+static MunitResult test_offset_indices(const MunitParameter params[], void *data)
+{
+  int64_t n_indices;
+  GLuint *index = grid_indices(&n_indices);
+  int64_t i;
+  for (i=0; i<n_indices; i++)
+    index[i] += 100000;
+  GLuint *expected = canonical_triangles(index, n_indices);
+  optimize_vertex_cache(index, n_indices, VERTEX_CACHE_SIZE);
+  munit_assert_memory_equal(n_indices * sizeof(GLuint), canonical_triangles(index, n_indices), expected);
+  return MUNIT_OK;
+}
+
+static MunitResult test_grid_improves(const MunitParameter params[], void *data)
+{
+  int64_t n_indices;
+  GLuint *index = grid_indices(&n_indices);
+  vertex_cache_statistics_t before = vertex_cache_statistics(index, n_indices, VERTEX_CACHE_SIZE);
+  optimize_vertex_cache(index, n_indices, VERTEX_CACHE_SIZE);
+  vertex_cache_statistics_t after = vertex_cache_statistics(index, n_indices, VERTEX_CACHE_SIZE);
+  munit_assert_double(before.acmr, >, 0.9);
+  munit_assert_double(after.acmr, <, 0.8);
+  munit_assert_double(after.atvr, <, before.atvr);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parser(const MunitParameter params[], void *data)
+{
+  char *text = grid_text();
+  group_t *reference = get_pointer(parse_string(text)->group)[0];
+  set_vertex_cache_optimization(1);
+  group_t *group = get_pointer(parse_string(text)->group)[0];
+  int64_t n_indices = group->vertex_index->size;
+  munit_assert_int(n_indices, ==, reference->vertex_index->size);
+  munit_assert_memory_equal(n_indices * sizeof(GLuint), canonical_triangles(get_gluint(group->vertex_index), n_indices),
+                            canonical_triangles(get_gluint(reference->vertex_index), n_indices));
+  munit_assert_double(object_vertex_cache_statistics(parse_string(text), 16).acmr, <, 0.8);
+  return MUNIT_OK;
+}
+
+static MunitResult test_cache(const MunitParameter params[], void *data)
+{
+  char file_name[] = "/tmp/fsim-vertex-cache-XXXXXX";
+  int fd = mkstemp(file_name);
+  munit_assert_int(fd, >=, 0);
+  char *text = grid_text();
+  munit_assert_int(write(fd, text, strlen(text)), ==, strlen(text));
+  close(fd);
+  munit_assert_int(write_object_cache(file_name, parse_file(file_name), make_list()), ==, 0);
+  munit_assert_double(object_vertex_cache_statistics(read_object_cache(file_name), 16).acmr, >, 0.9);
+  set_vertex_cache_optimization(1);
+  munit_assert_double(object_vertex_cache_statistics(read_object_cache(file_name), 16).acmr, <, 0.8);
+  unlink(object_cache_file_name(file_name));
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+static MunitResult test_load_groups(const MunitParameter params[], void *data)
+{
+  char file_name[] = "/tmp/fsim-vertex-cache-XXXXXX";
+  int fd = mkstemp(file_name);
+  munit_assert_int(fd, >=, 0);
+  char *text = grid_text();
+  munit_assert_int(write(fd, text, strlen(text)), ==, strlen(text));
+  close(fd);
+  set_vertex_cache_optimization(1);
+  const char *names[] = {"grid", NULL};
+  object_t *object = parse_file_groups(file_name, names);
+  group_t *group = get_pointer(object->group)[0];
+  munit_assert_double(object_vertex_cache_statistics(object, 16).acmr, <, 0.8);
+  munit_assert_int(group->vertex_index->buffer_size, ==, group->vertex_index->size * sizeof(GLuint));
+  munit_assert_int(group->array->buffer_size, ==, group->array->size * sizeof(GLfloat));
+  unlink(group_index_file_name(file_name));
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+MunitTest test_vertex_cache[] = {
+  {"/statistics"      , test_statistics      , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/empty_statistics", test_empty_statistics, test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/single_triangle" , test_single_triangle , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/same_triangles"  , test_same_triangles  , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/offset_indices"  , test_offset_indices  , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/grid_improves"   , test_grid_improves   , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parser"          , test_parser          , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/cache"           , test_cache           , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/load_groups"     , test_load_groups     , test_setup_vertex_cache, test_teardown_vertex_cache, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL               , NULL                 , NULL                   , NULL                      , MUNIT_TEST_OPTION_NONE, NULL}
+};
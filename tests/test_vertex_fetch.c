@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fsim/memory.h"
+#include "fsim/vertex_cache.h"
+#include "fsim/vertex_fetch.h"
+#include "fsim/cache.h"
+#include "fsim/parser.h"
+#include "test_vertex_fetch.h"
+#include "test_helper.h"
+
+
+#define GRID 24
+
+static char *grid_text(const char *name)
+{
+  char *result = GC_MALLOC_ATOMIC((GRID + 1) * (GRID + 1) * 64 + GRID * GRID * 64 + 64);
+  char *p = result;
+  int i;
+  int j;
+  for (j=0; j<=GRID; j++)
+    for (i=0; i<=GRID; i++)
+      p += sprintf(p, "v %d %d 0\nvt %d %d\n", i, j, i, j);
+  p += sprintf(p, "g %s\n", name);
+  for (j=0; j<GRID; j++)
+    for (i=0; i<GRID; i++) {
+      int c = j * (GRID + 1) + i + 1;
+      p += sprintf(p, "f %d/%d %d/%d %d/%d %d/%d\n", c, c, c + 1, c + 1, c + GRID + 2, c + GRID + 2, c + GRID + 1,
+                   c + GRID + 1);
+    };
+  return result;
+}
+
+// Vertex data of all corners in the order of the indices.
+static GLfloat *corners(const GLuint *index, int64_t n_indices, const GLfloat *array, int stride)
+{
+  GLfloat *result = GC_MALLOC_ATOMIC(n_indices * stride * sizeof(GLfloat));
+  int64_t i;
+  for (i=0; i<n_indices; i++)
+    memcpy(result + i * stride, array + (int64_t)index[i] * stride, stride * sizeof(GLfloat));
+  return result;
+}
+
+static GLfloat *group_corners(group_t *group)
+{
+  list_t *array = group->pool ? group->pool->array : group->array;
+  return corners(get_gluint(group->vertex_index), group->vertex_index->size, get_glfloat(array), group->stride);
+}
+
+static int first_use_order(const GLuint *index, int64_t n_indices)
+{
+  int64_t next = 0;
+  int64_t i;
+  for (i=0; i<n_indices; i++) {
+    if (index[i] > next)
+      return 0;
+    if (index[i] == next)
+      next++;
+  };
+  return 1;
+}
+
+static void *test_setup_vertex_fetch(const MunitParameter params[], void *user_data)
+{
+  set_vertex_cache_optimization(0);
+  set_vertex_fetch_optimization(0);
+  set_parser_cache(0);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_vertex_fetch(void *fixture)
+{
+  set_vertex_cache_optimization(0);
+  set_vertex_fetch_optimization(0);
+  set_parser_shared_vertices(0);
+  test_teardown_gc(fixture);
+}
+
+static MunitResult test_sequential_overhead(const MunitParameter params[], void *data)
+{
+  GLuint index[] = {0, 1, 2, 3, 4, 5};
+  munit_assert_double(vertex_fetch_overhead(index, 6, 8), ==, 1.0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_scattered_overhead(const MunitParameter params[], void *data)
+{
+  GLuint index[] = {0, 100, 200, 300, 400, 500};
+  munit_assert_double(vertex_fetch_overhead(index, 6, 8), ==, 2.0);
+  munit_assert_double(vertex_fetch_overhead(NULL, 0, 8), ==, 0.0);
+  return MUNIT_OK;
+}
+
+static MunitResult test_renumber(const MunitParameter params[], void *data)
+{
+  GLuint index[] = {3, 1, 2, 2, 1, 3};
+  GLfloat array[] = {0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3};
+  munit_assert_int(optimize_vertex_fetch(index, 6, array, 4, 3), ==, 3);
+  GLuint expected_index[] = {0, 1, 2, 2, 1, 0};
+  GLfloat expected_array[] = {3, 3, 3, 1, 1, 1, 2, 2, 2};
+  munit_assert_memory_equal(sizeof(expected_index), index, expected_index);
+  munit_assert_memory_equal(sizeof(expected_array), array, expected_array);
+  return MUNIT_OK;
+}
+
+static MunitResult test_group(const MunitParameter params[], void *data)
+{
+  set_vertex_cache_optimization(1);
+  group_t *group = get_pointer(parse_string(grid_text("grid"))->group)[0];
+  GLfloat *expected = group_corners(group);
+  int64_t size = group->array->size;
+  double before = vertex_fetch_overhead(get_gluint(group->vertex_index), group->vertex_index->size, group->stride);
+  optimize_group_vertex_fetch(group);
+  munit_assert_int(group->array->size, ==, size);
+  munit_assert_true(first_use_order(get_gluint(group->vertex_index), group->vertex_index->size));
+  munit_assert_memory_equal(group->vertex_index->size * group->stride * sizeof(GLfloat), group_corners(group),
+                            expected);
+  double after = vertex_fetch_overhead(get_gluint(group->vertex_index), group->vertex_index->size, group->stride);
+  munit_assert_double(after, <, before);
+  return MUNIT_OK;
+}
+
+static MunitResult test_pool(const MunitParameter params[], void *data)
+{
+  set_parser_shared_vertices(1);
+  set_vertex_cache_optimization(1);
+  char *text = GC_MALLOC_ATOMIC(2 * strlen(grid_text("a")) + 1);
+  strcpy(text, grid_text("a"));
+  strcat(text, "g b\nf 3/3 2/2 1/1\n");
+  object_t *object = parse_string(text);
+  munit_assert_int(object->pool->size, ==, 1);
+  group_t *a = get_pointer(object->group)[0];
+  group_t *b = get_pointer(object->group)[1];
+  GLfloat *expected_a = group_corners(a);
+  GLfloat *expected_b = group_corners(b);
+  optimize_pool_vertex_fetch(object, a->pool);
+  munit_assert_true(first_use_order(get_gluint(a->vertex_index), a->vertex_index->size));
+  munit_assert_memory_equal(a->vertex_index->size * a->stride * sizeof(GLfloat), group_corners(a), expected_a);
+  munit_assert_memory_equal(b->vertex_index->size * b->stride * sizeof(GLfloat), group_corners(b), expected_b);
+  return MUNIT_OK;
+}
+
+static MunitResult test_parser(const MunitParameter params[], void *data)
+{
+  set_vertex_cache_optimization(1);
+  set_vertex_fetch_optimization(1);
+  group_t *group = get_pointer(parse_string(grid_text("grid"))->group)[0];
+  munit_assert_true(first_use_order(get_gluint(group->vertex_index), group->vertex_index->size));
+  munit_assert_int(group->array->size, ==, (GRID + 1) * (GRID + 1) * group->stride);
+  set_parser_shared_vertices(1);
+  object_t *object = parse_string(grid_text("grid"));
+  group = get_pointer(object->group)[0];
+  munit_assert_true(first_use_order(get_gluint(group->vertex_index), group->vertex_index->size));
+  munit_assert_double(object_vertex_fetch_overhead(object), <, 1.5);
+  return MUNIT_OK;
+}
+
+static MunitResult test_cache(const MunitParameter params[], void *data)
+{
+  char file_name[] = "/tmp/fsim-vertex-fetch-XXXXXX";
+  int fd = mkstemp(file_name);
+  munit_assert_int(fd, >=, 0);
+  char *text = grid_text("grid");
+  munit_assert_int(write(fd, text, strlen(text)), ==, strlen(text));
+  close(fd);
+  set_vertex_cache_optimization(1);
+  munit_assert_int(write_object_cache(file_name, parse_file(file_name), make_list()), ==, 0);
+  group_t *group = get_pointer(read_object_cache(file_name)->group)[0];
+  munit_assert_false(first_use_order(get_gluint(group->vertex_index), group->vertex_index->size));
+  set_vertex_fetch_optimization(1);
+  group = get_pointer(read_object_cache(file_name)->group)[0];
+  munit_assert_true(first_use_order(get_gluint(group->vertex_index), group->vertex_index->size));
+  unlink(object_cache_file_name(file_name));
+  unlink(file_name);
+  return MUNIT_OK;
+}
+
+MunitTest test_vertex_fetch[] = {
+  {"/sequential_overhead", test_sequential_overhead, test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/scattered_overhead" , test_scattered_overhead , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/renumber"           , test_renumber           , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/group"              , test_group              , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/pool"               , test_pool               , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/parser"             , test_parser             , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/cache"              , test_cache              , test_setup_vertex_fetch, test_teardown_vertex_fetch, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL                  , NULL                    , NULL                   , NULL                      , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,160 @@
+#include <math.h>
+#include <stdlib.h>
+#include "fsim/memory.h"
+#include "fsim/vertex_format.h"
+#include "test_vertex_format.h"
+#include "test_helper.h"
+
+
+#define N_VERTICES 1000
+
+// Vertices with positions in a box of size 20 x 4 x 1, texture coordinates in the unit square and unit normals.
+static GLfloat *random_vertices(void)
+{
+  GLfloat *result = GC_MALLOC_ATOMIC(N_VERTICES * 8 * sizeof(GLfloat));
+  srand(42);
+  int i;
+  for (i=0; i<N_VERTICES; i++) {
+    GLfloat *vertex = result + 8 * i;
+    vertex[0] = -10 + 20.0f * rand() / RAND_MAX;
+    vertex[1] = 100 + 4.0f * rand() / RAND_MAX;
+    vertex[2] = 1.0f * rand() / RAND_MAX;
+    vertex[3] = 1.0f * rand() / RAND_MAX;
+    vertex[4] = 1.0f * rand() / RAND_MAX;
+    double theta = M_PI * rand() / RAND_MAX;
+    double phi = 2 * M_PI * rand() / RAND_MAX;
+    vertex[5] = sin(theta) * cos(phi);
+    vertex[6] = sin(theta) * sin(phi);
+    vertex[7] = cos(theta);
+  };
+  return result;
+}
+
+static void *test_setup_vertex_format(const MunitParameter params[], void *user_data)
+{
+  set_vertex_format(VERTEX_FORMAT_FLOAT);
+  return test_setup_gc(params, user_data);
+}
+
+static void test_teardown_vertex_format(void *fixture)
+{
+  set_vertex_format(VERTEX_FORMAT_FLOAT);
+  test_teardown_gc(fixture);
+}
+
+static MunitResult test_default_format(const MunitParameter params[], void *data)
+{
+  munit_assert_int(get_vertex_format(), ==, VERTEX_FORMAT_FLOAT);
+  set_vertex_format(VERTEX_FORMAT_COMPACT);
+  munit_assert_int(get_vertex_format(), ==, VERTEX_FORMAT_COMPACT);
+  return MUNIT_OK;
+}
+
+static MunitResult test_size(const MunitParameter params[], void *data)
+{
+  munit_assert_int(vertex_format_size(VERTEX_FORMAT_FLOAT, 8), ==, 32);
+  munit_assert_int(vertex_format_size(VERTEX_FORMAT_COMPACT, 3), ==, 8);
+  munit_assert_int(vertex_format_size(VERTEX_FORMAT_COMPACT, 5), ==, 12);
+  munit_assert_int(vertex_format_size(VERTEX_FORMAT_COMPACT, 6), ==, 12);
+  munit_assert_int(vertex_format_size(VERTEX_FORMAT_COMPACT, 8), ==, 16);
+  return MUNIT_OK;
+}
+
+static MunitResult test_half_exact(const MunitParameter params[], void *data)
+{
+  munit_assert_int(float_to_half(0.0f), ==, 0x0000);
+  munit_assert_int(float_to_half(1.0f), ==, 0x3c00);
+  munit_assert_int(float_to_half(-2.0f), ==, 0xc000);
+  munit_assert_int(float_to_half(65504.0f), ==, 0x7bff);
+  munit_assert_float(half_to_float(0x3c00), ==, 1.0f);
+  munit_assert_float(half_to_float(0x3800), ==, 0.5f);
+  munit_assert_float(half_to_float(0x7bff), ==, 65504.0f);
+  munit_assert_float(half_to_float(0x0001), ==, ldexpf(1.0f, -24));
+  munit_assert_float(half_to_float(float_to_half(ldexpf(3.0f, -20))), ==, ldexpf(3.0f, -20));
+  return MUNIT_OK;
+}
+
+static MunitResult test_half_rounding(const MunitParameter params[], void *data)
+{
+  munit_assert_int(float_to_half(1.0f + ldexpf(1.0f, -11)), ==, 0x3c00);
+  munit_assert_int(float_to_half(1.0f + 3 * ldexpf(1.0f, -11)), ==, 0x3c02);
+  munit_assert_int(float_to_half(1.0f + ldexpf(1.0f, -11) + ldexpf(1.0f, -20)), ==, 0x3c01);
+  munit_assert_int(float_to_half(1e6f), ==, 0x7c00);
+  munit_assert_int(float_to_half(1e-9f), ==, 0x0000);
+  munit_assert_float(fabsf(half_to_float(float_to_half(1.0f / 3)) - 1.0f / 3), <=, ldexpf(1.0f, -13));
+  return MUNIT_OK;
+}
+
+static MunitResult test_pack_normal(const MunitParameter params[], void *data)
+{
+  GLfloat normal[3] = {1, 0, -1};
+  munit_assert_int(pack_normal(normal), ==, 0x1ff | 0x201 << 20);
+  GLfloat result[3];
+  unpack_normal(pack_normal(normal), result);
+  munit_assert_float(result[0], ==, 1.0f);
+  munit_assert_float(result[1], ==, 0.0f);
+  munit_assert_float(result[2], ==, -1.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_bounds(const MunitParameter params[], void *data)
+{
+  GLfloat array[] = {1, 2, 3, 0, 0, -1, 6, 3, 0, 0};
+  GLfloat offset[3];
+  GLfloat scale[3];
+  vertex_format_bounds(array, 2, 5, offset, scale);
+  munit_assert_float(offset[0], ==, -1.0f);
+  munit_assert_float(offset[1], ==, 2.0f);
+  munit_assert_float(offset[2], ==, 3.0f);
+  munit_assert_float(scale[0], ==, 2.0f);
+  munit_assert_float(scale[1], ==, 4.0f);
+  munit_assert_float(scale[2], ==, 0.0f);
+  return MUNIT_OK;
+}
+
+static MunitResult test_round_trip(const MunitParameter params[], void *data)
+{
+  GLfloat array[] = {1, 2, 3, 0.25f, 0.75f, 0, 0, 1, -1, 6, 3, 1.5f, -2.0f, 1, 0, 0};
+  GLfloat offset[3];
+  GLfloat scale[3];
+  vertex_format_bounds(array, 2, 8, offset, scale);
+  void *packed = pack_vertices(array, 2, 8, offset, scale);
+  GLfloat *result = unpack_vertices(packed, 2, 8, offset, scale);
+  munit_assert_memory_equal(sizeof(array), result, array);
+  return MUNIT_OK;
+}
+
+static MunitResult test_error_bound(const MunitParameter params[], void *data)
+{
+  vertex_format_error_t error = vertex_format_error(random_vertices(), N_VERTICES, 8);
+  // Half of a quantization step of 20 / 65535 plus rounding of the float computations.
+  munit_assert_double(error.position, >, 0);
+  munit_assert_double(error.position, <=, 0.5 * 20 / 65535 + 1e-5);
+  munit_assert_double(error.texcoord, >, 0);
+  munit_assert_double(error.texcoord, <=, ldexpf(1.0f, -12));
+  // Each component is off by at most half a step of 1 / 511.
+  munit_assert_double(error.normal, >, 0);
+  munit_assert_double(error.normal, <=, sqrt(3) * 0.5 / 511);
+  return MUNIT_OK;
+}
+
+static MunitResult test_flat_box(const MunitParameter params[], void *data)
+{
+  GLfloat array[] = {1, 2, 3, 1, 8, 3};
+  vertex_format_error_t error = vertex_format_error(array, 2, 3);
+  munit_assert_double(error.position, ==, 0.0);
+  return MUNIT_OK;
+}
+
+MunitTest test_vertex_format[] = {
+  {"/default_format", test_default_format, test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/size"          , test_size          , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/half_exact"    , test_half_exact    , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/half_rounding" , test_half_rounding , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/pack_normal"   , test_pack_normal   , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/bounds"        , test_bounds        , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/round_trip"    , test_round_trip    , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/error_bound"   , test_error_bound   , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {"/flat_box"      , test_flat_box      , test_setup_vertex_format, test_teardown_vertex_format, MUNIT_TEST_OPTION_NONE, NULL},
+  {NULL             , NULL               , NULL                    , NULL                       , MUNIT_TEST_OPTION_NONE, NULL}
+};
@@ -0,0 +1,11 @@
+#version 130
+in mediump vec3 point;
+in mediump vec3 vector;
+uniform vec3 point_offset;
+uniform vec3 point_scale;
+out mediump vec3 normal;
+void main()
+{
+  gl_Position = vec4(point_offset + point * point_scale, 1);
+  normal = vector;
+}
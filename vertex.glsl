@@ -6,6 +6,8 @@ uniform mat4 yaw;
 uniform mat4 pitch;
 uniform mat4 translation;
 uniform mat4 projection;
+uniform vec3 point_offset;
+uniform vec3 point_scale;
 uniform vec3 ray;
 uniform vec3 ambient;
 uniform vec3 diffuse;
@@ -22,9 +24,10 @@ flat out mediump float Ns;
 void main()
 {
   mat4 model = translation * yaw * pitch;
-  gl_Position = projection * model * vec4(point, 1);
+  vec3 position = point_offset + point * point_scale;
+  gl_Position = projection * model * vec4(position, 1);
   UV = texcoord;
-  direction = (model * vec4(point, 1)).xyz;
+  direction = (model * vec4(position, 1)).xyz;
   normal = (model * vec4(vector, 0)).xyz;
   light = ray;
   Ka = ambient;